@@ -314,6 +314,101 @@ SAPI_EXPORT void quasar_signal_data_ready(quasar_ext_handle handle, const char*
 */
 SAPI_EXPORT void quasar_signal_wait_processed(quasar_ext_handle handle, const char* source);
 
+//! Subscribes to a topic of another extension
+/*! The callback is invoked with every value of the topic, as soon as its extension retrieves it,
+    on the thread that retrieved it. The value is not copied, and is only valid until the callback returns.
+    Values are delivered as the extension returned them, without the quantization configured for widgets.
+    The topic's Data Source keeps running while it has subscriptions, like it does for widgets.
+
+    Only timer based and signaled Data Sources can be subscribed to. A subscription is rejected if it would
+    create a dependency cycle between extensions, such as an extension subscribing to one of its own topics.
+    Subscriptions made in \ref quasar_ext_info_t.init are active once all extensions are loaded.
+
+    The callback must return promptly, and must not subscribe or unsubscribe.
+
+    \param[in]  handle      Extension handle
+    \param[in]  topic       Topic identifier, such as \c pulse_viz/band
+    \param[in]  callback    Function invoked with each value
+    \param[in]  userdata    Passed to callback
+    \return Subscription identifier if successful, 0 otherwise
+    \sa quasar_unsubscribe_topic(), quasar_topic_callback_t
+*/
+SAPI_EXPORT size_t quasar_subscribe_topic(quasar_ext_handle handle, const char* topic, quasar_topic_callback_t callback, void* userdata);
+
+//! Removes a subscription to a topic
+/*! Once this function returns, the subscription's callback is no longer invoked.
+    Subscriptions that are not removed are removed when the extension is unloaded.
+
+    \param[in]  handle          Extension handle
+    \param[in]  subscription    Identifier returned by \ref quasar_subscribe_topic()
+*/
+SAPI_EXPORT void quasar_unsubscribe_topic(quasar_ext_handle handle, size_t subscription);
+
+//! Gets the type of a subscribed value
+/*! \param[in]  value   Value handle
+    \return Type of the value, \ref QUASAR_VALUE_NULL if the handle is null
+*/
+SAPI_EXPORT quasar_value_type_t quasar_get_value_type(quasar_value_handle value);
+
+//! Gets a bool value
+/*! \param[in]  value   Value handle
+    \param[in]  buf     Buffer to copy results to
+    \return true if successful, false otherwise
+*/
+SAPI_EXPORT bool quasar_get_value_bool(quasar_value_handle value, bool* buf);
+
+//! Gets an integer value, numbers are converted
+/*! \param[in]  value   Value handle
+    \param[in]  buf     Buffer to copy results to
+    \return true if successful, false otherwise
+*/
+SAPI_EXPORT bool quasar_get_value_int(quasar_value_handle value, intmax_t* buf);
+
+//! Gets a double value, numbers are converted
+/*! \param[in]  value   Value handle
+    \param[in]  buf     Buffer to copy results to
+    \return true if successful, false otherwise
+*/
+SAPI_EXPORT bool quasar_get_value_double(quasar_value_handle value, double* buf);
+
+//! Gets a string value
+/*! \param[in]  value   Value handle
+    \param[in]  buf     Buffer to copy results to
+    \param[in]  size    Size of buffer
+    \return true if successful, false otherwise
+*/
+SAPI_EXPORT bool quasar_get_value_string(quasar_value_handle value, char* buf, size_t size);
+
+//! Gets the numbers of an array value
+/*! Elements that are not numbers are copied as NaN.
+
+    \param[in]  value   Value handle
+    \param[in]  buf     Buffer to copy results to
+    \param[in]  size    Number of elements of buffer
+    \return Number of elements copied, 0 if the value is not an array
+*/
+SAPI_EXPORT size_t quasar_get_value_double_array(quasar_value_handle value, double* buf, size_t size);
+
+//! Gets the number of elements of an array value, or of members of an object value
+/*! \param[in]  value   Value handle
+    \return Number of elements or members, 0 for other types
+*/
+SAPI_EXPORT size_t quasar_get_value_size(quasar_value_handle value);
+
+//! Gets an element of an array value
+/*! \param[in]  value   Value handle
+    \param[in]  index   Element index
+    \return Value handle of the element if successful, nullptr otherwise
+*/
+SAPI_EXPORT quasar_value_handle quasar_get_value_element(quasar_value_handle value, size_t index);
+
+//! Gets a member of an object value
+/*! \param[in]  value   Value handle
+    \param[in]  name    Member name
+    \return Value handle of the member if successful, nullptr otherwise
+*/
+SAPI_EXPORT quasar_value_handle quasar_get_value_member(quasar_value_handle value, const char* name);
+
 //! Stores a string type data
 /*! \param[in]  handle  Extension handle
     \param[in]  name    Data name
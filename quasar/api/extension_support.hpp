@@ -17,6 +17,7 @@
 #if defined(__cplusplus)
 
 #  include <string>
+#  include <string_view>
 #  include <vector>
 
 //! Sets the return data to be a null terminated string
@@ -79,4 +80,33 @@ SAPI_EXPORT std::string_view quasar_get_string_setting_hpp(quasar_ext_handle han
 */
 SAPI_EXPORT std::string_view quasar_get_selection_setting_hpp(quasar_ext_handle handle, quasar_settings_t* settings, std::string_view name);
 
+//! Subscribes to a topic of another extension
+/*! \param[in]  handle      Extension handle
+    \param[in]  topic       Topic identifier
+    \param[in]  callback    Function invoked with each value
+    \param[in]  userdata    Passed to callback
+    \return Subscription identifier if successful, 0 otherwise
+    \sa quasar_subscribe_topic()
+*/
+SAPI_EXPORT size_t quasar_subscribe_topic_hpp(quasar_ext_handle handle, std::string_view topic, quasar_topic_callback_t callback, void* userdata);
+
+//! Gets a string value without copying it
+/*! \param[in]  value   Value handle
+    \return string value if successful, empty string_view otherwise. Only valid for the duration of the callback.
+*/
+SAPI_EXPORT std::string_view quasar_get_value_string_hpp(quasar_value_handle value);
+
+//! Gets a member of an object value
+/*! \param[in]  value   Value handle
+    \param[in]  name    Member name
+    \return Value handle of the member if successful, nullptr otherwise
+*/
+SAPI_EXPORT quasar_value_handle quasar_get_value_member_hpp(quasar_value_handle value, std::string_view name);
+
+//! Serializes a value to JSON
+/*! \param[in]  value   Value handle
+    \return JSON string, empty if the handle is null
+*/
+SAPI_EXPORT std::string quasar_get_value_json_hpp(quasar_value_handle value);
+
 #endif
@@ -42,6 +42,20 @@ enum quasar_polling_type_t
     QUASAR_POLLING_CLIENT   = 0    //!< Data is polled on-demand by the client
 };
 
+//! Defines the types of values delivered to topic subscriptions.
+/*! \sa quasar_get_value_type()
+*/
+enum quasar_value_type_t
+{
+    QUASAR_VALUE_NULL,    //!< Null or missing value.
+    QUASAR_VALUE_BOOL,    //!< Boolean.
+    QUASAR_VALUE_INT,     //!< Integer.
+    QUASAR_VALUE_DOUBLE,  //!< Floating point number.
+    QUASAR_VALUE_STRING,  //!< String.
+    QUASAR_VALUE_ARRAY,   //!< Array of values.
+    QUASAR_VALUE_OBJECT   //!< Object of named values.
+};
+
 //! Handle for creating and storing extension settings.
 /*! This handle is opaque to the front facing API.
     \sa extension_support.h
@@ -63,6 +77,18 @@ typedef void* quasar_ext_handle;
 /*! \sa extension_support.h, quasar_ext_info_t.get_data */
 typedef void* quasar_data_handle;
 
+//! Handle to a value delivered to a topic subscription.
+/*! This handle is opaque to the front facing API, and only valid for the duration of the callback it is passed to.
+    \sa extension_support.h, quasar_subscribe_topic()
+*/
+typedef const void* quasar_value_handle;
+
+//! Function pointer type for topic subscription callbacks.
+/*! Arguments are the topic, its value and the userdata given to \ref quasar_subscribe_topic().
+    \sa quasar_subscribe_topic()
+*/
+typedef void (*quasar_topic_callback_t)(const char*, quasar_value_handle, void*);
+
 //! Function pointer type for the \ref quasar_ext_info_t.init and \ref quasar_ext_info_t.shutdown functions.
 /*! \sa quasar_ext_info_t.init, quasar_ext_info_t.shutdown */
 typedef bool (*ext_info_call_t)(quasar_ext_handle);
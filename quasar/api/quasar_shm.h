@@ -0,0 +1,395 @@
+/*! \file
+    \brief Shared memory topic reader
+
+    Header only C library for reading the Data Sources that Quasar mirrors to shared memory.
+    Data Sources are mirrored when **Mirror to shared memory** is enabled in the extension's
+    **Data Sources** settings page.
+
+    The region holds one slot per mirrored topic. Each slot holds the latest payload of its topic,
+    and is protected by a sequence lock: the sequence number is odd while Quasar writes the slot,
+    and changes with every write. Readers never block Quasar and never make system calls after
+    opening the region, and can read payloads in place:
+
+    \code{.c}
+    quasar_shm_reader_t reader;
+
+    if (quasar_shm_open(&reader, NULL) == 0)
+    {
+        const quasar_shm_slot_t* slot = quasar_shm_find(&reader, "win_audio_viz/band");
+        uint64_t                 seq;
+
+        do
+        {
+            seq = quasar_shm_begin(slot);
+            // Use quasar_shm_payload(slot) and slot->length, the data may be torn until validated
+        } while (quasar_shm_retry(slot, seq));
+
+        quasar_shm_close(&reader);
+    }
+    \endcode
+*/
+
+#pragma once
+
+#if defined(__cplusplus)
+#  include <cstddef>
+#  include <cstdint>
+#  include <cstdio>
+#  include <cstring>
+#else
+#  include <stddef.h>
+#  include <stdint.h>
+#  include <stdio.h>
+#  include <string.h>
+#endif
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#  include <intrin.h>
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+//! Magic number identifying an initialized region ("QSHM")
+#define QUASAR_SHM_MAGIC       0x4D485351u
+
+//! Layout version of the region
+#define QUASAR_SHM_VERSION     1
+
+//! Size of the region header, slots start at this offset
+#define QUASAR_SHM_HEADER_SIZE 64
+
+//! Size of a slot header, payloads start at this offset within their slot
+#define QUASAR_SHM_SLOT_HEADER 128
+
+//! Maximum topic length, including the null terminator
+#define QUASAR_SHM_TOPIC_SIZE  96
+
+//! Defines the formats of slot payloads
+enum quasar_shm_format_t
+{
+    QUASAR_SHM_EMPTY    = 0,  //!< No payload has been written
+    QUASAR_SHM_JSON     = 1,  //!< UTF-8 JSON of the topic's data, not null terminated
+    QUASAR_SHM_F64      = 2,  //!< Array of doubles, for topics whose data is an array of numbers
+    QUASAR_SHM_OVERSIZE = 3   //!< The latest payload did not fit in the slot
+};
+
+//! Header at the start of the region
+typedef struct quasar_shm_header_t
+{
+    uint32_t magic;       //!< \ref QUASAR_SHM_MAGIC once the region is initialized
+    uint32_t version;     //!< \ref QUASAR_SHM_VERSION
+    uint32_t slot_count;  //!< Number of slots in the region
+    uint32_t slot_size;   //!< Size of each slot in bytes, including its header
+    uint32_t slots_used;  //!< Number of slots assigned to topics, only ever grows
+    uint32_t owner_pid;   //!< Process id of the Quasar instance writing the region
+} quasar_shm_header_t;
+
+//! Header of a topic slot
+typedef struct quasar_shm_slot_t
+{
+    uint64_t seq;                           //!< Sequence number, odd while the slot is written
+    uint64_t timestamp;                     //!< Time of the latest write, in milliseconds since the Unix epoch
+    uint32_t format;                        //!< Payload format \sa quasar_shm_format_t
+    uint32_t length;                        //!< Payload size in bytes
+    char     topic[QUASAR_SHM_TOPIC_SIZE];  //!< Topic of the slot, set once before the slot is counted in slots_used
+} quasar_shm_slot_t;
+
+//! Reader handle
+typedef struct quasar_shm_reader_t
+{
+    const quasar_shm_header_t* header;  //!< Mapped region
+    size_t                     size;    //!< Size of the mapping
+#if defined(_WIN32)
+    HANDLE mapping;
+#endif
+} quasar_shm_reader_t;
+
+// Memory ordering primitives
+#if defined(_MSC_VER) && !defined(__clang__)
+static inline uint64_t quasar_shm_load_acquire64(const uint64_t* p)
+{
+    uint64_t v = *(const volatile uint64_t*) p;
+#  if defined(_M_ARM64)
+    __dmb(_ARM64_BARRIER_ISH);
+#  else
+    _ReadWriteBarrier();
+#  endif
+    return v;
+}
+
+static inline uint32_t quasar_shm_load_acquire32(const uint32_t* p)
+{
+    uint32_t v = *(const volatile uint32_t*) p;
+#  if defined(_M_ARM64)
+    __dmb(_ARM64_BARRIER_ISH);
+#  else
+    _ReadWriteBarrier();
+#  endif
+    return v;
+}
+
+static inline void quasar_shm_fence_acquire(void)
+{
+#  if defined(_M_ARM64)
+    __dmb(_ARM64_BARRIER_ISH);
+#  else
+    _ReadWriteBarrier();
+#  endif
+}
+#else
+static inline uint64_t quasar_shm_load_acquire64(const uint64_t* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline uint32_t quasar_shm_load_acquire32(const uint32_t* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void quasar_shm_fence_acquire(void)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+#endif
+
+//! Writes the name of the region a Quasar instance creates for the current user
+/*! Instances started with \c --profile \c name are named \c quasar-name.
+
+    \param[out] buf     Destination buffer
+    \param[in]  size    Size of buf
+    \param[in]  app     Instance name, or NULL for the default instance
+*/
+static inline void quasar_shm_name(char* buf, size_t size, const char* app)
+{
+    if (!app || !*app)
+    {
+        app = "quasar";
+    }
+
+#if defined(_WIN32)
+    snprintf(buf, size, "Local\\%s-topics", app);
+#else
+    snprintf(buf, size, "/%s-topics-%u", app, (unsigned) getuid());
+#endif
+}
+
+//! Writes the name of the region the default Quasar instance creates for the current user
+/*! \param[out] buf     Destination buffer
+    \param[in]  size    Size of buf
+*/
+static inline void quasar_shm_default_name(char* buf, size_t size)
+{
+    quasar_shm_name(buf, size, NULL);
+}
+
+//! Opens the region read-only
+/*! \param[out] reader  Reader handle
+    \param[in]  name    Region name, or NULL for the default \sa quasar_shm_default_name()
+    \return 0 if successful, -1 if the region does not exist or is not initialized
+*/
+static inline int quasar_shm_open(quasar_shm_reader_t* reader, const char* name)
+{
+    char defname[64];
+
+    if (!name)
+    {
+        quasar_shm_default_name(defname, sizeof(defname));
+        name = defname;
+    }
+
+    memset(reader, 0, sizeof(*reader));
+
+#if defined(_WIN32)
+    reader->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+
+    if (!reader->mapping)
+    {
+        return -1;
+    }
+
+    reader->header = (const quasar_shm_header_t*) MapViewOfFile(reader->mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (!reader->header)
+    {
+        CloseHandle(reader->mapping);
+        return -1;
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(reader->header, &info, sizeof(info));
+    reader->size = info.RegionSize;
+#else
+    int fd = shm_open(name, O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < QUASAR_SHM_HEADER_SIZE)
+    {
+        close(fd);
+        return -1;
+    }
+
+    void* base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        return -1;
+    }
+
+    reader->header = (const quasar_shm_header_t*) base;
+    reader->size   = (size_t) st.st_size;
+#endif
+
+    const quasar_shm_header_t* h = reader->header;
+
+    if (quasar_shm_load_acquire32(&h->magic) != QUASAR_SHM_MAGIC || h->version != QUASAR_SHM_VERSION
+        || QUASAR_SHM_HEADER_SIZE + (size_t) h->slot_count * h->slot_size > reader->size)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(reader->header);
+        CloseHandle(reader->mapping);
+#else
+        munmap((void*) reader->header, reader->size);
+#endif
+        memset(reader, 0, sizeof(*reader));
+        return -1;
+    }
+
+    return 0;
+}
+
+//! Closes the region
+static inline void quasar_shm_close(quasar_shm_reader_t* reader)
+{
+    if (!reader->header)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(reader->header);
+    CloseHandle(reader->mapping);
+#else
+    munmap((void*) reader->header, reader->size);
+#endif
+
+    memset(reader, 0, sizeof(*reader));
+}
+
+//! Returns a slot by index
+static inline const quasar_shm_slot_t* quasar_shm_slot(const quasar_shm_reader_t* reader, uint32_t index)
+{
+    return (const quasar_shm_slot_t*) ((const char*) reader->header + QUASAR_SHM_HEADER_SIZE + (size_t) index * reader->header->slot_size);
+}
+
+//! Number of slots assigned to topics
+static inline uint32_t quasar_shm_count(const quasar_shm_reader_t* reader)
+{
+    return quasar_shm_load_acquire32(&reader->header->slots_used);
+}
+
+//! Finds the slot of a topic
+/*! Topics are assigned a slot when they are first mirrored, and keep it until Quasar exits.
+    \return Slot, or NULL if the topic is not mirrored
+*/
+static inline const quasar_shm_slot_t* quasar_shm_find(const quasar_shm_reader_t* reader, const char* topic)
+{
+    const uint32_t count = quasar_shm_count(reader);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const quasar_shm_slot_t* slot = quasar_shm_slot(reader, i);
+
+        if (strncmp(slot->topic, topic, QUASAR_SHM_TOPIC_SIZE) == 0)
+        {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+//! Payload of a slot, only valid until quasar_shm_retry() succeeds
+static inline const void* quasar_shm_payload(const quasar_shm_slot_t* slot)
+{
+    return (const char*) slot + QUASAR_SHM_SLOT_HEADER;
+}
+
+//! Starts reading a slot, waiting for any write in progress to finish
+/*! \return Sequence number to pass to quasar_shm_retry()
+*/
+static inline uint64_t quasar_shm_begin(const quasar_shm_slot_t* slot)
+{
+    uint64_t seq;
+
+    while ((seq = quasar_shm_load_acquire64(&slot->seq)) & 1)
+    {}
+
+    return seq;
+}
+
+//! Finishes reading a slot
+/*! \param[in]  seq     Sequence number returned by quasar_shm_begin()
+    \return Non-zero if the slot was written while it was read, and must be read again
+*/
+static inline int quasar_shm_retry(const quasar_shm_slot_t* slot, uint64_t seq)
+{
+    quasar_shm_fence_acquire();
+    return quasar_shm_load_acquire64(&slot->seq) != seq;
+}
+
+//! Copies a consistent snapshot of a slot's payload
+/*! \param[out] buf         Destination buffer
+    \param[in]  size        Size of buf
+    \param[out] length      Payload size in bytes
+    \param[out] format      Payload format \sa quasar_shm_format_t
+    \param[out] seq         Sequence number of the snapshot, which changes when the topic is updated. May be NULL.
+    \return 0 if successful, -1 if buf is too small for the payload
+*/
+static inline int quasar_shm_read(const quasar_shm_slot_t* slot, void* buf, size_t size, uint32_t* length, uint32_t* format, uint64_t* seq)
+{
+    uint64_t s;
+    int      ok;
+
+    do
+    {
+        s       = quasar_shm_begin(slot);
+        *length = slot->length;
+        *format = slot->format;
+        ok      = *length <= size;
+
+        if (ok)
+        {
+            memcpy(buf, quasar_shm_payload(slot), *length);
+        }
+    } while (quasar_shm_retry(slot, s));
+
+    if (seq)
+    {
+        *seq = s;
+    }
+
+    return ok ? 0 : -1;
+}
+
+#if defined(__cplusplus)
+}
+#endif
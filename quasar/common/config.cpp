@@ -23,6 +23,16 @@ void Config::ReadInteralSettings()
     ReadSetting(Settings::internal.log_level);
     ReadSetting(Settings::internal.port);
     ReadSetting(Settings::internal.auth);
+    ReadSetting(Settings::internal.compression);
+    ReadSetting(Settings::internal.process_model);
+    ReadSetting(Settings::internal.renderer_limit);
+    ReadSetting(Settings::internal.cpu_budget);
+    ReadSetting(Settings::internal.memory_budget);
+    ReadSetting(Settings::internal.local_transport);
+    ReadSetting(Settings::internal.local_socket);
+    ReadSetting(Settings::internal.relay_upstreams);
+    ReadSetting(Settings::internal.derived_topics);
+    ReadSetting(Settings::internal.api_token);
     ReadSetting(Settings::internal.cookies);
     ReadSetting(Settings::internal.loaded_widgets);
     ReadSetting(Settings::internal.lastpath);
@@ -75,8 +85,20 @@ void Config::ReadDataSourceSetting(Settings::DataSourceSettings* settings)
     Settings::DataSourceSettings cpy   = *settings;
 
     cfg->beginGroup(qname);
-    settings->enabled = cfg->value("enabled", cpy.enabled).toBool();
-    settings->rate    = cfg->value("rate", QVariant::fromValue(cpy.rate)).toLongLong();
+    settings->enabled      = cfg->value("enabled", cpy.enabled).toBool();
+    settings->rate         = cfg->value("rate", QVariant::fromValue(cpy.rate)).toLongLong();
+    settings->quantization = cfg->value("quantization", cpy.quantization).toInt();
+    settings->precision    = cfg->value("precision", cpy.precision).toInt();
+    settings->onChange     = cfg->value("onchange", cpy.onChange).toBool();
+    settings->heartbeat    = cfg->value("heartbeat", QVariant::fromValue(cpy.heartbeat)).toLongLong();
+    settings->compress     = cfg->value("compress", cpy.compress).toBool();
+    settings->threshold    = cfg->value("threshold", cpy.threshold).toInt();
+    settings->priority     = cfg->value("priority", cpy.priority).toInt();
+    settings->sharedMemory = cfg->value("sharedmemory", cpy.sharedMemory).toBool();
+    settings->history      = cfg->value("history", cpy.history).toInt();
+    settings->historyAge   = cfg->value("historyage", cpy.historyAge).toInt();
+    settings->archive      = cfg->value("archive", cpy.archive).toBool();
+    settings->collect      = cfg->value("collect", cpy.collect).toBool();
     cfg->endGroup();
 }
 
@@ -87,6 +109,18 @@ void Config::WriteDataSourceSetting(Settings::DataSourceSettings* const& setting
     cfg->beginGroup(qname);
     cfg->setValue("enabled", settings->enabled);
     cfg->setValue("rate", QVariant::fromValue(settings->rate));
+    cfg->setValue("quantization", settings->quantization);
+    cfg->setValue("precision", settings->precision);
+    cfg->setValue("onchange", settings->onChange);
+    cfg->setValue("heartbeat", QVariant::fromValue(settings->heartbeat));
+    cfg->setValue("compress", settings->compress);
+    cfg->setValue("threshold", settings->threshold);
+    cfg->setValue("priority", settings->priority);
+    cfg->setValue("sharedmemory", settings->sharedMemory);
+    cfg->setValue("history", settings->history);
+    cfg->setValue("historyage", settings->historyAge);
+    cfg->setValue("archive", settings->archive);
+    cfg->setValue("collect", settings->collect);
     cfg->endGroup();
 }
 
@@ -96,6 +130,16 @@ void Config::WriteInternalSettings()
     WriteSetting(Settings::internal.log_level);
     WriteSetting(Settings::internal.port);
     WriteSetting(Settings::internal.auth);
+    WriteSetting(Settings::internal.compression);
+    WriteSetting(Settings::internal.process_model);
+    WriteSetting(Settings::internal.renderer_limit);
+    WriteSetting(Settings::internal.cpu_budget);
+    WriteSetting(Settings::internal.memory_budget);
+    WriteSetting(Settings::internal.local_transport);
+    WriteSetting(Settings::internal.local_socket);
+    WriteSetting(Settings::internal.relay_upstreams);
+    WriteSetting(Settings::internal.derived_topics);
+    WriteSetting(Settings::internal.api_token);
     WriteSetting(Settings::internal.cookies);
     WriteSetting(Settings::internal.loaded_widgets);
     WriteSetting(Settings::internal.lastpath);
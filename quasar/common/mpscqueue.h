@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+//! Unbounded lock-free multi-producer single-consumer queue
+/*! Intrusive node based queue after Dmitry Vyukov's MPSC design.
+    Any number of threads may push(), but only one thread may pop().
+
+    A push that has swapped the head but not yet linked its node is not
+    visible to pop() until the link completes, so pop() can briefly report
+    an empty queue while a push is in flight.
+
+    Popped nodes are kept for later pushes, up to \p MaxSpare of them, so a
+    queue that does not outgrow its usual length stops allocating.
+*/
+template<typename T, size_t MaxSpare = 1024>
+class MPSCQueue
+{
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        T                  value{};
+    };
+
+public:
+    MPSCQueue(const MPSCQueue&)             = delete;
+    MPSCQueue& operator= (const MPSCQueue&) = delete;
+
+    MPSCQueue() : head{&stub}, tail{&stub} {}
+
+    ~MPSCQueue()
+    {
+        while (pop())
+        {}
+
+        if (tail != &stub)
+        {
+            delete tail;
+        }
+
+        while (spare)
+        {
+            delete std::exchange(spare, spare->next.load(std::memory_order_relaxed));
+        }
+    }
+
+    //! Pushes a value to the queue. Safe to call from any thread.
+    void push(T&& value)
+    {
+        Node* node  = acquire();
+        node->value = std::move(value);
+
+        Node* prev  = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    //! Pops the oldest value from the queue. Must only be called by the consumer thread.
+    std::optional<T> pop()
+    {
+        Node* last = tail;
+        Node* next = last->next.load(std::memory_order_acquire);
+
+        if (!next)
+        {
+            return std::nullopt;
+        }
+
+        // next becomes the new placeholder once its value is moved out
+        tail = next;
+
+        std::optional<T> result{std::move(next->value)};
+
+        if (last != &stub)
+        {
+            release(last);
+        }
+
+        return result;
+    }
+
+private:
+    Node* acquire()
+    {
+        {
+            std::lock_guard<std::mutex> lk(spareMutex);
+
+            if (spare)
+            {
+                spareCount--;
+
+                Node* node = std::exchange(spare, spare->next.load(std::memory_order_relaxed));
+                node->next.store(nullptr, std::memory_order_relaxed);
+                return node;
+            }
+        }
+
+        return new Node;
+    }
+
+    void release(Node* node)
+    {
+        {
+            std::lock_guard<std::mutex> lk(spareMutex);
+
+            if (spareCount < MaxSpare)
+            {
+                spareCount++;
+
+                node->next.store(spare, std::memory_order_relaxed);
+                spare = node;
+                return;
+            }
+        }
+
+        delete node;
+    }
+
+    Node               stub{};
+    std::atomic<Node*> head;
+    Node*              tail;
+
+    std::mutex         spareMutex;     //!< Guards spare, taken by producers and the consumer
+    Node*              spare{};        //!< Popped nodes waiting for reuse, linked through next
+    size_t             spareCount = 0;
+};
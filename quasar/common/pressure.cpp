@@ -0,0 +1,200 @@
+#include "pressure.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+
+#include <QtGlobal>
+
+#include <spdlog/spdlog.h>
+
+#ifdef Q_OS_LINUX
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <unistd.h>
+
+#  include <cstring>
+#endif
+
+namespace
+{
+    constexpr auto PSI_MEMORY      = "/proc/pressure/memory";
+
+    // Stall time per window, unprivileged triggers need windows in multiples of 2s
+    constexpr auto PSI_SOME        = "some 200000 2000000";
+    constexpr auto PSI_FULL        = "full 100000 2000000";
+
+    // 10s averages escalating a trigger, in percent of stalled time
+    constexpr double SEVERE_SOME   = 25.0;
+    constexpr double CRITICAL_FULL = 10.0;
+
+    // Minimum time between reports of the same or a lower level
+    constexpr auto   REPORT_COOLDOWN = std::chrono::seconds(10);
+
+    //! Reads the 10s average of a PSI line ("some" or "full")
+    double readAverage(std::string_view kind)
+    {
+        std::ifstream file(PSI_MEMORY);
+        std::string   line;
+
+        while (std::getline(file, line))
+        {
+            if (!line.starts_with(kind))
+            {
+                continue;
+            }
+
+            auto pos = line.find("avg10=");
+
+            if (pos != std::string::npos)
+            {
+                return std::stod(line.substr(pos + 6));
+            }
+        }
+
+        return 0.0;
+    }
+
+#ifdef Q_OS_LINUX
+    int openTrigger(const char* trigger)
+    {
+        int fd = open(PSI_MEMORY, O_RDWR | O_NONBLOCK);
+
+        if (fd < 0)
+        {
+            return -1;
+        }
+
+        // The trigger must be written with its null terminator
+        if (write(fd, trigger, std::strlen(trigger) + 1) < 0)
+        {
+            SPDLOG_WARN("Failed to register PSI trigger \"{}\": {}", trigger, std::strerror(errno));
+            close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+#endif
+}  // namespace
+
+MemoryPressureMonitor::MemoryPressureMonitor(Callback&& cb) : callback{std::move(cb)}
+{
+#ifdef Q_OS_LINUX
+    someFd    = openTrigger(PSI_SOME);
+    fullFd    = openTrigger(PSI_FULL);
+    available = (someFd >= 0 and fullFd >= 0);
+#endif
+
+    if (!available)
+    {
+        SPDLOG_INFO("Memory pressure monitoring is unavailable");
+        return;
+    }
+
+    thread = std::jthread{[this](std::stop_token token) {
+        run(token);
+    }};
+
+    SPDLOG_INFO("Memory pressure monitoring started");
+}
+
+MemoryPressureMonitor::~MemoryPressureMonitor()
+{
+    if (thread.joinable())
+    {
+        thread.request_stop();
+        thread.join();
+    }
+
+#ifdef Q_OS_LINUX
+    if (someFd >= 0)
+    {
+        close(someFd);
+    }
+
+    if (fullFd >= 0)
+    {
+        close(fullFd);
+    }
+#endif
+}
+
+std::string MemoryPressureMonitor::LevelName(Level level)
+{
+    switch (level)
+    {
+        case MODERATE:
+            return "moderate";
+        case SEVERE:
+            return "severe";
+        case CRITICAL:
+            return "critical";
+    }
+
+    return "unknown";
+}
+
+void MemoryPressureMonitor::run(std::stop_token token)
+{
+#ifdef Q_OS_LINUX
+    std::array<pollfd, 2> fds{
+        {{.fd = someFd, .events = POLLPRI, .revents = 0}, {.fd = fullFd, .events = POLLPRI, .revents = 0}}
+    };
+
+    Level lastLevel{};
+    auto  lastReport = std::chrono::steady_clock::time_point{};
+
+    while (!token.stop_requested())
+    {
+        // Wake up regularly to check for stop requests
+        int n = poll(fds.data(), fds.size(), 1000);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            SPDLOG_ERROR("Memory pressure monitoring stopped: {}", std::strerror(errno));
+            return;
+        }
+
+        if (n == 0)
+        {
+            continue;
+        }
+
+        if ((fds[0].revents | fds[1].revents) & POLLERR)
+        {
+            SPDLOG_ERROR("Memory pressure monitoring stopped: trigger source is gone");
+            return;
+        }
+
+        Level level = (fds[1].revents & POLLPRI) ? SEVERE : MODERATE;
+
+        if (readAverage("full") >= CRITICAL_FULL)
+        {
+            level = CRITICAL;
+        }
+        else if (readAverage("some") >= SEVERE_SOME)
+        {
+            level = std::max(level, SEVERE);
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+
+        if (level <= lastLevel and (now - lastReport) < REPORT_COOLDOWN)
+        {
+            continue;
+        }
+
+        lastLevel  = level;
+        lastReport = now;
+
+        callback(level);
+    }
+#endif
+}
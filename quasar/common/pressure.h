@@ -0,0 +1,48 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <thread>
+
+//! Memory pressure monitor based on Linux pressure stall information (PSI)
+/*! Registers PSI triggers on /proc/pressure/memory and reports the pressure
+    level whenever one fires. The callback is invoked from the monitor thread.
+
+    Not available on other platforms, or on kernels without PSI support.
+*/
+class MemoryPressureMonitor
+{
+public:
+    //! Memory pressure levels, each implying the actions of the lower ones
+    enum Level
+    {
+        MODERATE = 1,  //!< Some tasks are stalled on memory
+        SEVERE,        //!< Tasks are frequently stalled on memory
+        CRITICAL       //!< All tasks are stalled on memory
+    };
+
+    using Callback = std::function<void(Level)>;
+
+    MemoryPressureMonitor(const MemoryPressureMonitor&)             = delete;
+    MemoryPressureMonitor& operator= (const MemoryPressureMonitor&) = delete;
+
+    MemoryPressureMonitor(Callback&& cb);
+    ~MemoryPressureMonitor();
+
+    //! Whether PSI triggers could be registered
+    bool               IsAvailable() const { return available; }
+
+    //! Name of a pressure level for logging
+    static std::string LevelName(Level level);
+
+private:
+    void         run(std::stop_token token);
+
+    Callback     callback;
+
+    int          someFd    = -1;  //!< Partial stall trigger
+    int          fullFd    = -1;  //!< Full stall trigger
+    bool         available = false;
+
+    std::jthread thread;
+};
@@ -0,0 +1,159 @@
+#include "procstat.h"
+
+#include <QtGlobal>
+
+#ifdef Q_OS_WIN
+#  include <windows.h>
+#  include <psapi.h>
+#else
+#  include <cctype>
+#  include <filesystem>
+#  include <fstream>
+#  include <sstream>
+#  include <string>
+#  include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef Q_OS_WIN
+    std::chrono::nanoseconds fromFileTime(const FILETIME& ft)
+    {
+        ULARGE_INTEGER t{.LowPart = ft.dwLowDateTime, .HighPart = ft.dwHighDateTime};
+
+        // FILETIME counts 100ns intervals
+        return std::chrono::nanoseconds{t.QuadPart * 100};
+    }
+#endif
+}  // namespace
+
+ProcStat::Sample ProcStat::Query(int64_t pid)
+{
+    Sample sample{};
+
+    if (pid <= 0)
+    {
+        return sample;
+    }
+
+#ifdef Q_OS_WIN
+    HANDLE proc = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid));
+
+    if (!proc)
+    {
+        return sample;
+    }
+
+    PROCESS_MEMORY_COUNTERS mem{};
+    FILETIME                creation, exit, kernel, user;
+
+    if (GetProcessMemoryInfo(proc, &mem, sizeof(mem)) and GetProcessTimes(proc, &creation, &exit, &kernel, &user))
+    {
+        sample.valid = true;
+        sample.rss   = mem.WorkingSetSize;
+        sample.cpu   = fromFileTime(kernel) + fromFileTime(user);
+    }
+
+    CloseHandle(proc);
+#else
+    const auto    base = "/proc/" + std::to_string(pid);
+
+    std::ifstream statm(base + "/statm");
+    std::ifstream stat(base + "/stat");
+
+    uint64_t      pages = 0, resident = 0;
+
+    if (!(statm >> pages >> resident) or !stat)
+    {
+        return sample;
+    }
+
+    // The command name may contain spaces, fields resume after its closing parenthesis
+    std::string line;
+    std::getline(stat, line);
+
+    auto pos = line.rfind(')');
+
+    if (pos == std::string::npos)
+    {
+        return sample;
+    }
+
+    std::istringstream fields(line.substr(pos + 2));
+    std::string        skip;
+    uint64_t           utime = 0, stime = 0;
+
+    // utime and stime are the 14th and 15th fields, the 3rd being the first after the name
+    for (int i = 3; i < 14; i++)
+    {
+        fields >> skip;
+    }
+
+    if (!(fields >> utime >> stime))
+    {
+        return sample;
+    }
+
+    const auto ticks = sysconf(_SC_CLK_TCK);
+
+    sample.valid     = true;
+    sample.rss       = resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    sample.cpu       = std::chrono::nanoseconds{(utime + stime) * 1'000'000'000ull / static_cast<uint64_t>(ticks)};
+#endif
+
+    return sample;
+}
+
+int64_t ProcStat::FindGpuProcess()
+{
+#ifdef Q_OS_LINUX
+    const auto self = std::to_string(getpid());
+
+    std::error_code ec;
+
+    for (auto&& entry : std::filesystem::directory_iterator("/proc", ec))
+    {
+        const auto name = entry.path().filename().string();
+
+        if (name.empty() or !std::isdigit(static_cast<unsigned char>(name[0])))
+        {
+            continue;
+        }
+
+        // The parent pid is the second field after the command name
+        std::ifstream stat(entry.path() / "stat");
+        std::string   line;
+
+        if (!std::getline(stat, line))
+        {
+            continue;
+        }
+
+        auto pos = line.rfind(')');
+
+        if (pos == std::string::npos)
+        {
+            continue;
+        }
+
+        std::istringstream fields(line.substr(pos + 2));
+        std::string        state, ppid;
+
+        if (!(fields >> state >> ppid) or ppid != self)
+        {
+            continue;
+        }
+
+        // Arguments are separated by null characters
+        std::ifstream cmdline(entry.path() / "cmdline");
+        std::string   args{std::istreambuf_iterator<char>(cmdline), std::istreambuf_iterator<char>()};
+
+        if (args.find("--type=gpu-process") != std::string::npos)
+        {
+            return std::stoll(name);
+        }
+    }
+#endif
+
+    return 0;
+}
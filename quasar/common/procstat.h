@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+//! Resource usage of other processes, e.g. web engine renderers
+namespace ProcStat
+{
+    //! Resource usage snapshot of a process
+    struct Sample
+    {
+        bool                     valid = false;  //!< Whether the process could be queried
+        uint64_t                 rss   = 0;      //!< Resident set size in bytes
+        std::chrono::nanoseconds cpu{};          //!< Total user and kernel CPU time
+    };
+
+    //! Queries the resource usage of a process
+    /*! \param[in]  pid     Process identifier
+        \return Resource usage, invalid if the process does not exist or cannot be queried
+    */
+    Sample  Query(int64_t pid);
+
+    //! Finds the web engine GPU process among the children of this process
+    //! \return Process identifier, 0 if not found or unsupported on this platform
+    int64_t FindGpuProcess();
+}  // namespace ProcStat
@@ -1,4 +1,5 @@
 #include "qutil.h"
+#include "settings.h"
 
 #include <regex>
 
@@ -48,3 +49,31 @@ std::string QUtil::ConvertPixmapToB64Image(const QPixmap& pixmap)
 
     return image;
 }
+
+void QUtil::ApplyRendererProcessModel()
+{
+    QByteArray flags;
+
+    switch (Settings::internal.process_model.GetValue())
+    {
+        case Settings::ProcessModel::process_per_site:
+            // All file:// widgets are the same site and share a renderer
+            flags = "--process-per-site";
+            break;
+        case Settings::ProcessModel::process_limit:
+            flags = "--renderer-process-limit=" + QByteArray::number(Settings::internal.renderer_limit.GetValue());
+            break;
+        default:
+            return;
+    }
+
+    // Keep flags set by the user
+    auto existing = qgetenv("QTWEBENGINE_CHROMIUM_FLAGS");
+
+    if (!existing.isEmpty())
+    {
+        flags.prepend(existing + " ");
+    }
+
+    qputenv("QTWEBENGINE_CHROMIUM_FLAGS", flags);
+}
@@ -12,4 +12,10 @@ namespace QUtil
 
     [[nodiscard]] std::tuple<QPixmap, QString> ConvertB64ImageToPixmap(const std::string& image);
     [[nodiscard]] std::string                  ConvertPixmapToB64Image(const QPixmap& pixmap);
+
+    //! Passes the configured renderer process model to Chromium
+    /*! Must be called before QtWebEngine starts, as it only reads its flags once
+        \sa Settings::ProcessModel
+    */
+    void                                       ApplyRendererProcessModel();
 }  // namespace QUtil
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+//! Fixed capacity ring buffer overwriting its oldest entries
+/*! Storage is allocated inline, so pushing never allocates.
+    Entries are indexed from the oldest to the newest.
+*/
+template<typename T, size_t N>
+class RingBuffer
+{
+    static_assert(N > 0, "RingBuffer capacity must be greater than 0");
+
+public:
+    //! Appends a value, overwriting the oldest one if full
+    void push(const T& value)
+    {
+        data[head] = value;
+        head       = (head + 1) % N;
+
+        if (count < N)
+        {
+            count++;
+        }
+    }
+
+    void             clear() { head = count = 0; }
+
+    size_t           size() const { return count; }
+
+    bool             empty() const { return count == 0; }
+
+    constexpr size_t capacity() const { return N; }
+
+    //! Entry \p i, 0 being the oldest
+    const T&         operator[] (size_t i) const { return data[(head + N - count + i) % N]; }
+
+    //! Newest entry, the buffer must not be empty
+    const T&         back() const { return (*this)[count - 1]; }
+
+private:
+    std::array<T, N> data{};
+    size_t           head  = 0;
+    size_t           count = 0;
+};
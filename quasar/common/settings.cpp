@@ -3,5 +3,6 @@
 namespace Settings
 {
     InternalSettings     internal;
+    LaunchOptions        launch;
     ExtensionSettingsMap extension;
 }  // namespace Settings
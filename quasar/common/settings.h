@@ -26,6 +26,39 @@ namespace Settings
         n_levels
     };
 
+    enum Quantization : int
+    {
+        full   = 0,  // No quantization
+        fixed  = 1,  // Fixed decimal places
+        norm16 = 2,  // 16-bit normalized range
+        norm8  = 3,  // 8-bit normalized range
+        n_quantizations
+    };
+
+    enum Compressor : int
+    {
+        no_compressor        = 0,  // permessage-deflate disabled
+        shared_compressor    = 1,  // One compressor shared by all connections
+        dedicated_compressor = 2,  // Per connection compressor with a sliding window
+        n_compressors
+    };
+
+    enum ProcessModel : int
+    {
+        default_process_model = 0,  // One renderer per widget
+        process_per_site      = 1,  // Widgets of the same site share a renderer, local widgets share one
+        process_limit         = 2,  // Renderers are capped, widgets share them beyond the cap
+        n_process_models
+    };
+
+    enum Priority : int
+    {
+        low_priority    = 0,
+        normal_priority = 1,
+        high_priority   = 2,
+        n_priorities
+    };
+
     template<typename T>
     concept IsRanged = (std::integral<T> && not std::same_as<T, bool>) || std::floating_point<T>;
 
@@ -160,6 +193,30 @@ namespace Settings
         };
         Setting<int>         port{"main/port", "WebSocket server port", 13337, 1000, 65535, 1};
         Setting<bool>        auth{"main/auth", "Allow only Quasar widgets to connect to the WebSocket server?", false};
+        SelectionSetting<int> compression{
+            "main/compression",
+            "WebSocket compression",
+            Compressor::no_compressor,
+            {{Compressor::no_compressor, "Off"},
+                    {Compressor::shared_compressor, "Shared compressor"},
+                    {Compressor::dedicated_compressor, "Dedicated compressor"}}
+        };
+        SelectionSetting<int> process_model{
+            "main/processmodel",
+            "Widget renderer processes (requires restart)",
+            ProcessModel::default_process_model,
+            {{ProcessModel::default_process_model, "One per widget"},
+                    {ProcessModel::process_per_site, "One per site"},
+                    {ProcessModel::process_limit, "Limited"}}
+        };
+        Setting<int>         renderer_limit{"main/rendererlimit", "Maximum renderer processes (requires restart)", 4, 1, 64, 1};
+        Setting<int>         cpu_budget{"main/cpubudget", "Widget CPU budget (%, 0 to disable)", 0, 0, 400, 1};
+        Setting<int>         memory_budget{"main/memorybudget", "Widget memory budget (MiB, 0 to disable)", 0, 0, 16384, 1};
+        Setting<bool>        local_transport{"main/localtransport", "Connect widgets to the data server in-process?", true};
+        Setting<bool>        local_socket{"main/localsocket", "Listen on a local socket for non-browser clients? (Linux only)", false};
+        Setting<std::string> relay_upstreams{"main/relayupstreams", "Relay topics of other Quasar instances (name=ws://host:port, ...)", ""};
+        Setting<std::string> derived_topics{"main/derivedtopics", "Topics aggregating Data Sources (name=source,window,operator; ...)", ""};
+        Setting<std::string> api_token{"main/apitoken", "Token authorizing HTTP requests when only Quasar widgets may connect", ""};
         Setting<std::string> cookies{"main/cookies", "cookies.txt", ""};
         Setting<bool>        update_check{"main/updatecheck", "Check for updates?", true};
         Setting<bool>        auto_update{"main/autoupdate", "Automatically download and install updates?", false};
@@ -175,6 +232,18 @@ namespace Settings
 
     extern InternalSettings internal;
 
+    //! Options given on the command line, for the current run only
+    struct LaunchOptions
+    {
+        std::string record{};          // Topic log to record published messages to
+        std::string record_topics{};   // Topics to record, comma separated, wildcards allowed
+        std::string replay{};          // Topic log to replay in place of loading extensions
+        double      replay_speed = 1;  // Replay speed factor, 0 for as fast as possible
+        bool        replay_loop  = false;
+    };
+
+    extern LaunchOptions launch;
+
     // Widget settings
     struct WidgetSettings
     {
@@ -199,6 +268,18 @@ namespace Settings
         std::string name;
         bool        enabled;
         int64_t     rate;
+        int         quantization;  // Quantization applied to numeric arrays
+        int         precision;     // Decimal places used by Quantization::fixed
+        bool        onChange;      // Only publish when the payload changes
+        int64_t     heartbeat;     // Forces a publish after this many ms without one (onChange only)
+        bool        compress;      // Compress payloads with permessage-deflate
+        int         threshold;     // Minimum payload size in bytes to compress
+        int         priority;      // Delivery priority to congested clients
+        bool        sharedMemory;  // Mirror the latest payload to shared memory
+        int         history;       // Number of samples kept for backfills, 0 to keep none
+        int         historyAge;    // Maximum age of kept samples in seconds, 0 for no limit
+        bool        archive;       // Record numeric payloads to the time series store
+        bool        collect;       // Keep running for the mirror, history and archive without active subscribers
     };
 
     using SettingsVariant     = std::variant<Setting<int>, Setting<double>, Setting<bool>, Setting<std::string>, SelectionSetting<std::string>>;
@@ -1,13 +1,23 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <regex>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace Util
 {
+    //! Transparent string hash for heterogeneous lookup in unordered containers
+    struct StringHash
+    {
+        using is_transparent = void;
+
+        size_t operator() (std::string_view str) const { return std::hash<std::string_view>{}(str); }
+    };
+
     template<typename T>
     T SplitString(const std::string& src, const std::string& delimiter)
         requires std::is_same_v<std::vector<std::string>, T> || std::is_same_v<std::set<std::string>, T>
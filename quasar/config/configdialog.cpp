@@ -27,10 +27,25 @@ ConfigDialog::ConfigDialog(QWidget* parent) : QDialog(parent), ui(new Ui::Config
     ui->logCombo->setCurrentIndex(Settings::internal.log_level.GetValue());
     ui->logToFile->setChecked(Settings::internal.log_file.GetValue());
     ui->authCheckbox->setChecked(Settings::internal.auth.GetValue());
+    ui->compressionCombo->setCurrentIndex(Settings::internal.compression.GetValue());
+    ui->processModelCombo->setCurrentIndex(Settings::internal.process_model.GetValue());
+    ui->rendererLimitSpin->setValue(Settings::internal.renderer_limit.GetValue());
+    ui->rendererLimitSpin->setEnabled(Settings::internal.process_model.GetValue() == Settings::ProcessModel::process_limit);
+    ui->cpuBudgetSpin->setValue(Settings::internal.cpu_budget.GetValue());
+    ui->memoryBudgetSpin->setValue(Settings::internal.memory_budget.GetValue());
+    ui->localTransportCheckbox->setChecked(Settings::internal.local_transport.GetValue());
+    ui->localSocketCheckbox->setChecked(Settings::internal.local_socket.GetValue());
+    ui->relayEdit->setText(QString::fromStdString(Settings::internal.relay_upstreams.GetValue()));
+    ui->derivedEdit->setText(QString::fromStdString(Settings::internal.derived_topics.GetValue()));
+    ui->apiTokenEdit->setText(QString::fromStdString(Settings::internal.api_token.GetValue()));
     ui->cookieEdit->setText(QString::fromStdString(Settings::internal.cookies.GetValue()));
     ui->updateCheckBox->setChecked(Settings::internal.update_check.GetValue());
     ui->autoUpdateCheckBox->setChecked(Settings::internal.auto_update.GetValue());
 
+    connect(ui->processModelCombo, &QComboBox::currentIndexChanged, [=, this](int index) {
+        ui->rendererLimitSpin->setEnabled(index == Settings::ProcessModel::process_limit);
+    });
+
     connect(ui->cookieButton, &QPushButton::clicked, [=, this](bool checked) {
         QString filename = QFileDialog::getOpenFileName(this, tr("Choose cookies.txt"), QString(), tr("cookies.txt (*.txt)"));
         if (!filename.isEmpty())
@@ -195,6 +210,16 @@ void ConfigDialog::SaveSettings()
     Settings::internal.log_level.SetValue(ui->logCombo->currentIndex());
     Settings::internal.log_file.SetValue(ui->logToFile->isChecked());
     Settings::internal.auth.SetValue(ui->authCheckbox->isChecked());
+    Settings::internal.compression.SetValue(ui->compressionCombo->currentIndex());
+    Settings::internal.process_model.SetValue(ui->processModelCombo->currentIndex());
+    Settings::internal.renderer_limit.SetValue(ui->rendererLimitSpin->value());
+    Settings::internal.cpu_budget.SetValue(ui->cpuBudgetSpin->value());
+    Settings::internal.memory_budget.SetValue(ui->memoryBudgetSpin->value());
+    Settings::internal.local_transport.SetValue(ui->localTransportCheckbox->isChecked());
+    Settings::internal.local_socket.SetValue(ui->localSocketCheckbox->isChecked());
+    Settings::internal.relay_upstreams.SetValue(ui->relayEdit->text().trimmed().toStdString());
+    Settings::internal.derived_topics.SetValue(ui->derivedEdit->text().trimmed().toStdString());
+    Settings::internal.api_token.SetValue(ui->apiTokenEdit->text().trimmed().toStdString());
     Settings::internal.cookies.SetValue(ui->cookieEdit->text().toStdString());
     Settings::internal.update_check.SetValue(ui->updateCheckBox->isChecked());
     Settings::internal.auto_update.SetValue(ui->autoUpdateCheckBox->isChecked());
@@ -261,8 +286,20 @@ void ConfigDialog::SaveSettings()
 
             if (result != info.sources.end())
             {
-                (*result).get().enabled = c.enabled;
-                (*result).get().rate    = c.rate;
+                (*result).get().enabled      = c.enabled;
+                (*result).get().rate         = c.rate;
+                (*result).get().quantization = c.quantization;
+                (*result).get().precision    = c.precision;
+                (*result).get().onChange     = c.onChange;
+                (*result).get().heartbeat    = c.heartbeat;
+                (*result).get().compress     = c.compress;
+                (*result).get().threshold    = c.threshold;
+                (*result).get().priority     = c.priority;
+                (*result).get().sharedMemory = c.sharedMemory;
+                (*result).get().history      = c.history;
+                (*result).get().historyAge   = c.historyAge;
+                (*result).get().archive      = c.archive;
+                (*result).get().collect      = c.collect;
             }
         }
 
@@ -3,6 +3,8 @@
 
 #include <QCheckBox>
 #include <QComboBox>
+#include <QHBoxLayout>
+#include <QLabel>
 #include <QLineEdit>
 #include <QSpinBox>
 
@@ -65,6 +67,218 @@ ExtensionPage::ExtensionPage(const std::string& extname, const Settings::Extensi
         }
 
         row++;
+
+        // Quantization
+        auto quantLabel = new QLabel(this);
+        quantLabel->setText(tr("    Quantization"));
+
+        auto quantWidget = new QWidget(this);
+        auto quantLayout = new QHBoxLayout(quantWidget);
+        quantLayout->setContentsMargins(0, 0, 0, 0);
+
+        auto quantCombo = new QComboBox(quantWidget);
+        quantCombo->setObjectName(name + "/quantization");
+        quantCombo->addItem(tr("Full precision"), Settings::Quantization::full);
+        quantCombo->addItem(tr("Fixed decimal places"), Settings::Quantization::fixed);
+        quantCombo->addItem(tr("16-bit normalized"), Settings::Quantization::norm16);
+        quantCombo->addItem(tr("8-bit normalized"), Settings::Quantization::norm8);
+        quantCombo->setCurrentIndex(quantCombo->findData(data.get().quantization));
+
+        QSpinBox* precSpin = new QSpinBox(quantWidget);
+        precSpin->setObjectName(name + "/precision");
+        precSpin->setMinimum(0);
+        precSpin->setMaximum(15);
+        precSpin->setValue(data.get().precision);
+        precSpin->setSuffix(tr(" decimals"));
+        precSpin->setEnabled(data.get().quantization == Settings::Quantization::fixed);
+
+        quantLayout->addWidget(quantCombo);
+        quantLayout->addWidget(precSpin);
+
+        connect(quantCombo, &QComboBox::currentIndexChanged, [&, quantCombo, precSpin](int index) {
+            savedDat.quantization = quantCombo->itemData(index).toInt();
+            precSpin->setEnabled(savedDat.quantization == Settings::Quantization::fixed);
+        });
+
+        connect(precSpin, &QSpinBox::valueChanged, [&](int value) {
+            savedDat.precision = value;
+        });
+
+        ui->sourcesLayout->setWidget(row, QFormLayout::LabelRole, quantLabel);
+        ui->sourcesLayout->setWidget(row, QFormLayout::FieldRole, quantWidget);
+
+        row++;
+
+        // Compression
+        auto compressCheck = new QCheckBox(this);
+        compressCheck->setObjectName(name + "/compress");
+        compressCheck->setText(tr("    Compress"));
+        compressCheck->setChecked(data.get().compress);
+
+        QSpinBox* threshSpin = new QSpinBox(this);
+        threshSpin->setObjectName(name + "/threshold");
+        threshSpin->setMinimum(0);
+        threshSpin->setMaximum(INT_MAX);
+        threshSpin->setSingleStep(256);
+        threshSpin->setValue(data.get().threshold);
+        threshSpin->setPrefix(tr("From "));
+        threshSpin->setSuffix(tr(" bytes"));
+        threshSpin->setEnabled(data.get().compress);
+
+        connect(compressCheck, &QCheckBox::toggled, [&, threshSpin](bool state) {
+            savedDat.compress = state;
+            threshSpin->setEnabled(state);
+        });
+
+        connect(threshSpin, &QSpinBox::valueChanged, [&](int value) {
+            savedDat.threshold = value;
+        });
+
+        ui->sourcesLayout->setWidget(row, QFormLayout::LabelRole, compressCheck);
+        ui->sourcesLayout->setWidget(row, QFormLayout::FieldRole, threshSpin);
+
+        row++;
+
+        // Publish on change
+        if (data.get().rate != 0)
+        {
+            auto changeCheck = new QCheckBox(this);
+            changeCheck->setObjectName(name + "/onchange");
+            changeCheck->setText(tr("    Publish on change"));
+            changeCheck->setChecked(data.get().onChange);
+
+            QSpinBox* beatSpin = new QSpinBox(this);
+            beatSpin->setObjectName(name + "/heartbeat");
+            beatSpin->setMinimum(0);
+            beatSpin->setMaximum(INT_MAX);
+            beatSpin->setSingleStep(1000);
+            beatSpin->setValue(data.get().heartbeat);
+            beatSpin->setPrefix(tr("Heartbeat "));
+            beatSpin->setSuffix("ms");
+            beatSpin->setSpecialValueText(tr("No heartbeat"));
+            beatSpin->setEnabled(data.get().onChange);
+
+            connect(changeCheck, &QCheckBox::toggled, [&, beatSpin](bool state) {
+                savedDat.onChange = state;
+                beatSpin->setEnabled(state);
+            });
+
+            connect(beatSpin, &QSpinBox::valueChanged, [&](int value) {
+                savedDat.heartbeat = value;
+            });
+
+            ui->sourcesLayout->setWidget(row, QFormLayout::LabelRole, changeCheck);
+            ui->sourcesLayout->setWidget(row, QFormLayout::FieldRole, beatSpin);
+
+            row++;
+
+            // Priority
+            auto prioLabel = new QLabel(this);
+            prioLabel->setText(tr("    Priority"));
+
+            auto prioCombo = new QComboBox(this);
+            prioCombo->setObjectName(name + "/priority");
+            prioCombo->addItem(tr("Low"), Settings::Priority::low_priority);
+            prioCombo->addItem(tr("Normal"), Settings::Priority::normal_priority);
+            prioCombo->addItem(tr("High"), Settings::Priority::high_priority);
+            prioCombo->setCurrentIndex(prioCombo->findData(data.get().priority));
+
+            connect(prioCombo, &QComboBox::currentIndexChanged, [&, prioCombo](int index) {
+                savedDat.priority = prioCombo->itemData(index).toInt();
+            });
+
+            ui->sourcesLayout->setWidget(row, QFormLayout::LabelRole, prioLabel);
+            ui->sourcesLayout->setWidget(row, QFormLayout::FieldRole, prioCombo);
+
+            row++;
+
+            // Shared memory mirror
+            auto shmCheck = new QCheckBox(this);
+            shmCheck->setObjectName(name + "/sharedmemory");
+            shmCheck->setText(tr("    Mirror to shared memory"));
+            shmCheck->setChecked(data.get().sharedMemory);
+
+            connect(shmCheck, &QCheckBox::toggled, [&](bool state) {
+                savedDat.sharedMemory = state;
+            });
+
+            ui->sourcesLayout->setWidget(row, QFormLayout::LabelRole, shmCheck);
+
+            row++;
+
+            // History
+            auto histLabel = new QLabel(this);
+            histLabel->setText(tr("    History"));
+
+            auto histWidget = new QWidget(this);
+            auto histLayout = new QHBoxLayout(histWidget);
+            histLayout->setContentsMargins(0, 0, 0, 0);
+
+            QSpinBox* histSpin = new QSpinBox(histWidget);
+            histSpin->setObjectName(name + "/history");
+            histSpin->setMinimum(0);
+            histSpin->setMaximum(100000);
+            histSpin->setSingleStep(60);
+            histSpin->setValue(data.get().history);
+            histSpin->setSuffix(tr(" samples"));
+            histSpin->setSpecialValueText(tr("Off"));
+
+            QSpinBox* ageSpin = new QSpinBox(histWidget);
+            ageSpin->setObjectName(name + "/historyage");
+            ageSpin->setMinimum(0);
+            ageSpin->setMaximum(INT_MAX);
+            ageSpin->setSingleStep(60);
+            ageSpin->setValue(data.get().historyAge);
+            ageSpin->setPrefix(tr("Up to "));
+            ageSpin->setSuffix("s");
+            ageSpin->setSpecialValueText(tr("No age limit"));
+            ageSpin->setEnabled(data.get().history > 0);
+
+            histLayout->addWidget(histSpin);
+            histLayout->addWidget(ageSpin);
+
+            connect(histSpin, &QSpinBox::valueChanged, [&, ageSpin](int value) {
+                savedDat.history = value;
+                ageSpin->setEnabled(value > 0);
+            });
+
+            connect(ageSpin, &QSpinBox::valueChanged, [&](int value) {
+                savedDat.historyAge = value;
+            });
+
+            ui->sourcesLayout->setWidget(row, QFormLayout::LabelRole, histLabel);
+            ui->sourcesLayout->setWidget(row, QFormLayout::FieldRole, histWidget);
+
+            row++;
+
+            // Time series archive
+            auto archiveCheck = new QCheckBox(this);
+            archiveCheck->setObjectName(name + "/archive");
+            archiveCheck->setText(tr("    Archive to disk"));
+            archiveCheck->setChecked(data.get().archive);
+
+            connect(archiveCheck, &QCheckBox::toggled, [&](bool state) {
+                savedDat.archive = state;
+            });
+
+            ui->sourcesLayout->setWidget(row, QFormLayout::LabelRole, archiveCheck);
+
+            row++;
+
+            // Mirror, history and archive without subscribers
+            auto collectCheck = new QCheckBox(this);
+            collectCheck->setObjectName(name + "/collect");
+            collectCheck->setText(tr("    Collect while unsubscribed"));
+            collectCheck->setChecked(data.get().collect);
+
+            connect(collectCheck, &QCheckBox::toggled, [&](bool state) {
+                savedDat.collect = state;
+            });
+
+            ui->sourcesLayout->setWidget(row, QFormLayout::LabelRole, collectCheck);
+
+            row++;
+        }
     }
 
     // Settings
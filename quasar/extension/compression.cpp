@@ -0,0 +1,46 @@
+#include "compression.h"
+
+#include <vector>
+
+#include <zlib.h>
+
+namespace
+{
+    // Matches the permessage-deflate parameters used by uWebSockets
+    constexpr int DEFLATE_LEVEL       = 1;
+    constexpr int DEFLATE_WINDOW_BITS = -15;
+    constexpr int DEFLATE_MEM_LEVEL   = 8;
+}  // namespace
+
+Compression::Sample Compression::Measure(std::string_view payload)
+{
+    Sample   sample{};
+    z_stream stream{};
+
+    if (deflateInit2(&stream, DEFLATE_LEVEL, Z_DEFLATED, DEFLATE_WINDOW_BITS, DEFLATE_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return sample;
+    }
+
+    std::vector<Bytef> out(deflateBound(&stream, static_cast<uLong>(payload.size())));
+
+    stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(payload.data()));
+    stream.avail_in  = static_cast<uInt>(payload.size());
+    stream.next_out  = out.data();
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto ret   = deflate(&stream, Z_SYNC_FLUSH);
+    const auto end   = std::chrono::steady_clock::now();
+
+    if (ret == Z_OK or ret == Z_STREAM_END)
+    {
+        // permessage-deflate strips the trailing 0x00 0x00 0xff 0xff of a sync flush
+        sample.compressed = stream.total_out > 4 ? stream.total_out - 4 : stream.total_out;
+        sample.cpu        = end - start;
+    }
+
+    deflateEnd(&stream);
+
+    return sample;
+}
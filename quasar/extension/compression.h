@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string_view>
+
+//! Estimation of permessage-deflate cost for Data Source payloads
+namespace Compression
+{
+    //! Result of a single deflate measurement
+    struct Sample
+    {
+        size_t                   compressed = 0;  //!< Deflated size in bytes
+        std::chrono::nanoseconds cpu{};           //!< Time spent compressing
+    };
+
+    //! Deflates a payload the way the WebSocket server would and measures the result
+    /*! uWebSockets does not report the size of compressed frames, so payloads are
+        periodically compressed a second time with the same raw deflate parameters
+        to estimate the compression ratio and CPU cost of a topic.
+
+        \param[in]  payload     Payload to compress
+        \return Compressed size and time taken, or an empty Sample if compression failed
+    */
+    Sample Measure(std::string_view payload);
+}  // namespace Compression
@@ -5,13 +5,23 @@
 #include "extension.h"
 
 #include "extension_support_internal.h"
+#include "history.h"
+#include "quantize.h"
 
 #include "server/server.h"
+#include "server/sharedmirror.h"
+#include "server/timeseries.h"
+#include "server/topicbus.h"
 
+#include "compression.h"
+
+#include <numeric>
 #include <ranges>
 
 #include <QLibrary>
 
+#include <jsoncons_ext/jsonpatch/jsonpatch.hpp>
+#include <jsoncons_ext/mergepatch/mergepatch.hpp>
 #include <spdlog/spdlog.h>
 
 #define CHAR_TO_STRING(d, x) \
@@ -20,6 +30,48 @@
 
 size_t Extension::_uid = 0;
 
+namespace
+{
+    //! Interval between full snapshots on delta channels
+    constexpr auto     DELTA_SNAPSHOT_INTERVAL     = std::chrono::seconds(10);
+
+    //! Measure every n-th compressed payload for metrics
+    constexpr uint64_t COMPRESSION_SAMPLE_INTERVAL = 16;
+
+    //! Splits a subscription channel into its topic and delta mode
+    std::pair<std::string, DeltaMode> splitChannel(const std::string& channel)
+    {
+        auto pos = channel.find('@');
+
+        if (pos == std::string::npos)
+        {
+            return {channel, DELTA_NONE};
+        }
+
+        return {channel.substr(0, pos), ParseDeltaMode(std::string_view{channel}.substr(pos + 1))};
+    }
+
+    //! Number of subscribers of a delta channel that are not paused
+    int activeSubscribers(const DataSource& src, DeltaMode mode)
+    {
+        return std::max(0, src.channels[mode] - src.paused[mode]);
+    }
+
+    //! Number of subscribers of a Data Source that are not paused
+    int activeSubscribers(const DataSource& src)
+    {
+        return activeSubscribers(src, DELTA_NONE) + activeSubscribers(src, DELTA_MERGE) + activeSubscribers(src, DELTA_PATCH);
+    }
+
+    //! Whether a Data Source has active subscribers or in-process consumers, or collects for its mirror, history or archive without them
+    bool isConsumed(const DataSource& src)
+    {
+        const bool collects = src.settings.collect and (src.mirror or src.history or src.archive);
+
+        return src.subscribers > 0 or !src.taps.empty() or collects;
+    }
+}  // namespace
+
 Extension::Extension(quasar_ext_info_t* info, extension_destroy destroyfunc, std::string_view path, Server* srv, std::shared_ptr<Config> cfg, bool isInternal) :
     extensionInfo{info},
     destroyFunc{destroyfunc},
@@ -80,15 +132,32 @@ Extension::Extension(quasar_ext_info_t* info, extension_destroy destroyfunc, std
                 continue;
             }
 
-            DataSource& source      = datasources[topic];
-
-            source.settings.enabled = true;
-            source.settings.rate    = extensionInfo->dataSources[i].rate;
-            source.settings.name    = topic;
-            source.topic            = topic;
-            source.validtime        = extensionInfo->dataSources[i].validtime;
+            DataSource& source           = datasources[topic];
+
+            source.settings.enabled      = true;
+            source.settings.rate         = extensionInfo->dataSources[i].rate;
+            source.settings.name         = topic;
+            source.settings.quantization = Settings::Quantization::full;
+            source.settings.precision    = 3;
+            source.settings.onChange     = false;
+            source.settings.heartbeat    = 10000;
+            source.settings.compress     = false;
+            source.settings.threshold    = 1024;
+            source.settings.priority     = Settings::Priority::normal_priority;
+            source.settings.sharedMemory = false;
+            source.settings.history      = 0;
+            source.settings.historyAge   = 0;
+            source.settings.archive      = false;
+            source.settings.collect      = false;
+            source.topic                 = topic;
+            source.validtime             = extensionInfo->dataSources[i].validtime;
             source.uid = extensionInfo->dataSources[i].uid = ++Extension::_uid;
 
+            for (auto&& mode : {DELTA_NONE, DELTA_MERGE, DELTA_PATCH})
+            {
+                source.channelTopics[mode] = topic + std::string{DeltaChannelSuffix(mode)};
+            }
+
             cfl->ReadDataSourceSetting(&source.settings);
 
             // Initialize type specific fields
@@ -138,19 +207,34 @@ Extension::Extension(quasar_ext_info_t* info, extension_destroy destroyfunc, std
     }
 }
 
-bool Extension::TopicExists(const std::string& topic) const
+std::vector<std::string> Extension::GetTopics() const
+{
+    std::vector<std::string> topics;
+    topics.reserve(datasources.size());
+
+    for (auto&& [topic, src] : datasources)
+    {
+        topics.push_back(topic);
+    }
+
+    return topics;
+}
+
+bool Extension::TopicExists(std::string_view topic) const
 {
-    return (datasources.count(topic) > 0);
+    return datasources.contains(topic);
 }
 
-bool Extension::TopicAcceptsSubscribers(const std::string& topic)
+bool Extension::TopicAcceptsSubscribers(std::string_view topic)
 {
-    if (!TopicExists(topic))
+    auto it = datasources.find(topic);
+
+    if (it == datasources.end())
     {
         return false;
     }
 
-    DataSource&                         dsrc = datasources.at(topic);
+    DataSource&                         dsrc = it->second;
 
     std::shared_lock<std::shared_mutex> lk(dsrc.mutex);
 
@@ -162,7 +246,7 @@ bool Extension::TopicAcceptsSubscribers(const std::string& topic)
     return true;
 }
 
-bool Extension::AddSubscriber(void* subscriber, const std::string& topic, int count)
+bool Extension::AddSubscriber(void* subscriber, const std::string& channel, int count)
 {
     if (!subscriber)
     {
@@ -170,6 +254,8 @@ bool Extension::AddSubscriber(void* subscriber, const std::string& topic, int co
         return false;
     }
 
+    auto [topic, mode] = splitChannel(channel);
+
     if (!TopicExists(topic))
     {
         SPDLOG_WARN("Unknown topic {} requested in extension {}", topic, name);
@@ -187,7 +273,16 @@ bool Extension::AddSubscriber(void* subscriber, const std::string& topic, int co
     {
         std::lock_guard<std::shared_mutex> lk(dsrc.mutex);
 
-        dsrc.subscribers = count;
+        dsrc.channels[mode] = count;
+        dsrc.subscribers    = activeSubscribers(dsrc);
+
+        // Make sure the new subscriber gets the current value
+        dsrc.lastHash       = 0;
+
+        if (mode != DELTA_NONE)
+        {
+            dsrc.lastSnapshot = {};
+        }
 
         if (dsrc.settings.rate > QUASAR_POLLING_CLIENT)
         {
@@ -201,13 +296,13 @@ bool Extension::AddSubscriber(void* subscriber, const std::string& topic, int co
     if (!payload.empty())
     {
         // Send the payload
-        server->SendDataToClient((PerSocketData*) subscriber, payload);
+        server->SendDataToClient((PerSocketData*) subscriber, std::move(payload));
     }
 
     return true;
 }
 
-void Extension::RemoveSubscriber(void* subscriber, const std::string& topic, int count)
+void Extension::RemoveSubscriber(void* subscriber, const std::string& channel, int count, bool wasPaused)
 {
     if (!subscriber)
     {
@@ -215,6 +310,8 @@ void Extension::RemoveSubscriber(void* subscriber, const std::string& topic, int
         return;
     }
 
+    auto [topic, mode] = splitChannel(channel);
+
     if (!datasources.count(topic))
     {
         SPDLOG_WARN("Unknown topic {} requested in extension {}", topic, name);
@@ -227,17 +324,118 @@ void Extension::RemoveSubscriber(void* subscriber, const std::string& topic, int
 
     SPDLOG_INFO("Widget unsubscribed from topic {}", dsrc.topic);
 
-    dsrc.subscribers = count;
+    dsrc.channels[mode] = count;
+
+    if (wasPaused)
+    {
+        dsrc.paused[mode] = std::max(0, dsrc.paused[mode] - 1);
+    }
+
+    dsrc.subscribers = activeSubscribers(dsrc);
+
+    if (dsrc.channels[DELTA_MERGE] <= 0 and dsrc.channels[DELTA_PATCH] <= 0)
+    {
+        dsrc.lastDocument = jsoncons::json::null();
+    }
 
     // Stop timer if no subscribers
-    if (dsrc.subscribers <= 0)
+    if (!isConsumed(dsrc))
+    {
+        if (dsrc.timer)
+        {
+            dsrc.timer->stop();
+            dsrc.timer.reset();
+        }
+    }
+}
+
+bool Extension::AddTap(std::string_view topic, DataTap* tap)
+{
+    auto it = datasources.find(topic);
+
+    if (it == datasources.end() or it->second.settings.rate == QUASAR_POLLING_CLIENT)
+    {
+        SPDLOG_WARN("Topic '{}' in extension {} cannot be consumed in process", topic, name);
+        return false;
+    }
+
+    DataSource&                        dsrc = it->second;
+
+    std::lock_guard<std::shared_mutex> lk(dsrc.mutex);
+
+    dsrc.taps.push_back(tap);
+
+    if (dsrc.settings.rate > QUASAR_POLLING_CLIENT)
+    {
+        createTimer(dsrc);
+    }
+
+    return true;
+}
+
+void Extension::RemoveTap(std::string_view topic, DataTap* tap)
+{
+    auto it = datasources.find(topic);
+
+    if (it == datasources.end())
     {
+        return;
+    }
+
+    DataSource&                        dsrc = it->second;
+
+    std::lock_guard<std::shared_mutex> lk(dsrc.mutex);
+
+    std::erase(dsrc.taps, tap);
+
+    if (!isConsumed(dsrc) and dsrc.timer)
+    {
+        dsrc.timer->stop();
+        dsrc.timer.reset();
+    }
+}
+
+void Extension::SetSubscriberPaused(const std::string& channel, bool paused)
+{
+    auto [topic, mode] = splitChannel(channel);
+
+    if (!datasources.count(topic))
+    {
+        SPDLOG_WARN("Unknown topic {} requested in extension {}", topic, name);
+        return;
+    }
+
+    DataSource&                        dsrc = datasources.at(topic);
+
+    std::lock_guard<std::shared_mutex> lk(dsrc.mutex);
+
+    dsrc.paused[mode] = std::max(0, dsrc.paused[mode] + (paused ? 1 : -1));
+    dsrc.subscribers  = activeSubscribers(dsrc);
+
+    if (!isConsumed(dsrc))
+    {
+        // Nobody is consuming this source anymore
         if (dsrc.timer)
         {
             dsrc.timer->stop();
             dsrc.timer.reset();
         }
     }
+    else if (!paused)
+    {
+        // Make sure the resumed subscriber gets the current value
+        dsrc.lastHash = 0;
+
+        if (mode != DELTA_NONE)
+        {
+            dsrc.lastSnapshot = {};
+        }
+
+        if (dsrc.settings.rate > QUASAR_POLLING_CLIENT)
+        {
+            createTimer(dsrc);
+        }
+    }
 }
 
 void Extension::GetMetadataJSON(jsoncons::json& json, bool settings_only)
@@ -362,6 +560,46 @@ void Extension::GetMetadataJSON(jsoncons::json& json, bool settings_only)
     }
 }
 
+void Extension::GetMetricsJSON(jsoncons::json& json)
+{
+    for (auto&& [key, src] : datasources)
+    {
+        std::shared_lock<std::shared_mutex> lk(src.mutex);
+
+        json[src.topic] = jsoncons::json{
+            jsoncons::json_object_arg,
+            {{"subscribers", src.subscribers},
+              {"published", src.stats.published},
+              {"suppressed", src.stats.suppressed},
+              {"bytes", src.stats.bytes},
+              {"paused", std::accumulate(src.paused.begin(), src.paused.end(), 0)},
+              {"compressed", src.stats.compressed}}
+        };
+
+        if (src.stats.samples > 0)
+        {
+            json[src.topic]["compressionRatio"] = static_cast<double>(src.stats.sampledOut) / src.stats.sampledIn;
+            json[src.topic]["compressUs"]       = static_cast<double>(src.stats.sampledNs) / src.stats.samples / 1000.0;
+        }
+    }
+}
+
+bool Extension::CompressesTopic(std::string_view topic, size_t size) const
+{
+    auto it = datasources.find(topic);
+
+    if (it == datasources.end() or !server->CompressionEnabled())
+    {
+        return false;
+    }
+
+    const DataSource&                   src = it->second;
+
+    std::shared_lock<std::shared_mutex> lk(src.mutex);
+
+    return src.settings.compress and size >= static_cast<size_t>(src.settings.threshold);
+}
+
 void Extension::HandleDataReady(std::string_view source)
 {
     server->RunOnPool([source = std::string{source}, this] {
@@ -412,9 +650,11 @@ void Extension::HandleDataReady(std::string_view source)
                         {
                             j.dump(message);
 
+                            const bool compress = compressPayload(data, message);
+
                             for (auto&& client : data.pollqueue)
                             {
-                                server->SendDataToClient((PerSocketData*) client, message);
+                                server->SendDataToClient((PerSocketData*) client, message, {.compress = compress});
                             }
 
                             data.pollqueue.clear();
@@ -456,7 +696,7 @@ void Extension::WaitForDataProcessed(std::string_view source)
     }
 }
 
-Extension::DataSourceReturnState Extension::getDataFromSource(jsoncons::json& msg, DataSource& src, std::string args)
+Extension::DataSourceReturnState Extension::getDataFromSource(jsoncons::json& msg, DataSource& src, const char* args, bool quantize)
 {
     using namespace std::chrono;
 
@@ -485,7 +725,7 @@ Extension::DataSourceReturnState Extension::getDataFromSource(jsoncons::json& ms
     quasar_return_data_t rett;
 
     // Poll extension for data source
-    if (!extensionInfo->get_data(src.uid, &rett, args.empty() ? nullptr : args.data()))
+    if (!extensionInfo->get_data(src.uid, &rett, (args and *args) ? args : nullptr))
     {
         if (!rett.errors.empty())
         {
@@ -520,6 +760,11 @@ Extension::DataSourceReturnState Extension::getDataFromSource(jsoncons::json& ms
     }
 
     // If we have valid data here:
+    if (quantize)
+    {
+        Quantize::Apply(rett.val.value(), src.settings.quantization, src.settings.precision);
+    }
+
     if (src.settings.rate == QUASAR_POLLING_CLIENT and src.validtime)
     {
         // If validity time duration is set, cache the data
@@ -542,7 +787,7 @@ void Extension::sendDataToSubscribers(DataSource& src)
         std::lock_guard<std::shared_mutex> lk(src.mutex);
 
         // Only send if there are subscribers
-        if (src.subscribers > 0)
+        if (isConsumed(src))
         {
             src.buffer.clear();
 
@@ -551,12 +796,48 @@ void Extension::sendDataToSubscribers(DataSource& src)
                 {{src.topic, jsoncons::json{jsoncons::json_object_arg}}, {"errors", jsoncons::json{jsoncons::json_array_arg}}}
             };
 
-            getDataFromSource(j, src);
+            // In-process consumers get the data as retrieved, only the published copy is quantized
+            getDataFromSource(j, src, nullptr, false);
+
+            // Unchanged samples still count towards rollups, which are of the unquantized values
+            if (src.archive and j.contains(src.topic))
+            {
+                src.archive->Record(src.topic, j[src.topic]);
+            }
+
+            // Mirrored unquantized, so numeric arrays keep their typed layout
+            if (src.mirror and j.contains(src.topic) and !j[src.topic].empty())
+            {
+                SharedMirror::Publish(src.mirror, j[src.topic]);
+            }
+
+            if (!src.taps.empty() and j.contains(src.topic) and !j[src.topic].empty())
+            {
+                for (auto tap : src.taps)
+                {
+                    tap->OnData(src.topic, j[src.topic]);
+                }
+            }
 
             if (j[src.topic].empty())
             {
                 j.erase(src.topic);
             }
+            else
+            {
+                Quantize::Apply(j.at(src.topic), src.settings.quantization, src.settings.precision);
+
+                // Kept as published, so backfilled samples decode like live updates
+                if (src.history)
+                {
+                    thread_local std::string sample;
+
+                    sample.clear();
+                    j[src.topic].dump(sample);
+
+                    src.history->Push(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), sample);
+                }
+            }
 
             if (j["errors"].empty())
             {
@@ -567,7 +848,35 @@ void Extension::sendDataToSubscribers(DataSource& src)
             {
                 j.dump(src.buffer);
 
-                server->PublishData(src.topic, src.buffer);
+                const auto now = std::chrono::steady_clock::now();
+
+                if (src.settings.onChange)
+                {
+                    const auto hash      = std::hash<std::string>{}(src.buffer);
+                    const bool heartbeat = src.settings.heartbeat > 0 and (now - src.lastPublish) >= std::chrono::milliseconds(src.settings.heartbeat);
+
+                    if (hash == src.lastHash and !heartbeat)
+                    {
+                        src.stats.suppressed++;
+                        src.buffer.clear();
+                    }
+
+                    src.lastHash = hash;
+                }
+
+                if (!src.buffer.empty())
+                {
+                    src.lastPublish = now;
+                    src.stats.published++;
+                    src.stats.bytes += src.buffer.size();
+
+                    if (activeSubscribers(src, DELTA_NONE) > 0)
+                    {
+                        server->PublishData(src.topic, src.buffer, {.compress = compressPayload(src, src.buffer), .priority = src.settings.priority, .reliable = false});
+                    }
+
+                    publishDeltas(src, j);
+                }
             }
         }
     }
@@ -584,6 +893,190 @@ void Extension::sendDataToSubscribers(DataSource& src)
     }
 }
 
+void Extension::publishDeltas(DataSource& src, const jsoncons::json& msg)
+{
+    if (activeSubscribers(src, DELTA_MERGE) <= 0 and activeSubscribers(src, DELTA_PATCH) <= 0)
+    {
+        return;
+    }
+
+    const auto     now      = std::chrono::steady_clock::now();
+    const bool     snapshot = src.lastDocument.is_null() or (now - src.lastSnapshot) >= DELTA_SNAPSHOT_INTERVAL;
+
+    jsoncons::json doc      = msg.contains(src.topic) ? msg.at(src.topic) : jsoncons::json::null();
+
+    src.deltaSeq++;
+
+    for (auto&& mode : {DELTA_MERGE, DELTA_PATCH})
+    {
+        if (activeSubscribers(src, mode) <= 0)
+        {
+            continue;
+        }
+
+        jsoncons::json delta{
+            jsoncons::json_object_arg,
+            {{"topic", src.topic}, {"seq", src.deltaSeq}}
+        };
+
+        if (snapshot)
+        {
+            delta["type"] = "snapshot";
+            delta["data"] = doc;
+        }
+        else
+        {
+            delta["type"] = std::string{DeltaModeName(mode)};
+            delta["data"] = (mode == DELTA_MERGE) ? jsoncons::mergepatch::from_diff(src.lastDocument, doc) : jsoncons::jsonpatch::from_diff(src.lastDocument, doc);
+        }
+
+        jsoncons::json envelope{
+            jsoncons::json_object_arg,
+            {{"delta", std::move(delta)}}
+        };
+
+        if (msg.contains("errors"))
+        {
+            envelope["errors"] = msg.at("errors");
+        }
+
+        std::string message{};
+        envelope.dump(message);
+
+        // Snapshots must arrive for later deltas to apply
+        server->PublishData(src.channelTopics[mode], message, {.compress = compressPayload(src, message), .priority = src.settings.priority, .reliable = snapshot});
+    }
+
+    if (snapshot)
+    {
+        src.lastSnapshot = now;
+    }
+
+    src.lastDocument = std::move(doc);
+}
+
+void Extension::publishToChannels(DataSource& src, const std::string& payload)
+{
+    for (auto&& mode : {DELTA_NONE, DELTA_MERGE, DELTA_PATCH})
+    {
+        if (src.channels[mode] > 0)
+        {
+            server->PublishData(src.channelTopics[mode], payload);
+        }
+    }
+}
+
+bool Extension::compressPayload(DataSource& src, const std::string& payload)
+{
+    if (!src.settings.compress or payload.size() < static_cast<size_t>(src.settings.threshold) or !server->CompressionEnabled())
+    {
+        return false;
+    }
+
+    if ((src.stats.compressed++ % COMPRESSION_SAMPLE_INTERVAL) == 0)
+    {
+        const auto sample = Compression::Measure(payload);
+
+        if (sample.compressed > 0)
+        {
+            src.stats.samples++;
+            src.stats.sampledIn  += payload.size();
+            src.stats.sampledOut += sample.compressed;
+            src.stats.sampledNs  += std::chrono::duration_cast<std::chrono::nanoseconds>(sample.cpu).count();
+        }
+    }
+
+    return true;
+}
+
+size_t Extension::TrimCaches()
+{
+    size_t trimmed = 0;
+
+    for (auto&& [topic, src] : datasources)
+    {
+        std::lock_guard<std::shared_mutex> lk(src.mutex);
+
+        if (!src.cache.data.is_null())
+        {
+            src.cache.data   = jsoncons::json::null();
+            src.cache.expiry = {};
+            trimmed++;
+        }
+
+        if (!src.lastDocument.is_null())
+        {
+            src.lastDocument = jsoncons::json::null();
+            trimmed++;
+        }
+
+        src.buffer.clear();
+        src.buffer.shrink_to_fit();
+    }
+
+    return trimmed;
+}
+
+std::string Extension::CraftDeltaSnapshot(std::string_view topic)
+{
+    std::string message{};
+    auto        it = datasources.find(topic);
+
+    if (it == datasources.end())
+    {
+        return message;
+    }
+
+    DataSource&                         src = it->second;
+
+    std::shared_lock<std::shared_mutex> lk(src.mutex);
+
+    if (src.lastDocument.is_null())
+    {
+        return message;
+    }
+
+    jsoncons::json envelope{
+        jsoncons::json_object_arg,
+        {{"delta",
+            jsoncons::json{
+                jsoncons::json_object_arg,
+                {{"topic", src.topic}, {"seq", src.deltaSeq}, {"type", "snapshot"}, {"data", src.lastDocument}}
+            }}}
+    };
+
+    envelope.dump(message);
+
+    return message;
+}
+
+std::string Extension::CraftHistory(std::string_view topic, size_t count)
+{
+    std::string message{};
+    auto        it = datasources.find(topic);
+
+    if (it == datasources.end())
+    {
+        return message;
+    }
+
+    DataSource&                         src = it->second;
+
+    std::shared_lock<std::shared_mutex> lk(src.mutex);
+
+    if (!src.history)
+    {
+        return message;
+    }
+
+    // Samples are spliced in as they were serialized
+    message = fmt::format("{{\"history\":{{\"topic\":\"{}\",\"samples\":", src.topic);
+    src.history->AppendTo(message, count);
+    message.append("}}");
+
+    return message;
+}
+
 void Extension::createTimer(DataSource& src)
 {
     if (src.settings.enabled and !src.timer)
@@ -650,10 +1143,7 @@ void Extension::UpdateExtensionSettings()
             {
                 std::shared_lock<std::shared_mutex> lk(source.mutex);
 
-                if (source.subscribers > 0)
-                {
-                    server->PublishData(source.topic, payload);
-                }
+                publishToChannels(source, payload);
             }
         }
     }
@@ -684,7 +1174,43 @@ void Extension::refreshDataSources()
     {
         std::lock_guard<std::shared_mutex> lk(src.mutex);
 
-        if (src.settings.enabled and src.settings.rate > QUASAR_POLLING_CLIENT and src.subscribers > 0)
+        // Client polled sources have no data to mirror until a client asks for it
+        if (src.settings.enabled and src.settings.sharedMemory and src.settings.rate != QUASAR_POLLING_CLIENT)
+        {
+            if (!src.mirror)
+            {
+                src.mirror = server->GetSharedMirror().Attach(src.topic);
+            }
+        }
+        else if (src.mirror)
+        {
+            SharedMirror::Detach(src.mirror);
+            src.mirror = nullptr;
+        }
+
+        // Client polled sources only produce samples when asked to
+        if (src.settings.enabled and src.settings.history > 0 and src.settings.rate != QUASAR_POLLING_CLIENT)
+        {
+            const int64_t maxAge = int64_t{src.settings.historyAge} * 1000;
+
+            if (src.history)
+            {
+                src.history->SetLimits(src.settings.history, maxAge);
+            }
+            else
+            {
+                src.history = std::make_unique<HistoryRing>(src.settings.history, maxAge);
+            }
+        }
+        else
+        {
+            src.history.reset();
+        }
+
+        // The store is only created once a source is archived
+        src.archive = (src.settings.enabled and src.settings.archive and src.settings.rate != QUASAR_POLLING_CLIENT) ? &server->GetTimeSeriesStore() : nullptr;
+
+        if (src.settings.enabled and src.settings.rate > QUASAR_POLLING_CLIENT and isConsumed(src))
         {
             // Create timer if not exist
             createTimer(src);
@@ -710,6 +1236,9 @@ Extension::~Extension()
 {
     auto cfl = config.lock();
 
+    // No longer consumes or feeds other extensions
+    server->GetTopicBus().RemoveExtension(this);
+
     // Do some explicit cleanup
     for (auto&& [name, src] : datasources)
     {
@@ -719,6 +1248,12 @@ Extension::~Extension()
             src.timer.reset();
         }
 
+        if (src.mirror)
+        {
+            SharedMirror::Detach(src.mirror);
+            src.mirror = nullptr;
+        }
+
         src.locks.reset();
         cfl->WriteDataSourceSetting(&src.settings);
     }
@@ -820,11 +1355,15 @@ void Extension::Initialize()
     }
 }
 
-void Extension::PollDataForSending(jsoncons::json& json, const std::vector<std::string>& topics, const std::string& args, void* client)
+bool Extension::PollDataForSending(jsoncons::json& json, std::span<const std::string_view> topics, const char* args, void* client)
 {
+    bool delayed = false;
+
     for (auto&& topic : topics)
     {
-        if (!datasources.count(topic))
+        auto it = datasources.find(topic);
+
+        if (it == datasources.end())
         {
             auto m = fmt::format("Unknown topic {} requested in extension {}", topic, name);  // + " by widget " + widgetName;
             json["errors"].push_back(m);
@@ -833,7 +1372,7 @@ void Extension::PollDataForSending(jsoncons::json& json, const std::vector<std::
             continue;
         }
 
-        DataSource&                        dsrc = datasources.at(topic);
+        DataSource&                        dsrc = it->second;
 
         std::lock_guard<std::shared_mutex> lk(dsrc.mutex);
 
@@ -856,10 +1395,13 @@ void Extension::PollDataForSending(jsoncons::json& json, const std::vector<std::
             case GET_DATA_DELAYED:
                 // add to poll queue
                 dsrc.pollqueue.insert(client);
+                delayed = true;
                 break;
             case GET_DATA_SUCCESS:
                 // done. do nothing
                 break;
         }
     }
+
+    return delayed;
 }
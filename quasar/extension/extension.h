@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <condition_variable>
 #include <map>
@@ -7,6 +8,7 @@
 #include <mutex>
 #include <set>
 #include <shared_mutex>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -15,10 +17,15 @@
 #include "common/config.h"
 #include "common/settings.h"
 #include "common/timer.h"
+#include "common/util.h"
+#include "server/protocol.h"
 
 #include <jsoncons/json.hpp>
 
+class HistoryRing;
 class Server;
+class TimeSeriesStore;
+struct quasar_shm_slot_t;
 
 using SettingsVariantVector = std::vector<Settings::SettingsVariant>;
 
@@ -41,6 +48,33 @@ struct DataCache
         expiry;  //!< Expiry time of cached data \sa quasar_data_source_t.rate, quasar_data_source_t.validtime, quasar_polling_type_t
 };
 
+//! Struct containing publishing statistics for a Data Source
+struct DataSourceStats
+{
+    uint64_t published  = 0;  //!< Number of payloads published
+    uint64_t suppressed = 0;  //!< Number of unchanged payloads skipped by publish-on-change
+    uint64_t bytes      = 0;  //!< Total bytes published
+
+    uint64_t compressed = 0;  //!< Number of payloads sent with compression
+    uint64_t sampledIn  = 0;  //!< Uncompressed bytes of sampled payloads
+    uint64_t sampledOut = 0;  //!< Compressed bytes of sampled payloads
+    uint64_t sampledNs  = 0;  //!< Time spent compressing sampled payloads
+    uint64_t samples    = 0;  //!< Number of sampled payloads
+};
+
+//! Receives the data of Data Sources within the process, as it is retrieved
+class DataTap
+{
+public:
+    virtual ~DataTap() = default;
+
+    //! Invoked with the Data Source's lock held, on the thread that retrieved the data
+    /*! \param[in]  topic   Topic identifier
+        \param[in]  data    Data of the topic, only valid for the duration of the call
+    */
+    virtual void OnData(std::string_view topic, const jsoncons::json& data) = 0;
+};
+
 //! Struct containing internal resources for a Data Source
 struct DataSource
 {
@@ -55,7 +89,7 @@ struct DataSource
 
     // subscription type source fields
     std::unique_ptr<Timer> timer;        //!< Timer for timer based subscription sources
-    int                    subscribers;  //!< Number of subscribers currently subscribed to this source
+    int                    subscribers;  //!< Number of active (not paused) subscribers currently subscribed to this source
 
     // poll type
     std::unordered_set<void*> pollqueue;  //!< Queue of widgets (i.e. its WebSocket instance) waiting for polled data
@@ -65,8 +99,33 @@ struct DataSource
 
     std::string               buffer;
 
+    // publish-on-change fields
+    size_t                                lastHash{};     //!< Hash of the last published payload
+    std::chrono::steady_clock::time_point lastPublish{};  //!< Time of the last publish
+    DataSourceStats                       stats{};        //!< Publishing statistics
+
+    // delta encoding fields
+    std::array<int, DELTA_MAX>            channels{};       //!< Number of subscribers on each delta channel \sa DeltaMode
+    std::array<int, DELTA_MAX>            paused{};         //!< Number of paused subscribers on each delta channel
+    std::array<std::string, DELTA_MAX>    channelTopics{};  //!< Topic of each delta channel
+    jsoncons::json                        lastDocument{jsoncons::json::null()};  //!< Last document sent on delta channels
+    uint64_t                              deltaSeq{};       //!< Sequence number of the last delta message
+    std::chrono::steady_clock::time_point lastSnapshot{};   //!< Time of the last full snapshot sent on delta channels
+
     // signaled type source fields
     std::unique_ptr<DataLock> locks;  //!< Mutex/cv for asynchronous or extension signaled sources \sa DataLock
+
+    // shared memory fields
+    quasar_shm_slot_t*           mirror{};  //!< Shared memory slot the latest data is mirrored to \sa SharedMirror
+
+    // history fields
+    std::unique_ptr<HistoryRing> history{};  //!< Latest samples sent to new subscribers that ask for a backfill
+
+    // archive fields
+    TimeSeriesStore*             archive{};  //!< Store numeric data is recorded to \sa Settings::DataSourceSettings::archive
+
+    // in-process consumer fields
+    std::vector<DataTap*>        taps{};  //!< In-process consumers, which keep the source running like subscribers
 };
 
 class Extension
@@ -80,7 +139,7 @@ class Extension
     };
 
     //! Shorthand for datasources type
-    using DataSourceMapType = std::unordered_map<std::string, DataSource>;
+    using DataSourceMapType = std::unordered_map<std::string, DataSource, Util::StringHash, std::equal_to<>>;
 
 public:
     //! Shorthand type for quasar_extension_load()
@@ -122,11 +181,11 @@ public:
     /*! Called when the extension receives a widget "poll" request
         \param[in,out]  json        JSON data
         \param[in]      topics      Topics
-        \param[in]      args        Any arguments passed to the Data Source, if accepted
+        \param[in]      args        Null terminated arguments passed to the Data Source if accepted, or nullptr
         \param[in]      client      Requesting widget's websocket connection instance
-        \param[in]      widgetName  Widget name
+        \return true if the data of a topic is sent later, once its Data Source signals it
     */
-    void PollDataForSending(jsoncons::json& json, const std::vector<std::string>& topics, const std::string& args, void* client);
+    bool PollDataForSending(jsoncons::json& json, std::span<const std::string_view> topics, const char* args, void* client);
 
     /*! Gets extension identifier
     \return extension identifier
@@ -138,35 +197,65 @@ public:
     */
     bool IsInternal() const { return internal; };
 
+    /*! Gets the identifiers of all Topics of this extension
+        \return Topic identifiers
+    */
+    std::vector<std::string> GetTopics() const;
+
     /*! Checks to see whether a Topic exists
         \param[in]  topic   Topic identifier
         \return Topic exists
     */
-    bool TopicExists(const std::string& topic) const;
+    bool TopicExists(std::string_view topic) const;
 
     /*! Checks to see whether a Topic accepts subscribers
         \param[in]  topic   Topic identifier
         \return Topic accepts subscribers
     */
-    bool TopicAcceptsSubscribers(const std::string& topic);
+    bool TopicAcceptsSubscribers(std::string_view topic);
 
     //! Adds a subscriber to a Data Source
     /*!
         \param[in]  subscriber  Subscriber's websocket connection instance
-        \param[in]  topic       Topic
-        \param[in]  count       Current subscriber count
+        \param[in]  channel     Topic, optionally suffixed by a delta channel \sa DeltaChannelSuffix()
+        \param[in]  count       Current subscriber count of the channel
         \param[in]  widgetName  Widget name
         \return true if successful, false otherwise
     */
-    bool AddSubscriber(void* subscriber, const std::string& topic, int count);
+    bool AddSubscriber(void* subscriber, const std::string& channel, int count);
 
     //! Removes a subscriber from a Data Sources
-    /*! Invoked when a widget is closed or disconnects
+    /*! Invoked when a widget unsubscribes, is closed or disconnects
         \param[in]  subscriber  Subscriber's websocket connection instance
-        \param[in]  topic       Topic
-        \param[in]  count       Current subscriber count
+        \param[in]  channel     Topic, optionally suffixed by a delta channel \sa DeltaChannelSuffix()
+        \param[in]  count       Current subscriber count of the channel
+        \param[in]  wasPaused   The subscriber was paused
+    */
+    void RemoveSubscriber(void* subscriber, const std::string& channel, int count, bool wasPaused = false);
+
+    //! Pauses or resumes a subscriber of a Data Source
+    /*! Paused subscribers stay subscribed, but do not count towards the active
+        subscribers that keep a Data Source's timer running
+        \param[in]  channel     Topic, optionally suffixed by a delta channel \sa DeltaChannelSuffix()
+        \param[in]  paused      Pause the subscriber if true, resume it otherwise
+    */
+    void                   SetSubscriberPaused(const std::string& channel, bool paused);
+
+    //! Adds an in-process consumer of a Data Source
+    /*! The tap receives every data retrieved by the source, and keeps it running like a subscriber.
+        \param[in]  topic   Topic identifier
+        \param[in]  tap     Consumer, which must be removed before it is destroyed
+        \return true if successful, false if the topic does not exist or does not accept subscribers
+        \sa RemoveTap()
+    */
+    bool                   AddTap(std::string_view topic, DataTap* tap);
+
+    //! Removes an in-process consumer of a Data Source
+    /*! Once this returns, the tap is no longer invoked
+        \param[in]  topic   Topic identifier
+        \param[in]  tap     Consumer added with AddTap()
     */
-    void                   RemoveSubscriber(void* subscriber, const std::string& topic, int count);
+    void                   RemoveTap(std::string_view topic, DataTap* tap);
 
     SettingsVariantVector& GetSettings() { return settings; };
 
@@ -177,6 +266,41 @@ public:
     */
     void GetMetadataJSON(jsoncons::json& json, bool settings_only);
 
+    /*! Crafts a delta snapshot message holding the last document sent on a topic's delta channels
+        \param[in]  topic   Topic identifier
+        \return The snapshot message, or an empty string if no document is available
+        \sa DeltaMode
+    */
+    std::string CraftDeltaSnapshot(std::string_view topic);
+
+    /*! Crafts a history message holding the latest samples of a topic
+        \param[in]  topic   Topic identifier
+        \param[in]  count   Maximum number of samples
+        \return The history message, or an empty string if the topic keeps no history
+        \sa HistoryRing
+    */
+    std::string CraftHistory(std::string_view topic, size_t count);
+
+    /*! Releases cached values of all Data Sources to relieve memory pressure
+        Poll caches are refetched and delta channels restart with a snapshot on their next publish.
+        \return Number of cached values released
+    */
+    size_t TrimCaches();
+
+    /*! Checks whether a payload of a Topic should be compressed
+        \param[in]  topic   Topic identifier
+        \param[in]  size    Payload size in bytes
+        \return Payload should be compressed
+    */
+    bool CompressesTopic(std::string_view topic, size_t size) const;
+
+    //! Gets publishing statistics of all Data Sources as a JSON object
+    /*!
+        \param[in,out]  json        JSON data
+        \sa DataSourceStats
+    */
+    void GetMetricsJSON(jsoncons::json& json);
+
     /*! Handles a data ready signal sent by the extension (by async-polled and signaled sources)
         \param[in]  source  Data Source identifier
         \sa quasar_polling_type_t, quasar_signal_data_ready()
@@ -237,11 +361,12 @@ private:
     /*! Retrieves data from a data source and saves it to the supplied JSON object as JSON data
         \param[in]  msg     Reference to the JSON object to save data to
         \param[in]  src     Reference to the Data Source object
-        \param[in]  args    Arguments, if any
+        \param[in]  args        Arguments, if any
+        \param[in]  quantize    Whether to quantize the data, otherwise left to the caller \sa Quantize::Apply()
         \return DataSourceReturnState value determining state of data retrieval
         \sa DataSourceReturnState
     */
-    DataSourceReturnState getDataFromSource(jsoncons::json& msg, DataSource& src, std::string args = {});
+    DataSourceReturnState getDataFromSource(jsoncons::json& msg, DataSource& src, const char* args = nullptr, bool quantize = true);
 
     //! Retrieves data from the extension and sends it to all subscribers
     /*! Called when extension data is ready to be sent (by both timer and signal)
@@ -249,6 +374,29 @@ private:
     */
     void sendDataToSubscribers(DataSource& src);
 
+    //! Sends merge patches or JSON patches of a new message to delta channel subscribers
+    /*! Sends a full snapshot instead if none has been sent recently
+        \param[in]  src     Data Source
+        \param[in]  msg     Message containing the new document
+        \sa DeltaMode
+    */
+    void publishDeltas(DataSource& src, const jsoncons::json& msg);
+
+    //! Publishes a message to every channel of a Data Source that has subscribers
+    /*! \param[in]  src     Data Source
+        \param[in]  payload Message to publish
+    */
+    void publishToChannels(DataSource& src, const std::string& payload);
+
+    //! Applies a Data Source's compression policy to an outgoing payload
+    /*! Periodically measures the payload's compression ratio and cost for metrics.
+        Must be called with the Data Source lock held exclusively.
+        \param[in]  src     Data Source
+        \param[in]  payload Outgoing payload
+        \return Payload should be compressed
+    */
+    bool compressPayload(DataSource& src, const std::string& payload);
+
     /*! Creates and initializes the timer for a timer-based source (if it does not exist)
         \param[in,out]  src     Reference to the Data Source object
         \sa DataSource.timer
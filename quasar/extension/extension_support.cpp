@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <limits>
 
 #include "api/extension_support.h"
 
@@ -8,6 +9,8 @@
 #include "extension_support_internal.h"
 
 #include "common/util.h"
+#include "server/server.h"
+#include "server/topicbus.h"
 
 #include <fmt/core.h>
 #include <spdlog/spdlog.h>
@@ -627,6 +630,179 @@ bool quasar_get_storage_bool(quasar_ext_handle handle, const char* name, bool* b
     return _get_basic_storage(handle, name, buf);
 }
 
+size_t quasar_subscribe_topic(quasar_ext_handle handle, const char* topic, quasar_topic_callback_t callback, void* userdata)
+{
+    Extension* ext = static_cast<Extension*>(handle);
+
+    if (ext and topic)
+    {
+        return ext->GetServer()->GetTopicBus().Subscribe(ext, topic, callback, userdata);
+    }
+
+    return 0;
+}
+
+void quasar_unsubscribe_topic(quasar_ext_handle handle, size_t subscription)
+{
+    Extension* ext = static_cast<Extension*>(handle);
+
+    if (ext)
+    {
+        ext->GetServer()->GetTopicBus().Unsubscribe(ext, subscription);
+    }
+}
+
+quasar_value_type_t quasar_get_value_type(quasar_value_handle value)
+{
+    const jsoncons::json* j = static_cast<const jsoncons::json*>(value);
+
+    if (!j)
+    {
+        return QUASAR_VALUE_NULL;
+    }
+
+    if (j->is_bool())
+    {
+        return QUASAR_VALUE_BOOL;
+    }
+
+    if (j->is_int64() or j->is_uint64())
+    {
+        return QUASAR_VALUE_INT;
+    }
+
+    if (j->is_double())
+    {
+        return QUASAR_VALUE_DOUBLE;
+    }
+
+    if (j->is_string())
+    {
+        return QUASAR_VALUE_STRING;
+    }
+
+    if (j->is_array())
+    {
+        return QUASAR_VALUE_ARRAY;
+    }
+
+    if (j->is_object())
+    {
+        return QUASAR_VALUE_OBJECT;
+    }
+
+    return QUASAR_VALUE_NULL;
+}
+
+bool quasar_get_value_bool(quasar_value_handle value, bool* buf)
+{
+    const jsoncons::json* j = static_cast<const jsoncons::json*>(value);
+
+    if (j and buf and j->is_bool())
+    {
+        *buf = j->as<bool>();
+        return true;
+    }
+
+    return false;
+}
+
+template<typename T>
+bool _get_value_number(quasar_value_handle value, T* buf)
+    requires std::is_same_v<double, T> || std::is_same_v<intmax_t, T>
+{
+    const jsoncons::json* j = static_cast<const jsoncons::json*>(value);
+
+    if (j and buf and j->is_number())
+    {
+        *buf = j->is_double() ? static_cast<T>(j->as<double>()) : j->as<T>();
+        return true;
+    }
+
+    return false;
+}
+
+bool quasar_get_value_int(quasar_value_handle value, intmax_t* buf)
+{
+    return _get_value_number(value, buf);
+}
+
+bool quasar_get_value_double(quasar_value_handle value, double* buf)
+{
+    return _get_value_number(value, buf);
+}
+
+bool quasar_get_value_string(quasar_value_handle value, char* buf, size_t size)
+{
+    const jsoncons::json* j = static_cast<const jsoncons::json*>(value);
+
+    if (j and buf and size and j->is_string())
+    {
+        auto val = j->as_string_view();
+
+        if (size <= val.length())
+        {
+            SPDLOG_WARN("Buffer size for retrieving value too small!");
+            return false;
+        }
+
+        std::memcpy(buf, val.data(), val.length());
+        buf[val.length()] = 0;
+        return true;
+    }
+
+    return false;
+}
+
+size_t quasar_get_value_double_array(quasar_value_handle value, double* buf, size_t size)
+{
+    const jsoncons::json* j = static_cast<const jsoncons::json*>(value);
+
+    if (!j or !buf or !j->is_array())
+    {
+        return 0;
+    }
+
+    const size_t count = std::min(size, j->size());
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto& element = j->at(i);
+        buf[i]              = element.is_number() ? element.as<double>() : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    return count;
+}
+
+size_t quasar_get_value_size(quasar_value_handle value)
+{
+    const jsoncons::json* j = static_cast<const jsoncons::json*>(value);
+
+    if (j and (j->is_array() or j->is_object()))
+    {
+        return j->size();
+    }
+
+    return 0;
+}
+
+quasar_value_handle quasar_get_value_element(quasar_value_handle value, size_t index)
+{
+    const jsoncons::json* j = static_cast<const jsoncons::json*>(value);
+
+    if (j and j->is_array() and index < j->size())
+    {
+        return &j->at(index);
+    }
+
+    return nullptr;
+}
+
+quasar_value_handle quasar_get_value_member(quasar_value_handle value, const char* name)
+{
+    return name ? quasar_get_value_member_hpp(value, name) : nullptr;
+}
+
 quasar_data_handle quasar_set_data_string_hpp(quasar_data_handle hData, std::string_view data)
 {
     quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
@@ -766,3 +942,58 @@ std::string_view quasar_get_selection_setting_hpp(quasar_ext_handle handle, quas
 
     return std::string_view();
 }
+
+size_t quasar_subscribe_topic_hpp(quasar_ext_handle handle, std::string_view topic, quasar_topic_callback_t callback, void* userdata)
+{
+    Extension* ext = static_cast<Extension*>(handle);
+
+    if (ext)
+    {
+        return ext->GetServer()->GetTopicBus().Subscribe(ext, topic, callback, userdata);
+    }
+
+    return 0;
+}
+
+std::string_view quasar_get_value_string_hpp(quasar_value_handle value)
+{
+    const jsoncons::json* j = static_cast<const jsoncons::json*>(value);
+
+    if (j and j->is_string())
+    {
+        return j->as_string_view();
+    }
+
+    return std::string_view();
+}
+
+quasar_value_handle quasar_get_value_member_hpp(quasar_value_handle value, std::string_view name)
+{
+    const jsoncons::json* j = static_cast<const jsoncons::json*>(value);
+
+    if (j and j->is_object())
+    {
+        auto it = j->find(name);
+
+        if (it != j->object_range().end())
+        {
+            return &it->value();
+        }
+    }
+
+    return nullptr;
+}
+
+std::string quasar_get_value_json_hpp(quasar_value_handle value)
+{
+    const jsoncons::json* j = static_cast<const jsoncons::json*>(value);
+
+    std::string           out;
+
+    if (j)
+    {
+        j->dump(out);
+    }
+
+    return out;
+}
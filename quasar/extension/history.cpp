@@ -0,0 +1,75 @@
+#include "history.h"
+
+#include <algorithm>
+
+#include <fmt/core.h>
+
+HistoryRing::HistoryRing(size_t samples, int64_t age) :
+    maxSamples{std::max<size_t>(samples, 1)},
+    maxAge{age}
+{}
+
+void HistoryRing::SetLimits(size_t samples, int64_t age)
+{
+    maxSamples = std::max<size_t>(samples, 1);
+    maxAge     = age;
+
+    if (!entries.empty())
+    {
+        trim(entries.back().time);
+    }
+}
+
+void HistoryRing::Push(int64_t time, std::string_view value)
+{
+    entries.push_back({base + buffer.size(), time});
+
+    fmt::format_to(std::back_inserter(buffer), "[{},{}],", time, value);
+
+    trim(time);
+}
+
+size_t HistoryRing::AppendTo(std::string& out, size_t count) const
+{
+    count = std::min(count, entries.size());
+
+    out.push_back('[');
+
+    if (count)
+    {
+        const size_t start = entries[entries.size() - count].offset - base;
+
+        // Leaves out the comma following the newest sample
+        out.append(buffer, start, buffer.size() - start - 1);
+    }
+
+    out.push_back(']');
+
+    return count;
+}
+
+void HistoryRing::Clear()
+{
+    entries.clear();
+    buffer.clear();
+    buffer.shrink_to_fit();
+    base = 0;
+}
+
+void HistoryRing::trim(int64_t now)
+{
+    while (entries.size() > maxSamples or (maxAge > 0 and !entries.empty() and now - entries.front().time > maxAge))
+    {
+        entries.pop_front();
+    }
+
+    const uint64_t start = entries.empty() ? base + buffer.size() : entries.front().offset;
+    const size_t   dead  = start - base;
+
+    // Amortizes the move of the remaining samples over the dropped ones
+    if (dead > 0 and dead >= buffer.size() / 2)
+    {
+        buffer.erase(0, dead);
+        base = start;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+//! Bounded history of the serialized samples of a Data Source
+/*! Samples are stored as \c [time,value] JSON pairs, separated by commas, in a single
+    contiguous buffer. Any run of the newest samples is therefore already a valid
+    JSON array body, and is sent to a client with a single append.
+    Not thread safe, guarded by the Data Source lock.
+*/
+class HistoryRing
+{
+public:
+    //! \param[in]  samples     Maximum number of samples kept
+    //! \param[in]  age         Maximum age of samples in ms, 0 for no limit
+    HistoryRing(size_t samples, int64_t age);
+
+    //! Changes the limits, dropping samples that exceed them
+    void   SetLimits(size_t samples, int64_t age);
+
+    //! Appends a sample
+    /*! \param[in]  time    Sample time in ms since the Unix epoch
+        \param[in]  value   Serialized JSON value
+    */
+    void   Push(int64_t time, std::string_view value);
+
+    //! Appends the newest samples as a JSON array to \p out
+    /*! \param[in,out]  out     Output string
+        \param[in]      count   Maximum number of samples
+        \return Number of samples appended
+    */
+    size_t AppendTo(std::string& out, size_t count) const;
+
+    //! Drops all samples and releases the buffer
+    void   Clear();
+
+    size_t Size() const { return entries.size(); }
+
+private:
+    struct Entry
+    {
+        uint64_t offset;  //!< Position of the sample in the stream of all samples pushed
+        int64_t  time;    //!< Sample time in ms since the Unix epoch
+    };
+
+    //! Drops samples over the limits, and compacts the buffer once half of it is dropped
+    void trim(int64_t now);
+
+    std::string       buffer{};   //!< Serialized samples, each followed by a comma
+    uint64_t          base = 0;   //!< Stream position of the start of the buffer
+    std::deque<Entry> entries{};  //!< Samples from the oldest to the newest
+
+    size_t            maxSamples;
+    int64_t           maxAge;
+};
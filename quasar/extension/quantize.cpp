@@ -0,0 +1,122 @@
+#include "quantize.h"
+
+#include "common/settings.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    bool isNumericArray(const jsoncons::json& value)
+    {
+        if (!value.is_array() or value.empty())
+        {
+            return false;
+        }
+
+        auto range = value.array_range();
+
+        return std::all_of(range.begin(), range.end(), [](const jsoncons::json& v) {
+            return v.is_number();
+        });
+    }
+
+    void roundArray(jsoncons::json& value, int precision)
+    {
+        const double scale = std::pow(10.0, std::clamp(precision, 0, 15));
+
+        for (auto&& v : value.array_range())
+        {
+            if (v.is_double())
+            {
+                v = std::round(v.as<double>() * scale) / scale;
+            }
+        }
+    }
+
+    template<typename T>
+    jsoncons::json packArray(const jsoncons::json& value, const char* type)
+    {
+        constexpr double levels = std::numeric_limits<T>::max();
+
+        std::vector<double> vals;
+        vals.reserve(value.size());
+
+        for (auto&& v : value.array_range())
+        {
+            vals.push_back(v.as<double>());
+        }
+
+        const auto [mn, mx] = std::ranges::minmax(vals);
+        const double range  = mx - mn;
+        const double scale  = (range > 0.0) ? (levels / range) : 0.0;
+
+        // Little endian byte block
+        std::vector<uint8_t> bytes;
+        bytes.reserve(vals.size() * sizeof(T));
+
+        for (auto&& v : vals)
+        {
+            T q = static_cast<T>(std::lround((v - mn) * scale));
+
+            for (size_t b = 0; b < sizeof(T); b++)
+            {
+                bytes.push_back(static_cast<uint8_t>(q >> (b * 8)));
+            }
+        }
+
+        std::string data{};
+        jsoncons::encode_base64(bytes.begin(), bytes.end(), data);
+
+        return jsoncons::json{
+            jsoncons::json_object_arg,
+            {{"quantized", type}, {"min", mn}, {"max", mx}, {"length", vals.size()}, {"data", data}}
+        };
+    }
+}  // namespace
+
+void Quantize::Apply(jsoncons::json& value, int mode, int precision)
+{
+    if (mode == Settings::Quantization::full)
+    {
+        return;
+    }
+
+    if (isNumericArray(value))
+    {
+        switch (mode)
+        {
+            case Settings::Quantization::fixed:
+                roundArray(value, precision);
+                break;
+            case Settings::Quantization::norm16:
+                value = packArray<uint16_t>(value, "u16");
+                break;
+            case Settings::Quantization::norm8:
+                value = packArray<uint8_t>(value, "u8");
+                break;
+            default:
+                break;
+        }
+
+        return;
+    }
+
+    if (value.is_object())
+    {
+        for (auto&& member : value.object_range())
+        {
+            Apply(member.value(), mode, precision);
+        }
+    }
+    else if (value.is_array())
+    {
+        for (auto&& v : value.array_range())
+        {
+            Apply(v, mode, precision);
+        }
+    }
+}
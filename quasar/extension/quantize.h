@@ -0,0 +1,28 @@
+#pragma once
+
+#include <jsoncons/json.hpp>
+
+//! Lossy quantization of numeric arrays in Data Source payloads
+namespace Quantize
+{
+    //! Quantizes every numeric array found in a payload in place
+    /*! Objects and nested arrays are traversed recursively. Arrays that contain
+        anything other than numbers are left untouched.
+
+        With \ref Settings::Quantization::fixed, values are rounded to \p precision
+        decimal places so they serialize as short fixed-precision text.
+
+        With \ref Settings::Quantization::norm16 and \ref Settings::Quantization::norm8,
+        values are mapped onto the array's [min, max] range and the array is replaced
+        by a compact binary block object:
+
+        \verbatim
+        {"quantized": "u16", "min": <min>, "max": <max>, "length": <n>, "data": <base64 little endian>}
+        \endverbatim
+
+        \param[in,out]  value       Payload to quantize
+        \param[in]      mode        Quantization mode \sa Settings::Quantization
+        \param[in]      precision   Decimal places for \ref Settings::Quantization::fixed
+    */
+    void Apply(jsoncons::json& value, int mode, int precision);
+}  // namespace Quantize
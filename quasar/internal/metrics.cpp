@@ -0,0 +1,102 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+#include "api/extension_support.hpp"
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    std::unordered_map<std::string, MetricsProvider> providers;
+    std::mutex                                       providerMutex;
+
+    quasar_data_source_t                             sources[] = {
+        {"server",  QUASAR_POLLING_CLIENT, 0, 0},
+        {"widgets", QUASAR_POLLING_CLIENT, 0, 0}
+    };
+
+    bool metrics_init(quasar_ext_handle handle)
+    {
+        return true;
+    }
+
+    bool metrics_shutdown(quasar_ext_handle handle)
+    {
+        return true;
+    }
+
+    bool metrics_get_data(size_t srcUid, quasar_data_handle hData, char* args)
+    {
+        auto src = std::find_if(std::begin(sources), std::end(sources), [=](const quasar_data_source_t& s) {
+            return s.uid == srcUid;
+        });
+
+        if (src == std::end(sources))
+        {
+            SPDLOG_WARN("Unknown source {}", srcUid);
+            return false;
+        }
+
+        jsoncons::json j{jsoncons::json_object_arg};
+
+        {
+            std::lock_guard<std::mutex> lk(providerMutex);
+
+            auto                        it = providers.find(src->name);
+
+            if (it == providers.end())
+            {
+                auto m = fmt::format("No metrics available for '{}'", src->name);
+                SPDLOG_WARN(m);
+                quasar_append_error(hData, m.c_str());
+                return false;
+            }
+
+            it->second(j);
+        }
+
+        std::string res{};
+        j.dump(res);
+
+        quasar_set_data_json_hpp(hData, res);
+
+        return true;
+    }
+
+    quasar_ext_info_fields_t fields = {"metrics", "Metrics", "3.0", "r52", "Runtime metrics internal extension for Quasar", "https://github.com/r52/quasar"};
+
+    quasar_ext_info_t        info   = {QUASAR_API_VERSION,
+                 &fields,
+
+                 std::size(sources),
+                 sources,
+
+                 metrics_init,      // init
+                 metrics_shutdown,  // shutdown
+                 metrics_get_data,  // data
+                 nullptr,
+                 nullptr};
+
+}  // namespace
+
+void metrics_add_provider(const std::string& name, MetricsProvider&& provider)
+{
+    std::lock_guard<std::mutex> lk(providerMutex);
+    providers[name] = std::move(provider);
+}
+
+void metrics_remove_provider(const std::string& name)
+{
+    std::lock_guard<std::mutex> lk(providerMutex);
+    providers.erase(name);
+}
+
+quasar_ext_info_t* metrics_load(void)
+{
+    return &info;
+}
+
+void metrics_destroy(quasar_ext_info_t* info) {}
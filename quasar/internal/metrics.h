@@ -0,0 +1,21 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "api/extension_types.h"
+
+#include <jsoncons/json.hpp>
+
+//! Function that fills in the metrics of a subsystem
+using MetricsProvider = std::function<void(jsoncons::json&)>;
+
+//! Registers a metrics provider for the Data Source of the same name (e.g. "server" for metrics/server)
+void               metrics_add_provider(const std::string& name, MetricsProvider&& provider);
+
+//! Removes a previously registered metrics provider
+void               metrics_remove_provider(const std::string& name);
+
+quasar_ext_info_t* metrics_load(void);
+
+void               metrics_destroy(quasar_ext_info_t* info);
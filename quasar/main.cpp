@@ -1,8 +1,12 @@
 #include "quasar.h"
 
+#include "common/config.h"
+#include "common/qutil.h"
+#include "common/settings.h"
 #include "common/update.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QSettings>
 #include <QSplashScreen>
 
@@ -16,11 +20,59 @@ int main(int argc, char* argv[])
 
     QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
 
+    // Profiles keep separate settings and data, so that several instances can run side by side
+    QCommandLineParser parser;
+    QCommandLineOption profileOption("profile", "Use a separate settings and data profile.", "name");
+    parser.addOption(profileOption);
+
+    // Topic logs reproduce a session without its Data Sources \sa TopicRecorder, TopicReplayer
+    QCommandLineOption recordOption("record", "Record published topics to a topic log.", "file");
+    QCommandLineOption recordTopicsOption("record-topics", "Topics to record, comma separated. Wildcards are allowed.", "topics");
+    QCommandLineOption replayOption("replay", "Replay a topic log instead of loading extensions.", "file");
+    QCommandLineOption replaySpeedOption("replay-speed", "Replay speed factor, or max for as fast as possible.", "factor", "1");
+    QCommandLineOption replayLoopOption("replay-loop", "Start the replay over when it ends.");
+    parser.addOptions({recordOption, recordTopicsOption, replayOption, replaySpeedOption, replayLoopOption});
+
+    QStringList arguments;
+    for (int i = 0; i < argc; i++)
+    {
+        arguments << QString::fromLocal8Bit(argv[i]);
+    }
+
+    // Unknown arguments are left to Qt and Chromium
+    parser.parse(arguments);
+
+    Settings::launch.record        = parser.value(recordOption).toStdString();
+    Settings::launch.record_topics = parser.value(recordTopicsOption).toStdString();
+    Settings::launch.replay        = parser.value(replayOption).toStdString();
+    Settings::launch.replay_loop   = parser.isSet(replayLoopOption);
+
+    if (auto speed = parser.value(replaySpeedOption); speed == "max")
+    {
+        Settings::launch.replay_speed = 0;
+    }
+    else
+    {
+        bool ok = false;
+        Settings::launch.replay_speed = speed.toDouble(&ok);
+
+        if (!ok or Settings::launch.replay_speed <= 0)
+        {
+            Settings::launch.replay_speed = 1;
+        }
+    }
+
     // Set settings type/path
     QCoreApplication::setOrganizationName("quasar");
-    QCoreApplication::setApplicationName("quasar");
+    QCoreApplication::setApplicationName(parser.isSet(profileOption) ? "quasar-" + parser.value(profileOption) : "quasar");
     QSettings::setDefaultFormat(QSettings::IniFormat);
 
+    // Chromium flags must be set before QtWebEngine starts
+    {
+        Config cfg;
+        QUtil::ApplyRendererProcessModel();
+    }
+
     QApplication a(argc, argv);
     a.setQuitOnLastWindowClosed(false);
 
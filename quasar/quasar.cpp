@@ -3,6 +3,7 @@
 
 #include "common/config.h"
 #include "common/log.h"
+#include "common/pressure.h"
 #include "common/qutil.h"
 #include "common/update.h"
 #include "common/util.h"
@@ -24,6 +25,7 @@
 #include <QStandardPaths>
 #include <QSysInfo>
 #include <QUrl>
+#include <QWebEngineProfile>
 #include <QWebEngineView>
 
 #include <semver/semver.hpp>
@@ -75,6 +77,11 @@ Quasar::Quasar(QWidget* parent) : QMainWindow(parent), updateManager(new QNetwor
     ui.logEdit->document()->setMaximumBlockCount(200);
     initializeLogger(ui.logEdit);
 
+    if (auto flags = qgetenv("QTWEBENGINE_CHROMIUM_FLAGS"); !flags.isEmpty())
+    {
+        SPDLOG_INFO("Chromium flags: {}", flags.toStdString());
+    }
+
     // Initialize late components
     server  = std::make_shared<Server>(config);
     manager = std::make_shared<WidgetManager>(server, config);
@@ -122,6 +129,38 @@ Quasar::Quasar(QWidget* parent) : QMainWindow(parent), updateManager(new QNetwor
     {
         checkForUpdates();
     }
+
+    pressureMonitor = std::make_unique<MemoryPressureMonitor>([this](MemoryPressureMonitor::Level level) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, level] {
+                relieveMemoryPressure(level);
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void Quasar::relieveMemoryPressure(int level)
+{
+    SPDLOG_WARN("{} memory pressure detected", MemoryPressureMonitor::LevelName(static_cast<MemoryPressureMonitor::Level>(level)));
+
+    // Stage 1: cached Data Source values
+    auto trimmed = server->TrimCaches();
+    SPDLOG_INFO("Released {} cached Data Source values", trimmed);
+
+    // Stage 2: web engine caches
+    if (level >= MemoryPressureMonitor::SEVERE)
+    {
+        QWebEngineProfile::defaultProfile()->clearHttpCache();
+        SPDLOG_INFO("Cleared web engine HTTP cache");
+    }
+
+    // Stage 3: least recently used widgets
+    if (level >= MemoryPressureMonitor::CRITICAL)
+    {
+        auto suspended = manager->ReclaimWidgets();
+        SPDLOG_INFO("Suspended {} least recently used widgets", suspended);
+    }
 }
 
 void Quasar::initializeLogger(QTextEdit* edit)
@@ -512,6 +551,9 @@ Quasar::~Quasar()
         cfgdlg->done(QDialog::Rejected);
     }
 
+    // Stop reacting to memory pressure before tearing down
+    pressureMonitor.reset();
+
     manager.reset();
     server.reset();
     config.reset();
@@ -7,6 +7,7 @@
 #include <QtWidgets/QMainWindow>
 
 class Config;
+class MemoryPressureMonitor;
 class Server;
 class WidgetManager;
 
@@ -32,6 +33,9 @@ private:
 
     void initializeLogger(QTextEdit* edit);
 
+    //! Trims caches and suspends widgets in stages as memory pressure rises
+    void relieveMemoryPressure(int level);
+
 private slots:
     void openWidget();
     void trayIconActivated(QSystemTrayIcon::ActivationReason reason);
@@ -61,4 +65,6 @@ private:
     std::shared_ptr<Config>        config{};
     std::shared_ptr<Server>        server{};
     std::shared_ptr<WidgetManager> manager{};
+
+    std::unique_ptr<MemoryPressureMonitor> pressureMonitor{};
 };
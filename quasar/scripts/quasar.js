@@ -9,6 +9,728 @@ function quasar_authenticate(socket) {
   socket.send(JSON.stringify(auth));
 }
 
+function quasar_merge_patch(target, patch) {
+  if (patch === null || typeof patch !== "object" || Array.isArray(patch)) {
+    return patch;
+  }
+
+  if (target === null || typeof target !== "object" || Array.isArray(target)) {
+    target = {};
+  }
+
+  for (const key of Object.keys(patch)) {
+    if (patch[key] === null) {
+      delete target[key];
+    } else {
+      target[key] = quasar_merge_patch(target[key], patch[key]);
+    }
+  }
+
+  return target;
+}
+
+function quasar_json_patch(doc, ops) {
+  const split = (path) =>
+    path
+      .split("/")
+      .slice(1)
+      .map((t) => t.replace(/~1/g, "/").replace(/~0/g, "~"));
+
+  const get = (root, tokens) => tokens.reduce((node, t) => node[t], root);
+
+  const put = (root, tokens, value, insert) => {
+    if (tokens.length === 0) {
+      return value;
+    }
+
+    const parent = get(root, tokens.slice(0, -1));
+    const key = tokens[tokens.length - 1];
+
+    if (Array.isArray(parent)) {
+      const idx = key === "-" ? parent.length : parseInt(key, 10);
+      parent.splice(idx, insert ? 0 : 1, value);
+    } else {
+      parent[key] = value;
+    }
+
+    return root;
+  };
+
+  const remove = (root, tokens) => {
+    const parent = get(root, tokens.slice(0, -1));
+    const key = tokens[tokens.length - 1];
+
+    if (Array.isArray(parent)) {
+      parent.splice(parseInt(key, 10), 1);
+    } else {
+      delete parent[key];
+    }
+
+    return root;
+  };
+
+  for (const op of ops) {
+    const path = split(op.path);
+
+    switch (op.op) {
+      case "add":
+        doc = put(doc, path, op.value, true);
+        break;
+      case "replace":
+        doc = put(doc, path, op.value, false);
+        break;
+      case "remove":
+        doc = remove(doc, path);
+        break;
+      case "move": {
+        const from = split(op.from);
+        const value = get(doc, from);
+        doc = put(remove(doc, from), path, value, true);
+        break;
+      }
+      case "copy": {
+        const value = structuredClone(get(doc, split(op.from)));
+        doc = put(doc, path, value, true);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  return doc;
+}
+
+function quasar_apply_delta(socket, docs, data) {
+  if (typeof data !== "string" || !data.startsWith('{"delta"')) {
+    return data;
+  }
+
+  const msg = JSON.parse(data);
+  const delta = msg.delta;
+  const state = docs[delta.topic];
+
+  if (delta.type === "snapshot") {
+    docs[delta.topic] = { seq: delta.seq, doc: delta.data };
+  } else if (state && delta.seq <= state.seq) {
+    // Already part of a newer snapshot
+    return null;
+  } else if (!state || delta.seq !== state.seq + 1) {
+    // Missed a delta; wait for a snapshot
+    delete docs[delta.topic];
+    socket.send(
+      JSON.stringify({ method: "resync", params: { topics: [delta.topic] } }),
+    );
+    return null;
+  } else {
+    state.seq = delta.seq;
+    state.doc =
+      delta.type === "merge"
+        ? quasar_merge_patch(state.doc, delta.data)
+        : quasar_json_patch(state.doc, delta.data);
+  }
+
+  const out = { [delta.topic]: docs[delta.topic].doc };
+
+  if (msg.errors) {
+    out.errors = msg.errors;
+  }
+
+  return JSON.stringify(out);
+}
+
+let quasar_bridge = null;
+
+function quasar_get_bridge() {
+  // One WebChannel per page, shared by every connection
+  if (!quasar_bridge) {
+    quasar_bridge = new Promise((resolve) => {
+      new QWebChannel(qt.webChannelTransport, (channel) =>
+        resolve(channel.objects.quasar),
+      );
+    });
+  }
+
+  return quasar_bridge;
+}
+
+// WebSocket look-alike talking to the Data Server through Quasar's WebChannel
+class QuasarChannelSocket extends EventTarget {
+  static CONNECTING = 0;
+  static OPEN = 1;
+  static CLOSING = 2;
+  static CLOSED = 3;
+
+  constructor() {
+    super();
+
+    this.readyState = QuasarChannelSocket.CONNECTING;
+    this.onopen = null;
+    this.onclose = null;
+    this.onerror = null;
+    this.onmessage = null;
+
+    this._id = 0;
+    this._bridge = null;
+    this._pending = [];
+
+    for (const type of ["open", "close", "error"]) {
+      this.addEventListener(type, (evt) => {
+        const fn = this["on" + type];
+
+        if (fn) {
+          fn.call(this, evt);
+        }
+      });
+    }
+
+    quasar_get_bridge().then((bridge) => {
+      if (this.readyState !== QuasarChannelSocket.CONNECTING) {
+        return;
+      }
+
+      bridge.open((id) => {
+        if (!id) {
+          this._fail();
+          return;
+        }
+
+        this._id = id;
+        this._bridge = bridge;
+
+        this._onmessage = (cid, data) => {
+          if (cid === this._id) {
+            this.dispatchEvent(new MessageEvent("message", { data: data }));
+          }
+        };
+
+        this._onclosed = (cid) => {
+          if (cid === this._id) {
+            this._closed();
+          }
+        };
+
+        bridge.message.connect(this._onmessage);
+        bridge.closed.connect(this._onclosed);
+
+        this.readyState = QuasarChannelSocket.OPEN;
+
+        for (const msg of this._pending) {
+          bridge.send(id, msg);
+        }
+
+        this._pending = [];
+        this.dispatchEvent(new Event("open"));
+      });
+    });
+  }
+
+  send(data) {
+    if (this.readyState === QuasarChannelSocket.CONNECTING) {
+      this._pending.push(data);
+    } else if (this.readyState === QuasarChannelSocket.OPEN) {
+      this._bridge.send(this._id, data);
+    }
+  }
+
+  close() {
+    if (this.readyState === QuasarChannelSocket.OPEN) {
+      this.readyState = QuasarChannelSocket.CLOSING;
+      this._bridge.close(this._id);
+    } else if (this.readyState === QuasarChannelSocket.CONNECTING) {
+      this._closed();
+    }
+  }
+
+  _fail() {
+    this.dispatchEvent(new Event("error"));
+    this._closed();
+  }
+
+  _closed() {
+    if (this.readyState === QuasarChannelSocket.CLOSED) {
+      return;
+    }
+
+    if (this._bridge) {
+      this._bridge.message.disconnect(this._onmessage);
+      this._bridge.closed.disconnect(this._onclosed);
+    }
+
+    this.readyState = QuasarChannelSocket.CLOSED;
+    this.dispatchEvent(new CloseEvent("close", { wasClean: true }));
+  }
+}
+
 function quasar_create_websocket() {
-  return new WebSocket("ws://localhost:%1");
+  // Prefer the in-process channel when Quasar provides one
+  const socket =
+    typeof qt !== "undefined" &&
+    qt.webChannelTransport &&
+    typeof QWebChannel !== "undefined"
+      ? new QuasarChannelSocket()
+      : new WebSocket("ws://localhost:%1");
+  const docs = {};
+  let handler = null;
+
+  // Expand delta messages into full documents before they reach the widget
+  Object.defineProperty(socket, "onmessage", {
+    get() {
+      return handler;
+    },
+    set(fn) {
+      handler = fn;
+    },
+  });
+
+  socket.addEventListener("message", function (evt) {
+    if (!handler) {
+      return;
+    }
+
+    const data = quasar_apply_delta(socket, docs, evt.data);
+
+    if (data === null) {
+      return;
+    }
+
+    handler.call(
+      socket,
+      data === evt.data ? evt : new MessageEvent("message", { data: data }),
+    );
+  });
+
+  return socket;
+}
+
+function quasar_dequantize(value) {
+  if (!value || typeof value !== "object" || !("quantized" in value)) {
+    return value;
+  }
+
+  const bin = atob(value.data);
+  const width = value.quantized === "u16" ? 2 : 1;
+  const levels = width === 2 ? 65535 : 255;
+  const scale = (value.max - value.min) / levels;
+  const out = new Float32Array(value.length);
+
+  for (let i = 0; i < value.length; i++) {
+    let q = bin.charCodeAt(i * width);
+
+    if (width === 2) {
+      q |= bin.charCodeAt(i * width + 1) << 8;
+    }
+
+    out[i] = value.min + q * scale;
+  }
+
+  return out;
+}
+
+// Frames queued this long before their animation frame mean the page is behind
+const QUASAR_BEHIND_MS = 250;
+
+// Animation frames this close together mean the page has caught up
+const QUASAR_CAUGHT_UP_MS = 50;
+
+const QUASAR_MAX_RECONNECT_MS = 30000;
+
+function quasar_first_key(data) {
+  // Keys with escape sequences fall back to a full parse
+  const match = /^\{"([^"\\]*)":/.exec(data);
+  return match ? match[1] : null;
+}
+
+// Client runtime dispatching topics to callbacks once per animation frame
+class QuasarClient {
+  constructor(options = {}) {
+    this.reconnectDelay = options.reconnectDelay ?? 1000;
+    this.onopen = null;
+    this.onclose = null;
+    this.onerror = null;
+
+    this._socket = null;
+    this._closed = false;
+    this._retries = 0;
+
+    this._listeners = new Map();
+    this._subscriptions = new Map();
+    this._paused = new Set();
+    this._queries = [];
+
+    this._frames = new Map();
+    this._history = [];
+    this._frameRequested = false;
+    this._queuedAt = 0;
+    this._backlogged = false;
+
+    this._connect();
+  }
+
+  get connected() {
+    return this._socket !== null && this._socket.readyState === 1;
+  }
+
+  // Calls back with (data, topic) for every update of the topics, and subscribes to them
+  subscribe(topics, callback, options = {}) {
+    topics = [].concat(topics);
+
+    for (const topic of topics) {
+      if (callback) {
+        this.on(topic, callback);
+      }
+
+      this._subscriptions.set(topic, options.delta ?? null);
+    }
+
+    this._sendSubscribe(topics, options.delta, options.backfill);
+  }
+
+  // Removes a callback, and ends the subscriptions that are left without one
+  unsubscribe(topics, callback) {
+    const ended = [];
+
+    for (const topic of [].concat(topics)) {
+      if (callback) {
+        this.off(topic, callback);
+      } else {
+        this._listeners.delete(topic);
+      }
+
+      if (!this._listeners.has(topic) && this._subscriptions.delete(topic)) {
+        this._paused.delete(topic);
+        ended.push(topic);
+      }
+    }
+
+    if (ended.length) {
+      this.send("unsubscribe", { topics: ended });
+    }
+  }
+
+  pause(topics) {
+    topics = [].concat(topics);
+    topics.forEach((topic) => this._paused.add(topic));
+    this.send("pause", { topics: topics });
+  }
+
+  resume(topics) {
+    topics = [].concat(topics);
+    topics.forEach((topic) => this._paused.delete(topic));
+    this.send("resume", { topics: topics });
+  }
+
+  // Listens to a topic without subscribing to it
+  on(topic, callback) {
+    if (!this._listeners.has(topic)) {
+      this._listeners.set(topic, new Set());
+    }
+
+    this._listeners.get(topic).add(callback);
+  }
+
+  off(topic, callback) {
+    const set = this._listeners.get(topic);
+
+    if (set) {
+      set.delete(callback);
+
+      if (!set.size) {
+        this._listeners.delete(topic);
+      }
+    }
+  }
+
+  // Resolves with the data of the topic's reply, resent after a reconnect
+  query(topic, args) {
+    return new Promise((resolve, reject) => {
+      const params = { topics: [topic] };
+
+      if (args !== undefined) {
+        params.args = args;
+      }
+
+      this._queries.push({
+        topic: topic,
+        params: params,
+        resolve: resolve,
+        reject: reject,
+      });
+      this.send("query", params);
+    });
+  }
+
+  send(method, params) {
+    if (this.connected) {
+      this._socket.send(JSON.stringify({ method: method, params: params }));
+    }
+  }
+
+  close() {
+    this._closed = true;
+
+    if (this._socket) {
+      this._socket.close();
+    }
+  }
+
+  _connect() {
+    const socket = quasar_create_websocket();
+    this._socket = socket;
+
+    socket.onopen = () => {
+      this._retries = 0;
+      quasar_authenticate(socket);
+      this._restore();
+
+      if (this.onopen) {
+        this.onopen();
+      }
+    };
+
+    socket.onmessage = (evt) => this._receive(evt.data);
+
+    socket.onclose = () => {
+      if (this._socket !== socket) {
+        return;
+      }
+
+      this._socket = null;
+      this._backlogged = false;
+
+      if (this.onclose) {
+        this.onclose();
+      }
+
+      if (!this._closed) {
+        const delay = Math.min(
+          this.reconnectDelay * 2 ** this._retries++,
+          QUASAR_MAX_RECONNECT_MS,
+        );
+
+        setTimeout(() => this._connect(), delay);
+      }
+    };
+  }
+
+  // Replays subscriptions, pauses and pending queries on a new connection
+  _restore() {
+    const modes = new Map();
+
+    for (const [topic, delta] of this._subscriptions) {
+      if (!modes.has(delta)) {
+        modes.set(delta, []);
+      }
+
+      modes.get(delta).push(topic);
+    }
+
+    for (const [delta, topics] of modes) {
+      this._sendSubscribe(topics, delta);
+    }
+
+    if (this._paused.size) {
+      this.send("pause", { topics: [...this._paused] });
+    }
+
+    for (const query of this._queries) {
+      this.send("query", query.params);
+    }
+  }
+
+  _sendSubscribe(topics, delta, backfill) {
+    const params = { topics: topics };
+
+    if (delta) {
+      params.delta = delta;
+    }
+
+    // Only asked for on the first subscription, history is not replayed on reconnects
+    if (backfill) {
+      params.backfill = backfill;
+    }
+
+    this.send("subscribe", params);
+  }
+
+  _match(topic) {
+    const slash = topic.indexOf("/");
+    const keys = [
+      topic,
+      topic.slice(0, slash) + "/*",
+      "*" + topic.slice(slash),
+    ];
+
+    const out = [];
+
+    for (const key of keys) {
+      const set = this._listeners.get(key);
+
+      if (set) {
+        out.push(...set);
+      }
+    }
+
+    return out;
+  }
+
+  _receive(data) {
+    const key = quasar_first_key(data);
+
+    // Frames of a single topic are only parsed if still wanted when rendering
+    if (
+      key !== null &&
+      key !== "errors" &&
+      key !== "history" &&
+      !data.includes('"errors":') &&
+      !this._queries.some((query) => query.topic === key)
+    ) {
+      if (this._match(key).length) {
+        this._schedule(key, data, false);
+      }
+
+      return;
+    }
+
+    const msg = JSON.parse(data);
+
+    // Backfilled samples are delivered in order, before any later update
+    if (key === "history") {
+      this._history.push(msg.history);
+      this._requestFrame();
+      return;
+    }
+
+    for (const [topic, value] of Object.entries(msg)) {
+      if (topic === "errors") {
+        for (const err of value) {
+          // Errors name the topic they are about
+          const words = err.split(" ");
+          const idx = this._queries.findIndex((query) =>
+            words.includes(query.topic),
+          );
+
+          if (idx >= 0) {
+            this._queries.splice(idx, 1)[0].reject(new Error(err));
+          }
+
+          if (this.onerror) {
+            this.onerror(err);
+          } else {
+            console.warn("Quasar: " + err);
+          }
+        }
+
+        continue;
+      }
+
+      const idx = this._queries.findIndex((query) => query.topic === topic);
+
+      if (idx >= 0) {
+        this._queries.splice(idx, 1)[0].resolve(value);
+      }
+
+      if (this._match(topic).length) {
+        this._schedule(topic, value, true);
+      }
+    }
+  }
+
+  _schedule(topic, payload, parsed) {
+    // Latest frame wins
+    this._frames.set(topic, { payload: payload, parsed: parsed });
+    this._requestFrame();
+  }
+
+  _requestFrame() {
+    if (!this._frameRequested) {
+      this._frameRequested = true;
+      this._queuedAt = performance.now();
+      requestAnimationFrame(() => this._render());
+    }
+  }
+
+  _render() {
+    const lag = performance.now() - this._queuedAt;
+    const frames = this._frames;
+    const history = this._history;
+
+    this._frames = new Map();
+    this._history = [];
+    this._frameRequested = false;
+
+    for (const { topic, samples } of history) {
+      const callbacks = this._match(topic);
+
+      for (const [time, data] of samples) {
+        for (const callback of callbacks) {
+          try {
+            callback(data, topic, time);
+          } catch (e) {
+            console.error(e);
+          }
+        }
+      }
+    }
+
+    for (const [topic, frame] of frames) {
+      const callbacks = this._match(topic);
+
+      if (!callbacks.length) {
+        continue;
+      }
+
+      let data;
+
+      try {
+        data = frame.parsed ? frame.payload : JSON.parse(frame.payload)[topic];
+      } catch (e) {
+        console.error("Quasar: malformed frame for " + topic + ": " + e);
+        continue;
+      }
+
+      for (const callback of callbacks) {
+        try {
+          callback(data, topic);
+        } catch (e) {
+          console.error(e);
+        }
+      }
+    }
+
+    // Hidden pages are not rendered, and are paused by Quasar instead
+    if (!this._backlogged && lag > QUASAR_BEHIND_MS && !document.hidden) {
+      this._applyBackpressure();
+    }
+  }
+
+  // Holds topic frames on the server until animation frames run smoothly again
+  _applyBackpressure() {
+    this._backlogged = true;
+    this.send("backpressure", { args: "on" });
+
+    let last = performance.now();
+
+    const tick = () => {
+      if (!this._backlogged) {
+        return;
+      }
+
+      const now = performance.now();
+
+      if (now - last < QUASAR_CAUGHT_UP_MS) {
+        this._backlogged = false;
+        this.send("backpressure", { args: "off" });
+      } else {
+        last = now;
+        requestAnimationFrame(tick);
+      }
+    };
+
+    requestAnimationFrame(tick);
+  }
+}
+
+function quasar_connect(options) {
+  return new QuasarClient(options);
 }
@@ -0,0 +1,362 @@
+#include "derivedtopics.h"
+
+#include "server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <QString>
+#include <QStringList>
+
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    constexpr std::string_view DERIVED_PREFIX = "derived/";
+
+    //! Parses a window length such as \c 500ms, \c 10s or \c 1m
+    //! \return Length in ms, or 0 if invalid
+    int64_t parseWindow(const QString& text)
+    {
+        int64_t scale  = 1000;
+        QString number = text;
+
+        if (text.endsWith("ms"))
+        {
+            scale = 1;
+            number.chop(2);
+        }
+        else if (text.endsWith('s'))
+        {
+            number.chop(1);
+        }
+        else if (text.endsWith('m'))
+        {
+            scale = 60 * 1000;
+            number.chop(1);
+        }
+
+        bool         ok     = false;
+        const double length = number.toDouble(&ok);
+
+        return (ok and length > 0) ? static_cast<int64_t>(length * scale) : 0;
+    }
+
+    //! Whether a value is a number that can be aggregated
+    bool isFinite(const jsoncons::json& value)
+    {
+        return value.is_number() and std::isfinite(value.as<double>());
+    }
+}  // namespace
+
+WindowAggregator::WindowAggregator(Operator aggregate, int64_t length) :
+    op{aggregate},
+    window{std::max<int64_t>(length, 1)}
+{}
+
+void WindowAggregator::Push(int64_t time, double value)
+{
+    switch (op)
+    {
+        case OP_MIN:
+        case OP_MAX:
+        {
+            // Samples that can no longer be the extreme before leaving the window are dropped
+            while (!extremes.empty() and (op == OP_MIN ? extremes.back().second >= value : extremes.back().second <= value))
+            {
+                extremes.pop_back();
+            }
+
+            extremes.emplace_back(time, value);
+            break;
+        }
+
+        case OP_AVG:
+            samples.emplace_back(time, value);
+            sum += value;
+            break;
+
+        case OP_P95:
+            samples.emplace_back(time, value);
+            sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), value), value);
+            break;
+
+        case OP_EWMA:
+        {
+            if (lastTime < 0)
+            {
+                ewma = value;
+            }
+            else
+            {
+                const double alpha = 1.0 - std::exp(-static_cast<double>(std::max<int64_t>(time - lastTime, 0)) / window);
+                ewma += alpha * (value - ewma);
+            }
+
+            lastTime = time;
+            return;
+        }
+
+        default:
+            return;
+    }
+
+    expire(time);
+}
+
+double WindowAggregator::Value() const
+{
+    switch (op)
+    {
+        case OP_MIN:
+        case OP_MAX:
+            return extremes.front().second;
+
+        case OP_AVG:
+            return sum / samples.size();
+
+        case OP_P95:
+        {
+            const auto rank = static_cast<size_t>(std::ceil(0.95 * sorted.size()));
+            return sorted[std::max<size_t>(rank, 1) - 1];
+        }
+
+        default:
+            return ewma;
+    }
+}
+
+WindowAggregator::Operator WindowAggregator::ParseOperator(std::string_view name)
+{
+    static const std::unordered_map<std::string_view, Operator> operators{
+        {"min",  OP_MIN },
+        {"max",  OP_MAX },
+        {"avg",  OP_AVG },
+        {"p95",  OP_P95 },
+        {"ewma", OP_EWMA}
+    };
+
+    auto it = operators.find(name);
+
+    return it != operators.end() ? it->second : OP_INVALID;
+}
+
+void WindowAggregator::expire(int64_t now)
+{
+    const int64_t cutoff = now - window;
+
+    // The newest sample is always within the window
+    while (extremes.size() > 1 and extremes.front().first <= cutoff)
+    {
+        extremes.pop_front();
+    }
+
+    while (samples.size() > 1 and samples.front().first <= cutoff)
+    {
+        const double value = samples.front().second;
+        samples.pop_front();
+
+        if (op == OP_AVG)
+        {
+            sum -= value;
+        }
+        else
+        {
+            sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), value));
+        }
+    }
+}
+
+DerivedTopics::Derived::Derived(Server& serv, std::string name, std::string sourceTopic, int64_t length, WindowAggregator::Operator aggregate) :
+    server{serv},
+    topic{std::move(name)},
+    source{std::move(sourceTopic)},
+    window{length},
+    op{aggregate}
+{}
+
+void DerivedTopics::Derived::OnData(std::string_view sourceTopic, const jsoncons::json& data)
+{
+    const int64_t   now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    jsoncons::json  result;
+
+    std::lock_guard lk(mutex);
+
+    if (isFinite(data))
+    {
+        result = aggregate({}, now, data.as<double>());
+    }
+    else if (data.is_object())
+    {
+        result = jsoncons::json{jsoncons::json_object_arg};
+
+        for (auto&& member : data.object_range())
+        {
+            if (isFinite(member.value()))
+            {
+                result.insert_or_assign(member.key(), aggregate(member.key(), now, member.value().as<double>()));
+            }
+        }
+    }
+    else if (data.is_array())
+    {
+        result = jsoncons::json{jsoncons::json_array_arg};
+        result.reserve(data.size());
+
+        for (size_t i = 0; i < data.size(); i++)
+        {
+            if (isFinite(data[i]))
+            {
+                result.push_back(aggregate(std::to_string(i), now, data[i].as<double>()));
+            }
+            else
+            {
+                result.push_back(jsoncons::null_type{});
+            }
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    jsoncons::json msg{jsoncons::json_object_arg, {{topic, std::move(result)}}};
+
+    last.clear();
+    msg.dump(last);
+
+    server.PublishData(topic, last, {.reliable = false});
+}
+
+double DerivedTopics::Derived::aggregate(std::string_view field, int64_t time, double value)
+{
+    auto it = fields.find(field);
+
+    if (it == fields.end())
+    {
+        it = fields.emplace(std::string{field}, WindowAggregator{op, window}).first;
+    }
+
+    it->second.Push(time, value);
+
+    return it->second.Value();
+}
+
+DerivedTopics::DerivedTopics(Server& serv, const std::string& definitionList) :
+    server{serv}
+{
+    for (auto&& definition : QString::fromStdString(definitionList).split(';', Qt::SkipEmptyParts))
+    {
+        const auto  pos    = definition.indexOf('=');
+        const auto  params = definition.mid(pos + 1).split(',');
+
+        if (pos <= 0 or params.size() != 3)
+        {
+            SPDLOG_WARN("Invalid derived topic '{}', expected name=source,window,operator", definition.trimmed().toStdString());
+            continue;
+        }
+
+        const auto  name   = definition.left(pos).trimmed().toStdString();
+        const auto  source = params[0].trimmed().toStdString();
+        const auto  window = parseWindow(params[1].trimmed());
+        const auto  op     = WindowAggregator::ParseOperator(params[2].trimmed().toStdString());
+
+        if (source.empty() or window <= 0 or op == WindowAggregator::OP_INVALID)
+        {
+            SPDLOG_WARN("Invalid derived topic '{}', expected name=source,window,operator", definition.trimmed().toStdString());
+            continue;
+        }
+
+        auto topic = fmt::format("{}{}", DERIVED_PREFIX, name);
+
+        if (derived.contains(topic))
+        {
+            SPDLOG_WARN("Derived topic {} is defined more than once", topic);
+            continue;
+        }
+
+        derived.emplace(topic, std::make_unique<Derived>(server, topic, source, window, op));
+        server.RegisterTopic(topic);
+    }
+
+    SPDLOG_INFO("Deriving {} topics", derived.size());
+}
+
+DerivedTopics::~DerivedTopics()
+{
+    for (auto&& [topic, entry] : derived)
+    {
+        detach(*entry);
+    }
+}
+
+bool DerivedTopics::Provides(std::string_view topic) const
+{
+    return derived.contains(topic);
+}
+
+void DerivedTopics::SetSubscribers(std::string_view topic, int count)
+{
+    auto it = derived.find(topic);
+
+    if (it == derived.end())
+    {
+        return;
+    }
+
+    Derived& entry = *it->second;
+
+    if (count > 0 and !entry.extension)
+    {
+        auto extn = server.FindTopicOwner(entry.source);
+
+        if (!extn)
+        {
+            SPDLOG_WARN("Source topic {} of derived topic {} does not exist", entry.source, entry.topic);
+            return;
+        }
+
+        if (extn->AddTap(entry.source, &entry))
+        {
+            entry.extension = extn;
+        }
+    }
+    else if (count == 0)
+    {
+        detach(entry);
+    }
+}
+
+std::string DerivedTopics::LastMessage(std::string_view topic) const
+{
+    auto it = derived.find(topic);
+
+    if (it == derived.end())
+    {
+        return {};
+    }
+
+    std::lock_guard lk(it->second->mutex);
+
+    return it->second->last;
+}
+
+void DerivedTopics::detach(Derived& entry)
+{
+    if (!entry.extension)
+    {
+        return;
+    }
+
+    // Not under the entry's lock, which is taken under the Data Source's lock
+    entry.extension->RemoveTap(entry.source, &entry);
+    entry.extension = nullptr;
+
+    std::lock_guard lk(entry.mutex);
+
+    entry.fields.clear();
+    entry.last.clear();
+}
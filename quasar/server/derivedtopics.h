@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/util.h"
+#include "extension/extension.h"
+#include "topicprovider.h"
+
+class Server;
+
+//! Aggregate of the samples of one number over a sliding time window
+/*! Updates are amortized O(1), except for \ref OP_P95, which keeps the window
+    sorted and costs a binary search and a move of the larger samples.
+    Not thread safe.
+*/
+class WindowAggregator
+{
+public:
+    //! Supported operators
+    enum Operator : uint8_t
+    {
+        OP_MIN,
+        OP_MAX,
+        OP_AVG,
+        OP_P95,   //!< 95th percentile, nearest rank
+        OP_EWMA,  //!< Exponentially weighted moving average, with the window as its time constant
+        OP_INVALID
+    };
+
+    //! \param[in]  aggregate   Operator
+    //! \param[in]  length      Window length in ms
+    WindowAggregator(Operator aggregate, int64_t length);
+
+    //! Adds a sample, and drops the samples that left the window
+    /*! \param[in]  time    Sample time in ms, increasing
+        \param[in]  value   Sample value
+    */
+    void            Push(int64_t time, double value);
+
+    //! Current aggregate, only valid after a sample was pushed
+    double          Value() const;
+
+    //! Parses an operator name such as \c p95
+    //! \return Operator, or \ref OP_INVALID if the name is invalid
+    static Operator ParseOperator(std::string_view name);
+
+private:
+    void                                   expire(int64_t now);
+
+    Operator                               op;
+    int64_t                                window;
+
+    std::deque<std::pair<int64_t, double>> samples{};   //!< Samples in the window, for OP_AVG and OP_P95
+    std::deque<std::pair<int64_t, double>> extremes{};  //!< Monotonic candidates, for OP_MIN and OP_MAX
+    std::vector<double>                    sorted{};    //!< Sorted samples in the window, for OP_P95
+    double                                 sum      = 0;
+    double                                 ewma     = 0;
+    int64_t                                lastTime = -1;
+};
+
+//! Topics aggregating a Data Source over a sliding time window
+/*! Derived topics are published as \c derived/<name>, and are given as a semicolon
+    separated list of \c name=source,window,operator entries, such as
+    \c cpu10s=win_simple_perf/sysinfo,10s,avg. Windows are in \c ms, \c s or \c m.
+
+    The aggregate keeps the shape of the source's data: a number yields a number, an
+    object yields its numeric members, and an array yields its elements, with \c null
+    in place of those that are not numbers. Each number is aggregated separately.
+
+    A derived topic consumes its source in process, as samples are retrieved, and only
+    while it has subscribers. Its window starts over once the last one leaves.
+*/
+class DerivedTopics : public TopicProvider
+{
+public:
+    DerivedTopics(const DerivedTopics&)             = delete;
+    DerivedTopics& operator= (const DerivedTopics&) = delete;
+
+    //! \param[in]  serv            Data Server to publish to, and to find sources with
+    //! \param[in]  definitionList  Derived topic definitions
+    DerivedTopics(Server& serv, const std::string& definitionList);
+    ~DerivedTopics();
+
+    //! Whether a topic is a configured derived topic
+    bool        Provides(std::string_view topic) const override;
+
+    //! Consumes the source of a derived topic while it has subscribers
+    void        SetSubscribers(std::string_view topic, int count) override;
+
+    //! Latest aggregate of a topic, empty if none was computed yet
+    std::string LastMessage(std::string_view topic) const override;
+
+private:
+    struct Derived : public DataTap
+    {
+        Server&                                                                              server;
+        std::string                                                                          topic;
+        std::string                                                                          source;
+        int64_t                                                                              window;
+        WindowAggregator::Operator                                                           op;
+
+        Extension*                                                                           extension{};  //!< Owner of the source while tapped, server thread only
+
+        mutable std::mutex                                                                   mutex;  //!< Guards fields and last
+        std::unordered_map<std::string, WindowAggregator, Util::StringHash, std::equal_to<>> fields{};
+        std::string                                                                          last{};
+
+        Derived(Server& serv, std::string name, std::string sourceTopic, int64_t length, WindowAggregator::Operator aggregate);
+
+        //! Aggregates a sample of the source and publishes the result
+        void   OnData(std::string_view sourceTopic, const jsoncons::json& data) override;
+
+        double aggregate(std::string_view field, int64_t time, double value);
+    };
+
+    //! Stops consuming the source of a derived topic and drops its window
+    void                                                                                       detach(Derived& entry);
+
+    Server&                                                                                    server;
+    std::unordered_map<std::string, std::unique_ptr<Derived>, Util::StringHash, std::equal_to<>> derived{};  //!< Derived topics, fixed after construction
+};
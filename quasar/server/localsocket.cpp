@@ -0,0 +1,560 @@
+#include "localsocket.h"
+
+#include "server.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QtGlobal>
+
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+#ifdef Q_OS_LINUX
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <sys/un.h>
+#  include <unistd.h>
+
+#  include <cerrno>
+#  include <cstring>
+#endif
+
+namespace
+{
+    // Same limit as WebSocket clients
+    constexpr uint32_t MAX_MESSAGE_SIZE = 16 * 1024;
+
+    // Clients with more unsent output than this only get the latest message of each topic,
+    // like congested WebSocket clients
+    constexpr size_t   CONGESTION_SIZE  = 64 * 1024;
+
+    // Clients with more unread output than this are disconnected
+    constexpr size_t   MAX_OUTPUT_SIZE  = 8 * 1024 * 1024;
+
+    constexpr size_t   HEADER_SIZE      = 4;
+}  // namespace
+
+struct LocalSocketServer::WakePipe
+{
+    int fds[2]{-1, -1};
+
+#ifdef Q_OS_LINUX
+    WakePipe()
+    {
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0)
+        {
+            SPDLOG_ERROR("Failed to create local socket wake pipe: {}", std::strerror(errno));
+        }
+    }
+
+    ~WakePipe()
+    {
+        for (auto fd : fds)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+    }
+
+    void notify()
+    {
+        const char c = 0;
+        [[maybe_unused]] auto res = ::write(fds[1], &c, 1);
+    }
+
+    void clear()
+    {
+        char buf[64];
+
+        while (::read(fds[0], buf, sizeof(buf)) > 0)
+        {}
+    }
+#endif
+};
+
+struct LocalSocketServer::Connection
+{
+    int                            fd = -1;
+    std::shared_ptr<PerSocketData> client{};
+    std::shared_ptr<WakePipe>      wake{};
+    std::string                    input{};  //!< Received bytes not yet forming a whole message
+
+    // Written by the server thread, flushed by the poll thread
+    std::mutex                     outputMutex;
+    std::string                    output{};           //!< Framed messages waiting to be written
+    size_t                         sent      = 0;      //!< Bytes of output already written
+    bool                           congested = false;  //!< The server holds back messages until output drains
+    bool                           overflow  = false;  //!< The client stopped reading and is dropped
+
+    //! Bytes of output waiting to be written
+    size_t pending() const { return output.size() - sent; }
+};
+
+LocalSocketServer::LocalSocketServer(Server& serv, const std::string& socketPath) :
+    server{serv},
+    path{socketPath}
+{
+#ifdef Q_OS_LINUX
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        SPDLOG_ERROR("Local socket path {} is too long", path);
+        return;
+    }
+
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    wake     = std::make_shared<WakePipe>();
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (listenFd < 0)
+    {
+        SPDLOG_ERROR("Failed to create local socket: {}", std::strerror(errno));
+        return;
+    }
+
+    // Replace a stale socket, unless another instance is still listening on it
+    struct stat st{};
+
+    if (lstat(path.c_str(), &st) == 0 and S_ISSOCK(st.st_mode))
+    {
+        if (connect(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 or errno == EAGAIN)
+        {
+            SPDLOG_ERROR("Local socket {} is already in use", path);
+            close(listenFd);
+            listenFd = -1;
+            return;
+        }
+
+        unlink(path.c_str());
+
+        // A failed connect leaves the socket unusable
+        close(listenFd);
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+
+    if (listenFd < 0 or bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 or chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0
+        or listen(listenFd, SOMAXCONN) != 0)
+    {
+        SPDLOG_ERROR("Failed to listen on local socket {}: {}", path, std::strerror(errno));
+
+        if (listenFd >= 0)
+        {
+            close(listenFd);
+            listenFd = -1;
+        }
+
+        return;
+    }
+
+    thread = std::jthread{[this](std::stop_token token) {
+        run(token);
+    }};
+
+    SPDLOG_INFO("Listening on local socket {}", path);
+#else
+    SPDLOG_WARN("Local socket listener is only available on Linux");
+#endif
+}
+
+LocalSocketServer::~LocalSocketServer()
+{
+#ifdef Q_OS_LINUX
+    if (thread.joinable())
+    {
+        thread.request_stop();
+        wake->notify();
+        thread.join();
+    }
+
+    while (!connections.empty())
+    {
+        drop(connections.begin()->first);
+    }
+
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        unlink(path.c_str());
+    }
+#endif
+}
+
+std::string LocalSocketServer::DefaultPath()
+{
+#ifdef Q_OS_LINUX
+    // Instances of other profiles are named quasar-<profile>
+    const auto app = QCoreApplication::applicationName().toStdString();
+
+    if (auto dir = std::getenv("XDG_RUNTIME_DIR"); dir and *dir)
+    {
+        return fmt::format("{}/{}.sock", dir, app);
+    }
+
+    return fmt::format("/tmp/{}-{}.sock", app, getuid());
+#else
+    return {};
+#endif
+}
+
+void LocalSocketServer::run(std::stop_token token)
+{
+#ifdef Q_OS_LINUX
+    std::vector<pollfd> fds;
+    std::vector<int>    overflowed;
+
+    while (!token.stop_requested())
+    {
+        fds.clear();
+        overflowed.clear();
+
+        fds.push_back({.fd = listenFd, .events = POLLIN, .revents = 0});
+        fds.push_back({.fd = wake->fds[0], .events = POLLIN, .revents = 0});
+
+        for (auto&& [fd, conn] : connections)
+        {
+            std::lock_guard lk(conn->outputMutex);
+
+            if (conn->overflow)
+            {
+                overflowed.push_back(fd);
+                continue;
+            }
+
+            const short events = conn->pending() == 0 ? POLLIN : (POLLIN | POLLOUT);
+            fds.push_back({.fd = fd, .events = events, .revents = 0});
+        }
+
+        for (auto fd : overflowed)
+        {
+            SPDLOG_WARN("Dropping local client that stopped reading");
+            drop(fd);
+        }
+
+        // Wake up regularly to check for stop requests
+        int n = poll(fds.data(), fds.size(), 1000);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            SPDLOG_ERROR("Local socket listener stopped: {}", std::strerror(errno));
+            return;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            wake->clear();
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            accept();
+        }
+
+        for (size_t i = 2; i < fds.size(); i++)
+        {
+            const auto revents = fds[i].revents;
+
+            if (!revents)
+            {
+                continue;
+            }
+
+            auto it = connections.find(fds[i].fd);
+
+            if (it == connections.end())
+            {
+                continue;
+            }
+
+            bool ok = !(revents & (POLLERR | POLLNVAL));
+
+            if (ok and (revents & (POLLIN | POLLHUP)))
+            {
+                ok = read(*it->second);
+            }
+
+            if (ok and (revents & POLLOUT))
+            {
+                ok = write(*it->second);
+            }
+
+            if (!ok)
+            {
+                drop(fds[i].fd);
+            }
+        }
+    }
+#endif
+}
+
+void LocalSocketServer::accept()
+{
+#ifdef Q_OS_LINUX
+    while (true)
+    {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if (errno != EAGAIN and errno != EWOULDBLOCK)
+            {
+                SPDLOG_WARN("Failed to accept local client: {}", std::strerror(errno));
+            }
+
+            return;
+        }
+
+        // Peer credentials stand in for auth codes
+        ucred     cred{};
+        socklen_t len = sizeof(cred);
+
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 or cred.uid != getuid())
+        {
+            SPDLOG_WARN("Rejected local client (pid {}, uid {})", cred.pid, cred.uid);
+            close(fd);
+            continue;
+        }
+
+        auto conn  = std::make_shared<Connection>();
+        conn->fd   = fd;
+        conn->wake = wake;
+
+        // Invoked on the server thread
+        auto deliver = [weak = std::weak_ptr<Connection>{conn}](const std::string& data) {
+            auto conn = weak.lock();
+
+            if (!conn)
+            {
+                return;
+            }
+
+            bool notify = false;
+
+            {
+                std::lock_guard lk(conn->outputMutex);
+
+                if (conn->overflow)
+                {
+                    return;
+                }
+
+                if (conn->pending() > MAX_OUTPUT_SIZE)
+                {
+                    conn->overflow = true;
+                    notify         = true;
+                }
+                else
+                {
+                    const auto size = static_cast<uint32_t>(data.size());
+                    const char header[HEADER_SIZE]{static_cast<char>(size >> 24), static_cast<char>(size >> 16), static_cast<char>(size >> 8), static_cast<char>(size)};
+
+                    // Only the first pending message needs to wake the poll thread
+                    notify = conn->pending() == 0;
+
+                    conn->output.append(header, HEADER_SIZE);
+                    conn->output.append(data);
+                }
+            }
+
+            if (notify)
+            {
+                conn->wake->notify();
+            }
+        };
+
+        // Invoked on the server thread, the poll thread flushes the client once its output drains
+        auto writable = [weak = std::weak_ptr<Connection>{conn}] {
+            auto conn = weak.lock();
+
+            if (!conn)
+            {
+                return true;
+            }
+
+            std::lock_guard lk(conn->outputMutex);
+
+            conn->congested = conn->pending() >= CONGESTION_SIZE;
+
+            return !conn->congested;
+        };
+
+        conn->client = server.ConnectLocalClient(fmt::format("pid {}", cred.pid), std::move(deliver), std::move(writable));
+        connections.emplace(fd, std::move(conn));
+
+        SPDLOG_INFO("Local client connected (pid {})", cred.pid);
+    }
+#endif
+}
+
+bool LocalSocketServer::read(Connection& conn)
+{
+#ifdef Q_OS_LINUX
+    char buf[16 * 1024];
+
+    while (true)
+    {
+        auto n = recv(conn.fd, buf, sizeof(buf), 0);
+
+        // Parsed chunk by chunk, so at most one partial message is buffered
+        if (n > 0)
+        {
+            conn.input.append(buf, n);
+
+            if (!parse(conn))
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        if (n == 0)
+        {
+            return false;
+        }
+
+        if (errno == EINTR)
+        {
+            continue;
+        }
+
+        if (errno == EAGAIN or errno == EWOULDBLOCK)
+        {
+            break;
+        }
+
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool LocalSocketServer::parse(Connection& conn)
+{
+    std::string_view input{conn.input};
+    size_t           pos = 0;
+
+    while (input.size() - pos >= HEADER_SIZE)
+    {
+        const auto     header = reinterpret_cast<const unsigned char*>(input.data() + pos);
+        const uint32_t size   = (uint32_t{header[0]} << 24) | (uint32_t{header[1]} << 16) | (uint32_t{header[2]} << 8) | uint32_t{header[3]};
+
+        if (size > MAX_MESSAGE_SIZE)
+        {
+            SPDLOG_WARN("Dropping local client sending a {} byte message", size);
+            return false;
+        }
+
+        if (input.size() - pos - HEADER_SIZE < size)
+        {
+            break;
+        }
+
+        server.ReceiveFromLocalClient(conn.client, input.substr(pos + HEADER_SIZE, size));
+        pos += HEADER_SIZE + size;
+    }
+
+    conn.input.erase(0, pos);
+
+    return true;
+}
+
+bool LocalSocketServer::write(Connection& conn)
+{
+#ifdef Q_OS_LINUX
+    bool flush = false;
+
+    {
+        std::lock_guard lk(conn.outputMutex);
+
+        while (conn.pending() > 0)
+        {
+            auto n = send(conn.fd, conn.output.data() + conn.sent, conn.pending(), MSG_NOSIGNAL);
+
+            if (n > 0)
+            {
+                conn.sent += n;
+                continue;
+            }
+
+            if (n < 0 and errno == EINTR)
+            {
+                continue;
+            }
+
+            if (n == 0 or (errno != EAGAIN and errno != EWOULDBLOCK))
+            {
+                return false;
+            }
+
+            break;
+        }
+
+        if (conn.pending() == 0)
+        {
+            conn.output.clear();
+            conn.sent = 0;
+        }
+        else if (conn.sent >= conn.output.size() / 2)
+        {
+            // Amortizes the move of the unsent output over the bytes sent
+            conn.output.erase(0, conn.sent);
+            conn.sent = 0;
+        }
+
+        if (conn.congested and conn.pending() < CONGESTION_SIZE)
+        {
+            conn.congested = false;
+            flush          = true;
+        }
+    }
+
+    if (flush)
+    {
+        server.FlushLocalClient(conn.client);
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void LocalSocketServer::drop(int fd)
+{
+#ifdef Q_OS_LINUX
+    auto node = connections.extract(fd);
+
+    if (node.empty())
+    {
+        return;
+    }
+
+    server.DisconnectLocalClient(node.mapped()->client);
+    close(fd);
+
+    SPDLOG_INFO("Local client disconnected");
+#endif
+}
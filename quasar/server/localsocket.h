@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+class Server;
+struct PerSocketData;
+
+//! Unix domain socket listener for local, non-browser clients
+/*! Clients speak the Widget Client Protocol, with every message framed by its
+    length as a 4 byte big endian integer instead of WebSocket framing. Peers are
+    authenticated by their credentials (SO_PEERCRED) in place of auth codes, and
+    only processes of the user running Quasar are accepted.
+
+    Connections are served by a single poll thread and handed to the Data Server
+    as in-process clients \sa Server::ConnectLocalClient()
+
+    Only available on Linux.
+*/
+class LocalSocketServer
+{
+public:
+    LocalSocketServer(const LocalSocketServer&)             = delete;
+    LocalSocketServer& operator= (const LocalSocketServer&) = delete;
+
+    LocalSocketServer(Server& serv, const std::string& socketPath);
+    ~LocalSocketServer();
+
+    //! Whether the socket is listening
+    bool               IsListening() const { return listenFd >= 0; }
+
+    //! Default socket path, in the user's runtime directory
+    static std::string DefaultPath();
+
+private:
+    struct Connection;
+    struct WakePipe;
+
+    void run(std::stop_token token);
+    void accept();
+    bool read(Connection& conn);
+    bool parse(Connection& conn);
+    bool write(Connection& conn);
+    void drop(int fd);
+
+    Server&                                              server;
+    std::string                                          path;
+    int                                                  listenFd = -1;
+    std::shared_ptr<WakePipe>                            wake{};         //!< Wakes the poll thread when output is queued
+    std::unordered_map<int, std::shared_ptr<Connection>> connections{};  //!< Poll thread only
+    std::jthread                                         thread;
+};
@@ -1,23 +1,83 @@
 #pragma once
 
+#include <cstdint>
+#include <memory_resource>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
-struct ClientMsgParams
+//! Delta encoding modes a client can subscribe with
+enum DeltaMode : uint8_t
 {
-    std::optional<std::vector<std::string>> topics;
-    std::optional<std::vector<std::string>> params;
-    std::optional<std::string>              code;
-    std::optional<std::string>              args;
+    DELTA_NONE = 0,  //!< Full payloads
+    DELTA_MERGE,     //!< RFC 7386 JSON Merge Patch
+    DELTA_PATCH,     //!< RFC 6902 JSON Patch
+    DELTA_MAX
 };
 
-struct ClientMessage
+//! Parses the "delta" subscribe parameter
+inline DeltaMode ParseDeltaMode(std::string_view mode)
 {
+    if (mode == "merge")
+    {
+        return DELTA_MERGE;
+    }
+
+    if (mode == "patch")
+    {
+        return DELTA_PATCH;
+    }
+
+    return DELTA_NONE;
+}
+
+//! Suffix appended to a topic to form the channel of a delta mode
+inline std::string_view DeltaChannelSuffix(DeltaMode mode)
+{
+    switch (mode)
+    {
+        case DELTA_MERGE:
+            return "@merge";
+        case DELTA_PATCH:
+            return "@patch";
+        default:
+            return "";
+    }
+}
+
+//! Name of a delta mode as sent in delta messages
+inline std::string_view DeltaModeName(DeltaMode mode)
+{
+    auto suffix = DeltaChannelSuffix(mode);
+    return suffix.empty() ? suffix : suffix.substr(1);
+}
+
+//! Client request parsed in place from a received frame
+/*! Strings are views into the frame, or into the parsing arena if they had to
+    be unescaped. A request is only valid while both of them are alive.
+    \sa RequestParser::Parse()
+*/
+struct ClientRequest
+{
+    using ViewList = std::pmr::vector<std::string_view>;
+
+    explicit ClientRequest(std::pmr::memory_resource* res) : arena{res} {}
+
     // Client message schema
-    std::string     method;
-    ClientMsgParams params;
+    std::string_view                method;
+    std::optional<ViewList>         topics;
+    std::optional<ViewList>         params;
+    std::optional<std::string_view> code;
+    std::optional<std::string_view> args;   //!< Null terminated
+    std::optional<std::string_view> delta;
+    std::optional<uint32_t>         backfill;    //!< Number of history samples to send before live updates
+    std::optional<uint64_t>         from;        //!< Start of a time range in ms since the Unix epoch
+    std::optional<uint64_t>         to;          //!< End of a time range in ms since the Unix epoch
+    std::optional<std::string_view> resolution;  //!< Resolution of time series rollups
+
+    std::pmr::memory_resource*      arena;  //!< Backing storage of unescaped strings and lists
 };
 
 struct ErrorOnlyMessage
@@ -0,0 +1,309 @@
+#include "relay.h"
+
+#include "server.h"
+#include "topicindex.h"
+
+#include <algorithm>
+
+#include <QString>
+
+#include <fmt/core.h>
+#include <jsoncons/json.hpp>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    // Reconnection delays double from the minimum up to the maximum
+    constexpr int MIN_RECONNECT_MS = 1000;
+    constexpr int MAX_RECONNECT_MS = 30000;
+}  // namespace
+
+RelayUpstream::RelayUpstream(Server& serv, const std::string& upstreamName, const QUrl& upstreamUrl) :
+    server{serv},
+    name{upstreamName},
+    url{upstreamUrl},
+    socket{QString{}, QWebSocketProtocol::VersionLatest, this},
+    reconnectTimer{this}
+{
+    reconnectTimer.setSingleShot(true);
+
+    connect(&reconnectTimer, &QTimer::timeout, this, [this] {
+        socket.open(url);
+    });
+
+    connect(&socket, &QWebSocket::connected, this, &RelayUpstream::onConnected);
+    connect(&socket, &QWebSocket::disconnected, this, &RelayUpstream::onDisconnected);
+    connect(&socket, &QWebSocket::textMessageReceived, this, &RelayUpstream::onMessage);
+}
+
+void RelayUpstream::Start()
+{
+    SPDLOG_INFO("Connecting to relay upstream {} at {}", name, url.toString().toStdString());
+    socket.open(url);
+}
+
+void RelayUpstream::SetWanted(const std::string& topic, bool wanted)
+{
+    if (wanted == topics.contains(topic))
+    {
+        return;
+    }
+
+    if (wanted)
+    {
+        topics.insert(topic);
+    }
+    else
+    {
+        topics.erase(topic);
+
+        std::lock_guard lk(lastMutex);
+        lastMessages.erase(fmt::format("{}:{}", name, topic));
+    }
+
+    if (socket.state() == QAbstractSocket::ConnectedState)
+    {
+        sendRequest(wanted ? "subscribe" : "unsubscribe", {topic});
+
+        if (!wanted and TopicIndex::IsPattern(topic))
+        {
+            // Leaving a pattern also leaves the topics it matched upstream, keep those still wanted
+            std::unordered_set<std::string> matched;
+
+            for (auto&& other : topics)
+            {
+                if (TopicIndex::Matches(topic, other))
+                {
+                    matched.insert(other);
+                }
+            }
+
+            if (!matched.empty())
+            {
+                sendRequest("subscribe", matched);
+            }
+        }
+    }
+}
+
+std::string RelayUpstream::LastMessage(const std::string& topic)
+{
+    std::lock_guard lk(lastMutex);
+
+    auto            it = lastMessages.find(topic);
+
+    return it != lastMessages.end() ? it->second : std::string{};
+}
+
+void RelayUpstream::onConnected()
+{
+    SPDLOG_INFO("Connected to relay upstream {}", name);
+
+    backoff = 0;
+
+    // Restore the subscriptions of the previous connection
+    if (!topics.empty())
+    {
+        sendRequest("subscribe", topics);
+    }
+}
+
+void RelayUpstream::onDisconnected()
+{
+    backoff = std::clamp(backoff * 2, MIN_RECONNECT_MS, MAX_RECONNECT_MS);
+
+    SPDLOG_WARN("Relay upstream {} disconnected: {}, retrying in {}ms", name, socket.errorString().toStdString(), backoff);
+
+    reconnectTimer.start(backoff);
+}
+
+void RelayUpstream::onMessage(const QString& message)
+{
+    jsoncons::json doc;
+
+    try
+    {
+        doc = jsoncons::json::parse(message.toStdString());
+    } catch (const std::exception& e)
+    {
+        SPDLOG_WARN("Invalid message from relay upstream {}: {}", name, e.what());
+        return;
+    }
+
+    if (!doc.is_object())
+    {
+        return;
+    }
+
+    for (auto&& member : doc.object_range())
+    {
+        if (member.key() == "errors")
+        {
+            for (auto&& err : member.value().array_range())
+            {
+                SPDLOG_WARN("Relay upstream {}: {}", name, err.as<std::string>());
+            }
+
+            continue;
+        }
+
+        // Also skips extension settings, which are not relayed
+        if (!isWanted(member.key()))
+        {
+            continue;
+        }
+
+        auto           topic = fmt::format("{}:{}", name, member.key());
+
+        if (relayed.insert(topic).second)
+        {
+            server.RegisterTopic(topic);
+        }
+        std::string    payload{};
+
+        jsoncons::json relayed{jsoncons::json_object_arg};
+        relayed.insert_or_assign(topic, member.value());
+        relayed.dump(payload);
+
+        server.PublishData(topic, payload, {.reliable = false});
+
+        std::lock_guard lk(lastMutex);
+        lastMessages.insert_or_assign(std::move(topic), std::move(payload));
+    }
+}
+
+void RelayUpstream::sendRequest(std::string_view method, const std::unordered_set<std::string>& names)
+{
+    jsoncons::json list{jsoncons::json_array_arg};
+
+    for (auto&& topic : names)
+    {
+        list.push_back(topic);
+    }
+
+    std::string    request{};
+
+    jsoncons::json doc{
+        jsoncons::json_object_arg,
+        {{"method", method}, {"params", jsoncons::json{jsoncons::json_object_arg, {{"topics", std::move(list)}}}}}
+    };
+
+    doc.dump(request);
+
+    socket.sendTextMessage(QString::fromStdString(request));
+}
+
+bool RelayUpstream::isWanted(std::string_view topic) const
+{
+    if (topics.contains(std::string{topic}))
+    {
+        return true;
+    }
+
+    return std::ranges::any_of(topics, [topic](const std::string& wanted) {
+        return TopicIndex::IsPattern(wanted) and TopicIndex::Matches(wanted, topic);
+    });
+}
+
+Relay::Relay(Server& serv, const std::string& upstreamList)
+{
+    for (auto&& entry : QString::fromStdString(upstreamList).split(',', Qt::SkipEmptyParts))
+    {
+        auto pos  = entry.indexOf('=');
+        auto name = entry.left(pos).trimmed().toStdString();
+        auto url  = QUrl{entry.mid(pos + 1).trimmed()};
+
+        if (pos <= 0 or name.find_first_of(":/") != std::string::npos or !url.isValid() or (url.scheme() != "ws" and url.scheme() != "wss"))
+        {
+            SPDLOG_WARN("Invalid relay upstream \"{}\", expected name=ws://host:port", entry.toStdString());
+            continue;
+        }
+
+        if (upstreams.contains(name))
+        {
+            SPDLOG_WARN("Relay upstream {} is defined more than once", name);
+            continue;
+        }
+
+        auto upstream = std::make_unique<RelayUpstream>(serv, name, url);
+        upstream->moveToThread(&thread);
+
+        upstreams.emplace(name, std::move(upstream));
+    }
+
+    if (upstreams.empty())
+    {
+        return;
+    }
+
+    thread.setObjectName("Relay");
+    thread.start();
+
+    for (auto&& [name, upstream] : upstreams)
+    {
+        QMetaObject::invokeMethod(upstream.get(), &RelayUpstream::Start, Qt::QueuedConnection);
+    }
+}
+
+Relay::~Relay()
+{
+    thread.quit();
+    thread.wait();
+
+    // Upstreams are destroyed here, once their thread has stopped
+    upstreams.clear();
+}
+
+bool Relay::Provides(std::string_view topic) const
+{
+    std::string_view remote;
+    return find(topic, remote) != nullptr;
+}
+
+void Relay::SetSubscribers(std::string_view topic, int count)
+{
+    std::string_view remote;
+    auto             upstream = find(topic, remote);
+
+    if (!upstream)
+    {
+        return;
+    }
+
+    QMetaObject::invokeMethod(
+        upstream,
+        [upstream, remote = std::string{remote}, wanted = count > 0] {
+            upstream->SetWanted(remote, wanted);
+        },
+        Qt::QueuedConnection);
+}
+
+std::string Relay::LastMessage(std::string_view topic) const
+{
+    std::string_view remote;
+    auto             upstream = find(topic, remote);
+
+    return upstream ? upstream->LastMessage(std::string{topic}) : std::string{};
+}
+
+RelayUpstream* Relay::find(std::string_view topic, std::string_view& remote) const
+{
+    auto pos = topic.find(':');
+
+    // The upstream name comes before any '/' of the topic
+    if (pos == std::string_view::npos or topic.substr(0, pos).find('/') != std::string_view::npos)
+    {
+        return nullptr;
+    }
+
+    auto it = upstreams.find(std::string{topic.substr(0, pos)});
+
+    if (it == upstreams.end())
+    {
+        return nullptr;
+    }
+
+    remote = topic.substr(pos + 1);
+
+    return it->second.get();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <QWebSocket>
+
+#include "topicprovider.h"
+
+class Server;
+
+//! Connection to an upstream Quasar instance, living on the relay thread
+class RelayUpstream : public QObject
+{
+    Q_OBJECT;
+
+public:
+    RelayUpstream(Server& serv, const std::string& upstreamName, const QUrl& upstreamUrl);
+
+    //! Connects to the upstream instance
+    void        Start();
+
+    //! Subscribes to or unsubscribes from an upstream topic or wildcard pattern
+    void        SetWanted(const std::string& topic, bool wanted);
+
+    //! Latest relayed message of a topic, invoked from any thread
+    std::string LastMessage(const std::string& topic);
+
+private:
+    void onConnected();
+    void onDisconnected();
+    void onMessage(const QString& message);
+    void sendRequest(std::string_view method, const std::unordered_set<std::string>& names);
+
+    //! Whether an upstream topic is wanted, directly or through a wildcard pattern
+    bool isWanted(std::string_view topic) const;
+
+    Server&                                      server;
+    std::string                                  name;
+    QUrl                                         url;
+    QWebSocket                                   socket;
+    QTimer                                       reconnectTimer;
+    int                                          backoff = 0;  //!< Current reconnection delay in ms
+    std::unordered_set<std::string>              topics{};     //!< Upstream topics and patterns with local subscribers
+    std::unordered_set<std::string>              relayed{};    //!< Local topics relayed so far, announced to wildcard subscriptions
+
+    std::mutex                                   lastMutex;
+    std::unordered_map<std::string, std::string> lastMessages{};  //!< Latest message of each relayed topic, by local topic
+};
+
+//! Relays topics of other Quasar instances to local clients
+/*! Upstream topics are published locally under the upstream's name, such as
+    \c host1:pulse_viz/band for \c pulse_viz/band on the upstream named \c host1.
+    Each upstream gets a single WebSocket connection, which is subscribed to a topic
+    for as long as it has local subscribers. Relayed messages are published to
+    local subscribers like any other topic.
+
+    Upstreams are given as a comma separated list of \c name=url entries.
+*/
+class Relay : public TopicProvider
+{
+public:
+    Relay(const Relay&)             = delete;
+    Relay& operator= (const Relay&) = delete;
+
+    Relay(Server& serv, const std::string& upstreamList);
+    ~Relay();
+
+    //! Whether a topic belongs to a configured upstream
+    bool        Provides(std::string_view topic) const override;
+
+    //! Subscribes to an upstream topic while it has local subscribers
+    void        SetSubscribers(std::string_view topic, int count) override;
+
+    //! Latest relayed message of a topic, empty if none was received yet
+    std::string LastMessage(std::string_view topic) const override;
+
+private:
+    //! Splits a relayed topic into its upstream and upstream topic
+    //! \return Upstream, or nullptr if the topic is not relayed
+    RelayUpstream* find(std::string_view topic, std::string_view& remote) const;
+
+    QThread                                                         thread;
+    std::unordered_map<std::string, std::unique_ptr<RelayUpstream>> upstreams{};  //!< Upstreams by name, fixed after construction
+};
@@ -0,0 +1,722 @@
+#include "requestparser.h"
+
+#include <limits>
+
+namespace
+{
+    // Nesting limit for skipped values
+    constexpr int MAX_DEPTH = 32;
+
+    class Reader
+    {
+    public:
+        Reader(std::string_view frame, std::pmr::memory_resource* res) : src{frame}, arena{res} {}
+
+        bool             parseRequest(ClientRequest& req);
+
+        std::string_view error() const { return err; }
+
+    private:
+        bool fail(std::string_view msg)
+        {
+            if (err.empty())
+            {
+                err = msg;
+            }
+
+            return false;
+        }
+
+        void skipWhitespace()
+        {
+            while (pos < src.size() and (src[pos] == ' ' or src[pos] == '\t' or src[pos] == '\n' or src[pos] == '\r'))
+            {
+                pos++;
+            }
+        }
+
+        bool consume(char c)
+        {
+            skipWhitespace();
+
+            if (pos < src.size() and src[pos] == c)
+            {
+                pos++;
+                return true;
+            }
+
+            return false;
+        }
+
+        char peek()
+        {
+            skipWhitespace();
+            return pos < src.size() ? src[pos] : '\0';
+        }
+
+        //! Parses the 4 hex digits of a unicode escape
+        bool parseHex(uint32_t& out)
+        {
+            if (pos + 4 > src.size())
+            {
+                return fail("Truncated unicode escape");
+            }
+
+            out = 0;
+
+            for (size_t i = 0; i < 4; i++)
+            {
+                const char c = src[pos++];
+                out <<= 4;
+
+                if (c >= '0' and c <= '9')
+                {
+                    out |= c - '0';
+                }
+                else if (c >= 'a' and c <= 'f')
+                {
+                    out |= c - 'a' + 10;
+                }
+                else if (c >= 'A' and c <= 'F')
+                {
+                    out |= c - 'A' + 10;
+                }
+                else
+                {
+                    return fail("Invalid unicode escape");
+                }
+            }
+
+            return true;
+        }
+
+        //! Decodes 4 hex digits that were already validated
+        static uint32_t hexValue(std::string_view digits)
+        {
+            uint32_t value = 0;
+
+            for (char c : digits.substr(0, 4))
+            {
+                value = (value << 4) | ((c <= '9') ? c - '0' : (c | 0x20) - 'a' + 10);
+            }
+
+            return value;
+        }
+
+        static size_t encodeUtf8(uint32_t cp, char* out)
+        {
+            if (cp < 0x80)
+            {
+                out[0] = static_cast<char>(cp);
+                return 1;
+            }
+
+            if (cp < 0x800)
+            {
+                out[0] = static_cast<char>(0xC0 | (cp >> 6));
+                out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+                return 2;
+            }
+
+            if (cp < 0x10000)
+            {
+                out[0] = static_cast<char>(0xE0 | (cp >> 12));
+                out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+                return 3;
+            }
+
+            out[0] = static_cast<char>(0xF0 | (cp >> 18));
+            out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+            return 4;
+        }
+
+        //! Validates an escape sequence and moves past it
+        bool scanEscape()
+        {
+            if (pos + 1 >= src.size())
+            {
+                return fail("Unterminated string");
+            }
+
+            const char c = src[pos + 1];
+            pos += 2;
+
+            if (c != 'u')
+            {
+                return std::string_view{"\"\\/bfnrt"}.find(c) != std::string_view::npos or fail("Invalid escape sequence");
+            }
+
+            uint32_t cp = 0;
+
+            if (!parseHex(cp))
+            {
+                return false;
+            }
+
+            if (cp >= 0xDC00 and cp <= 0xDFFF)
+            {
+                return fail("Unpaired surrogate in unicode escape");
+            }
+
+            if (cp < 0xD800 or cp > 0xDBFF)
+            {
+                return true;
+            }
+
+            // A high surrogate must be followed by a low one
+            if (pos + 1 >= src.size() or src[pos] != '\\' or src[pos + 1] != 'u')
+            {
+                return fail("Unpaired surrogate in unicode escape");
+            }
+
+            pos += 2;
+
+            if (!parseHex(cp))
+            {
+                return false;
+            }
+
+            return (cp >= 0xDC00 and cp <= 0xDFFF) or fail("Unpaired surrogate in unicode escape");
+        }
+
+        //! Validates a multibyte UTF-8 sequence and moves past it
+        bool scanUtf8()
+        {
+            const auto lead = static_cast<unsigned char>(src[pos]);
+
+            size_t     len  = 0;
+            unsigned   lo   = 0x80;
+            unsigned   hi   = 0xBF;
+
+            // Overlong forms, surrogates and code points past U+10FFFF are rejected by the second byte
+            if (lead >= 0xC2 and lead <= 0xDF)
+            {
+                len = 2;
+            }
+            else if (lead >= 0xE0 and lead <= 0xEF)
+            {
+                len = 3;
+                lo  = (lead == 0xE0) ? 0xA0 : lo;
+                hi  = (lead == 0xED) ? 0x9F : hi;
+            }
+            else if (lead >= 0xF0 and lead <= 0xF4)
+            {
+                len = 4;
+                lo  = (lead == 0xF0) ? 0x90 : lo;
+                hi  = (lead == 0xF4) ? 0x8F : hi;
+            }
+            else
+            {
+                return fail("Invalid UTF-8 in string");
+            }
+
+            if (pos + len > src.size())
+            {
+                return fail("Unterminated string");
+            }
+
+            for (size_t i = 1; i < len; i++)
+            {
+                const auto c = static_cast<unsigned char>(src[pos + i]);
+
+                if (c < lo or c > hi)
+                {
+                    return fail("Invalid UTF-8 in string");
+                }
+
+                lo = 0x80;
+                hi = 0xBF;
+            }
+
+            pos += len;
+
+            return true;
+        }
+
+        //! Validates a string and moves past it
+        /*! \param[out] raw     Contents between the quotes, still escaped
+            \param[out] escaped Whether the contents hold escape sequences
+        */
+        bool scanString(std::string_view& raw, bool& escaped)
+        {
+            if (!consume('"'))
+            {
+                return fail("Expected string");
+            }
+
+            const size_t start = pos;
+            escaped            = false;
+
+            while (true)
+            {
+                if (pos >= src.size())
+                {
+                    return fail("Unterminated string");
+                }
+
+                const auto c = static_cast<unsigned char>(src[pos]);
+
+                if (c == '"')
+                {
+                    break;
+                }
+
+                if (c < 0x20)
+                {
+                    return fail("Unescaped control character in string");
+                }
+
+                if (c == '\\')
+                {
+                    escaped = true;
+
+                    if (!scanEscape())
+                    {
+                        return false;
+                    }
+                }
+                else if (c >= 0x80)
+                {
+                    if (!scanUtf8())
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    pos++;
+                }
+            }
+
+            raw = src.substr(start, pos - start);
+            pos++;
+
+            return true;
+        }
+
+        //! Parses a string, unescaping into the arena only if needed
+        bool parseString(std::string_view& out, bool terminate = false)
+        {
+            std::string_view raw;
+            bool             escaped = false;
+
+            if (!scanString(raw, escaped))
+            {
+                return false;
+            }
+
+            if (!escaped and !terminate)
+            {
+                out = raw;
+                return true;
+            }
+
+            // Unescaped text is never longer than its escaped form
+            auto   buf = static_cast<char*>(arena->allocate(raw.size() + 1, alignof(char)));
+            size_t len = 0;
+
+            for (size_t i = 0; i < raw.size(); i++)
+            {
+                if (raw[i] != '\\')
+                {
+                    buf[len++] = raw[i];
+                    continue;
+                }
+
+                switch (raw[++i])
+                {
+                    case 'b':
+                        buf[len++] = '\b';
+                        break;
+                    case 'f':
+                        buf[len++] = '\f';
+                        break;
+                    case 'n':
+                        buf[len++] = '\n';
+                        break;
+                    case 'r':
+                        buf[len++] = '\r';
+                        break;
+                    case 't':
+                        buf[len++] = '\t';
+                        break;
+                    case 'u':
+                        {
+                            // Surrogates were paired by scanString()
+                            uint32_t cp = hexValue(raw.substr(i + 1));
+                            i += 4;
+
+                            if (cp >= 0xD800 and cp <= 0xDBFF)
+                            {
+                                cp = 0x10000 + ((cp - 0xD800) << 10) + (hexValue(raw.substr(i + 3)) - 0xDC00);
+                                i += 6;
+                            }
+
+                            len += encodeUtf8(cp, buf + len);
+                            break;
+                        }
+                    default:
+                        buf[len++] = raw[i];
+                        break;
+                }
+            }
+
+            buf[len] = '\0';
+            out      = std::string_view{buf, len};
+
+            return true;
+        }
+
+        //! Parses a non-negative integer, saturating at the maximum of \p T
+        template<typename T>
+        bool parseUnsigned(T& out)
+        {
+            skipWhitespace();
+
+            const size_t start = pos;
+            T            value = 0;
+
+            while (pos < src.size() and src[pos] >= '0' and src[pos] <= '9')
+            {
+                const T digit = src[pos++] - '0';
+                value         = (value > (std::numeric_limits<T>::max() - digit) / 10) ? std::numeric_limits<T>::max() : value * 10 + digit;
+            }
+
+            if (pos == start or (src[start] == '0' and pos - start > 1))
+            {
+                return fail("Expected unsigned integer");
+            }
+
+            out = value;
+
+            return true;
+        }
+
+        bool parseStringList(std::optional<ClientRequest::ViewList>& out)
+        {
+            if (!consume('['))
+            {
+                return fail("Expected array of strings");
+            }
+
+            out.emplace(arena);
+
+            if (consume(']'))
+            {
+                return true;
+            }
+
+            do
+            {
+                std::string_view str;
+
+                if (!parseString(str))
+                {
+                    return false;
+                }
+
+                out->push_back(str);
+            } while (consume(','));
+
+            return consume(']') or fail("Expected ']'");
+        }
+
+        bool skipValue(int depth = 0)
+        {
+            if (depth > MAX_DEPTH)
+            {
+                return fail("Maximum nesting depth exceeded");
+            }
+
+            const char c = peek();
+
+            if (c == '"')
+            {
+                // Validate without unescaping
+                std::string_view raw;
+                bool             escaped = false;
+
+                return scanString(raw, escaped);
+            }
+
+            if (c == '{' or c == '[')
+            {
+                const char close = (c == '{') ? '}' : ']';
+                pos++;
+
+                if (consume(close))
+                {
+                    return true;
+                }
+
+                do
+                {
+                    if (c == '{')
+                    {
+                        std::string_view key;
+                        bool             escaped = false;
+
+                        if (!scanString(key, escaped) or !consume(':'))
+                        {
+                            return fail("Expected object member");
+                        }
+                    }
+
+                    if (!skipValue(depth + 1))
+                    {
+                        return false;
+                    }
+                } while (consume(','));
+
+                return consume(close) or fail("Unterminated object or array");
+            }
+
+            if (c == 't' or c == 'f' or c == 'n')
+            {
+                return skipLiteral();
+            }
+
+            return skipNumber();
+        }
+
+        bool skipLiteral()
+        {
+            for (std::string_view literal : {"true", "false", "null"})
+            {
+                if (src.substr(pos, literal.size()) == literal)
+                {
+                    pos += literal.size();
+                    return true;
+                }
+            }
+
+            return fail("Invalid literal");
+        }
+
+        //! Validates a number, as -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+        bool skipNumber()
+        {
+            auto digits = [this] {
+                const size_t start = pos;
+
+                while (pos < src.size() and src[pos] >= '0' and src[pos] <= '9')
+                {
+                    pos++;
+                }
+
+                return pos - start;
+            };
+
+            if (pos < src.size() and src[pos] == '-')
+            {
+                pos++;
+            }
+
+            if (pos < src.size() and src[pos] == '0')
+            {
+                pos++;
+            }
+            else if (digits() == 0)
+            {
+                return fail("Unexpected character");
+            }
+
+            if (pos < src.size() and src[pos] == '.')
+            {
+                pos++;
+
+                if (digits() == 0)
+                {
+                    return fail("Invalid number");
+                }
+            }
+
+            if (pos < src.size() and (src[pos] == 'e' or src[pos] == 'E'))
+            {
+                pos++;
+
+                if (pos < src.size() and (src[pos] == '+' or src[pos] == '-'))
+                {
+                    pos++;
+                }
+
+                if (digits() == 0)
+                {
+                    return fail("Invalid number");
+                }
+            }
+
+            return true;
+        }
+
+        //! Consumes a null value, which leaves an optional member unset
+        template<typename T>
+        bool parseNull(std::optional<T>& out)
+        {
+            if (peek() != 'n' or src.substr(pos, 4) != "null")
+            {
+                return false;
+            }
+
+            pos += 4;
+            out.reset();
+
+            return true;
+        }
+
+        bool parseParams(ClientRequest& req)
+        {
+            if (!consume('{'))
+            {
+                return fail("Expected object for 'params'");
+            }
+
+            if (consume('}'))
+            {
+                return true;
+            }
+
+            do
+            {
+                std::string_view key;
+
+                if (!parseString(key) or !consume(':'))
+                {
+                    return fail("Expected member in 'params'");
+                }
+
+                bool ok = true;
+
+                if (key == "topics")
+                {
+                    ok = parseNull(req.topics) or parseStringList(req.topics);
+                }
+                else if (key == "params")
+                {
+                    ok = parseNull(req.params) or parseStringList(req.params);
+                }
+                else if (key == "code")
+                {
+                    ok = parseNull(req.code) or parseString(req.code.emplace());
+                }
+                else if (key == "args")
+                {
+                    // Passed on to extensions as a C string
+                    ok = parseNull(req.args) or parseString(req.args.emplace(), true);
+                }
+                else if (key == "delta")
+                {
+                    ok = parseNull(req.delta) or parseString(req.delta.emplace());
+                }
+                else if (key == "backfill")
+                {
+                    ok = parseNull(req.backfill) or parseUnsigned(req.backfill.emplace());
+                }
+                else if (key == "from")
+                {
+                    ok = parseNull(req.from) or parseUnsigned(req.from.emplace());
+                }
+                else if (key == "to")
+                {
+                    ok = parseNull(req.to) or parseUnsigned(req.to.emplace());
+                }
+                else if (key == "resolution")
+                {
+                    ok = parseNull(req.resolution) or parseString(req.resolution.emplace());
+                }
+                else
+                {
+                    ok = skipValue();
+                }
+
+                if (!ok)
+                {
+                    return false;
+                }
+            } while (consume(','));
+
+            return consume('}') or fail("Expected '}'");
+        }
+
+        std::string_view           src;
+        size_t                     pos = 0;
+        std::pmr::memory_resource* arena;
+        std::string_view           err{};
+    };
+
+    bool Reader::parseRequest(ClientRequest& req)
+    {
+        if (!consume('{'))
+        {
+            return fail("Expected object");
+        }
+
+        bool hasMethod = false;
+        bool hasParams = false;
+
+        if (!consume('}'))
+        {
+            do
+            {
+                std::string_view key;
+
+                if (!parseString(key) or !consume(':'))
+                {
+                    return fail("Expected member");
+                }
+
+                bool ok = true;
+
+                if (key == "method")
+                {
+                    ok        = parseString(req.method);
+                    hasMethod = true;
+                }
+                else if (key == "params")
+                {
+                    ok        = parseParams(req);
+                    hasParams = true;
+                }
+                else
+                {
+                    ok = skipValue();
+                }
+
+                if (!ok)
+                {
+                    return false;
+                }
+            } while (consume(','));
+
+            if (!consume('}'))
+            {
+                return fail("Expected '}'");
+            }
+        }
+
+        if (!hasMethod or !hasParams)
+        {
+            return fail("Missing 'method' or 'params'");
+        }
+
+        skipWhitespace();
+
+        return pos == src.size() or fail("Trailing characters");
+    }
+}  // namespace
+
+bool RequestParser::Parse(std::string_view frame, ClientRequest& request, std::string_view& error)
+{
+    Reader reader{frame, request.arena};
+
+    if (!reader.parseRequest(request))
+    {
+        error = reader.error();
+        return false;
+    }
+
+    return true;
+}
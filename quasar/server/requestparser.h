@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string_view>
+
+#include "protocol.h"
+
+//! In place parser for client requests
+namespace RequestParser
+{
+    //! Parses a client request without copying the frame
+    /*! Only the fields of the client message schema are decoded, anything else
+        is validated and skipped. Strings without escape sequences are returned as
+        views into \p frame, all other storage is taken from the request's arena.
+
+        \param[in]      frame   Received frame
+        \param[in,out]  request Request to fill \sa ClientRequest
+        \param[out]     error   Description of the parse error, if any
+        \return true if successful, false otherwise
+    */
+    bool Parse(std::string_view frame, ClientRequest& request, std::string_view& error);
+}  // namespace RequestParser
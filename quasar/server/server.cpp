@@ -1,6 +1,12 @@
 #include "server.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <condition_variable>
+#include <map>
+#include <memory_resource>
+#include <ranges>
 
 #include "uwebsockets/App.h"
 
@@ -10,11 +16,23 @@
 
 #include "extension/extension.h"
 
+#include "localsocket.h"
+#include "derivedtopics.h"
+#include "relay.h"
+#include "topicbus.h"
+#include "requestparser.h"
+#include "sharedmirror.h"
+#include "timeseries.h"
+#include "topicindex.h"
+#include "topiclog.h"
+
 #include "internal/ajax.h"
 #include "internal/applauncher.h"
+#include "internal/metrics.h"
 
 #include <QCoreApplication>
 #include <QDir>
+#include <QStandardPaths>
 #include <QtNetworkAuth>
 
 #include <spdlog/spdlog.h>
@@ -26,11 +44,19 @@
     sendErrorToClient(d, fmt::format(__VA_ARGS__)); \
     SPDLOG_WARN(__VA_ARGS__);
 
-JSONCONS_N_MEMBER_TRAITS(ClientMsgParams, 0, topics, params, code, args);
-JSONCONS_ALL_MEMBER_TRAITS(ClientMessage, method, params);
 JSONCONS_ALL_MEMBER_TRAITS(ErrorOnlyMessage, errors);
 
-using UWSSocket = uWS::WebSocket<false, true, PerSocketData>;
+using UWSSocket    = uWS::WebSocket<false, true, PerSocketData>;
+using HttpResponse = uWS::HttpResponse<false>;
+
+//! An HTTP response written to by an in-process client
+struct HttpStream
+{
+    HttpResponse*                res = nullptr;
+    std::weak_ptr<PerSocketData> client{};
+    std::string                  buffer{};      //!< Event being written
+    bool                         done = false;  //!< The response was ended or aborted
+};
 
 namespace
 {
@@ -42,25 +68,177 @@ namespace
     std::mutex              serverMutex;
     std::condition_variable scv;
 
-    std::set<std::string>   authcodes;
+    // Unused auth codes and the widget each was generated for
+    std::map<std::string, std::string, std::less<>> authcodes;
     std::mutex              authMutex;
+
+    // Clients buffering more than this are considered congested
+    constexpr unsigned int  CONGESTION_THRESHOLD = 64 * 1024;
+
+    // Received frame buffers kept for reuse
+    constexpr size_t        FRAME_POOL_SIZE      = 64;
+
+    // Per thread parsing arena size
+    constexpr size_t        REQUEST_ARENA_SIZE   = 16 * 1024;
+
+    // Keeps Server-Sent Events streams from hitting the uWS HTTP idle timeout
+    constexpr auto             STREAM_HEARTBEAT_INTERVAL = std::chrono::seconds(5);
+
+    constexpr std::string_view TOPICS_PATH               = "/topics/";
+
+    // Time range and size of history replies that do not specify them
+    constexpr auto             HISTORY_DEFAULT_RANGE     = std::chrono::hours(1);
+    constexpr int64_t          HISTORY_MAX_ROWS          = 3600;
+
+    //! Whether a client's subscription to a channel is paused, explicitly or because its widget is hidden
+    bool isPaused(const PerSocketData* client, const std::string& channel)
+    {
+        return client->hidden or client->paused.contains(channel);
+    }
+
+    //! Whether a frame can be written to a client without queueing it
+    bool isWritable(PerSocketData* client)
+    {
+        // In-process clients are only congested if their transport says so
+        if (client->deliver)
+        {
+            return !client->writable or client->writable();
+        }
+
+        return static_cast<UWSSocket*>(client->socket)->getBufferedAmount() < CONGESTION_THRESHOLD;
+    }
+
+    //! Whether a client takes frames as they are published, with nothing queued or held back
+    bool keepsUp(PerSocketData* client)
+    {
+        return client->reliable.empty() and client->latest.empty() and !client->backlogged and isWritable(client);
+    }
+
+    //! Prefix of the uWS topics channels are published to, joined by the subscribers that keep up \sa Server::updateLive()
+    constexpr std::string_view LIVE_PREFIX = "\x1flive/";
+
+    std::string liveTopic(std::string_view channel)
+    {
+        return std::string{LIVE_PREFIX}.append(channel);
+    }
+
+    bool isDeltaChannel(std::string_view channel)
+    {
+        return channel.ends_with(DeltaChannelSuffix(DELTA_MERGE)) or channel.ends_with(DeltaChannelSuffix(DELTA_PATCH));
+    }
+
+    void writeFrame(PerSocketData* client, const std::string& data, const SendOptions& options)
+    {
+        if (client->deliver)
+        {
+            client->deliver(data);
+        }
+        else
+        {
+            static_cast<UWSSocket*>(client->socket)->send(data, uWS::TEXT, options.compress);
+        }
+    }
+
+    //! Compares a received code with a secret, in a time that only depends on the secret's length
+    bool matchesSecret(std::string_view code, std::string_view secret)
+    {
+        volatile unsigned char diff = code.size() != secret.size();
+
+        for (size_t i = 0; i < secret.size(); i++)
+        {
+            diff = diff | static_cast<unsigned char>(secret[i] ^ (i < code.size() ? code[i] : 0));
+        }
+
+        return diff == 0;
+    }
+
+    //! Checks the auth code of an HTTP request, from a bearer Authorization header or the code query parameter
+    /*! Codes are single use, as for WebSocket clients, except for the configured API token.
+        Rejected requests are answered with 401.
+        \return Whether the request may proceed
+    */
+    bool authorizeRequest(HttpResponse* res, uWS::HttpRequest* req)
+    {
+        if (!Settings::internal.auth.GetValue())
+        {
+            return true;
+        }
+
+        constexpr std::string_view bearer = "Bearer ";
+
+        auto                       code   = req->getHeader("authorization");
+
+        if (code.starts_with(bearer))
+        {
+            code.remove_prefix(bearer.size());
+        }
+        else
+        {
+            code = req->getQuery("code").value_or(std::string_view{});
+        }
+
+        // Lets HTTP consumers authenticate without a widget to create codes for them
+        if (auto token = Settings::internal.api_token.GetValue(); !token.empty() and matchesSecret(code, token))
+        {
+            return true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(authMutex);
+
+            if (auto search = authcodes.find(code); !code.empty() and search != authcodes.end())
+            {
+                authcodes.erase(search);
+                return true;
+            }
+        }
+
+        SPDLOG_WARN("Rejected unauthenticated HTTP request for {}", req->getUrl());
+        res->writeStatus("401 Unauthorized")->end("Unauthenticated client");
+        return false;
+    }
+
+    //! Error answering the query of a topic that has no data yet
+    std::string noDataError(std::string_view topic)
+    {
+        return fmt::format("No data yet for topic {}", topic);
+    }
+
+    uWS::CompressOptions    getCompressOptions(int compressor)
+    {
+        switch (compressor)
+        {
+            case Settings::Compressor::shared_compressor:
+                return uWS::SHARED_COMPRESSOR;
+            case Settings::Compressor::dedicated_compressor:
+                return uWS::DEDICATED_COMPRESSOR;
+            default:
+                return uWS::DISABLED;
+        }
+    }
 }  // namespace
 
 Server::Server(std::shared_ptr<Config> cfg) :
-    methods{
-        {"subscribe", std::bind(&Server::handleMethodSubscribe, this, std::placeholders::_1, std::placeholders::_2)},
-        {    "query",     std::bind(&Server::handleMethodQuery, this, std::placeholders::_1, std::placeholders::_2)},
-        {     "auth",      std::bind(&Server::handleMethodAuth, this, std::placeholders::_1, std::placeholders::_2)},
-},
-    config{cfg}
+    config{cfg},
+    compressor{Settings::internal.compression.GetValue()}
 {
     using namespace std::literals;
+
+    framePool.reserve(FRAME_POOL_SIZE);
+
+    // Created before the server thread, which is the only one appending to it
+    if (!Settings::launch.record.empty())
+    {
+        recorder = std::make_unique<TopicRecorder>(Settings::launch.record, Settings::launch.record_topics);
+    }
+
     websocketServer = std::jthread{[this]() {
         loop = uWS::Loop::get();
         app  = new uWS::App();
 
         app->ws<PerSocketData>("/*",
                {/* Settings */
+                   .compression      = getCompressOptions(compressor),
                    .maxPayloadLength = 16 * 1024,
                    .idleTimeout      = 0,
                    .maxBackpressure  = 1 * 1024 * 1024,
@@ -79,6 +257,8 @@ Server::Server(std::shared_ptr<Config> cfg) :
                            auto data    = ws->getUserData();
                            data->socket = ws;
 
+                           connectedClients.insert(data);
+
                            SPDLOG_INFO("New client connected!");
 
                            if (Settings::internal.auth.GetValue())
@@ -88,9 +268,12 @@ Server::Server(std::shared_ptr<Config> cfg) :
                                    std::this_thread::sleep_for(10s);
                                    if (!data->authenticated)
                                    {
-                                       RunOnServer([=]() {
-                                           auto socket = static_cast<UWSSocket*>(data->socket);
-                                           socket->end(0, "Unauthenticated client");
+                                       RunOnServer([=, this]() {
+                                           if (connectedClients.contains(data))
+                                           {
+                                               auto socket = static_cast<UWSSocket*>(data->socket);
+                                               socket->end(0, "Unauthenticated client");
+                                           }
                                        });
                                    }
                                });
@@ -98,13 +281,26 @@ Server::Server(std::shared_ptr<Config> cfg) :
                        },
                    .message =
                        [this](UWSSocket* ws, std::string_view message, uWS::OpCode opCode) {
-                           RunOnPool([data = ws->getUserData(), this, msg = std::string{message}] {
-                               this->processMessage(data, msg);
+                           auto frame    = acquireFrame();
+                           frame->client = ws->getUserData();
+                           frame->data.assign(message);
+
+                           RunOnPool([frame, this] {
+                               this->processMessage(frame->client, frame->data);
+                               this->releaseFrame(frame);
                            });
                        },
+                   .drain =
+                       [this](UWSSocket* ws) {
+                           this->flushClient(ws->getUserData());
+                       },
                    .subscription =
                        [this](UWSSocket* ws, std::string_view topic, int nSize, int oSize) {
-                           this->processSubscription(ws->getUserData(), std::string{topic}, nSize, oSize);
+                           // Joining the shared publish of a channel is not a subscription
+                           if (!topic.starts_with(LIVE_PREFIX))
+                           {
+                               this->processSubscription(ws->getUserData(), std::string{topic}, nSize, oSize);
+                           }
                        },
                    .close =
                        [this](UWSSocket* ws, int code, std::string_view message) {
@@ -114,6 +310,14 @@ Server::Server(std::shared_ptr<Config> cfg) :
 
                            SPDLOG_INFO("Client disconnected.");
                        }})
+            .get("/topics/*",
+                [this](auto* res, auto* req) {
+                    this->serveTopic(res, req);
+                })
+            .get("/stream",
+                [this](auto* res, auto* req) {
+                    this->serveStream(res, req);
+                })
             .listen("localhost",
                 Settings::internal.port.GetValue(),
                 [](auto* socket) {
@@ -145,7 +349,57 @@ Server::Server(std::shared_ptr<Config> cfg) :
         });
     }
 
-    this->loadExtensions();
+    topicBus = std::make_unique<TopicBus>(*this);
+
+    if (!Settings::launch.replay.empty())
+    {
+        // Replayed topics stand in for those of extensions
+        replayer = std::make_unique<TopicReplayer>(*this, Settings::launch.replay, Settings::launch.replay_speed, Settings::launch.replay_loop);
+    }
+    else
+    {
+        this->loadExtensions();
+        topicBus->Start();
+    }
+
+    if (Settings::internal.local_socket.GetValue())
+    {
+        localSocket = std::make_unique<LocalSocketServer>(*this, LocalSocketServer::DefaultPath());
+    }
+
+    if (!Settings::internal.relay_upstreams.GetValue().empty())
+    {
+        relay = std::make_unique<Relay>(*this, Settings::internal.relay_upstreams.GetValue());
+    }
+
+    if (!Settings::internal.derived_topics.GetValue().empty())
+    {
+        derived = std::make_unique<DerivedTopics>(*this, Settings::internal.derived_topics.GetValue());
+    }
+
+    // Extensions are only modified while loading, and metrics are queried
+    // through handleMethodQuery which already holds extensionMutex
+    metrics_add_provider("server", [this](jsoncons::json& j) {
+        j["topics"] = jsoncons::json{jsoncons::json_object_arg};
+
+        for (auto&& [name, ext] : extensions)
+        {
+            ext->GetMetricsJSON(j["topics"]);
+        }
+
+        j["replacedFrames"] = replacedFrames.load();
+
+        const auto batches  = commandStats.batches.load();
+        const auto count    = commandStats.commands.load();
+
+        j["handoff"]        = jsoncons::json{
+            jsoncons::json_object_arg,
+            {{"batches", batches},
+              {"commands", count},
+              {"maxBatch", commandStats.maxBatch.load()},
+              {"averageBatch", batches > 0 ? static_cast<double>(count) / batches : 0.0}}
+        };
+    });
 
     // Force QtNetworkAuth linkage
     QOAuth2AuthorizationCodeFlow oauth2;
@@ -153,6 +407,15 @@ Server::Server(std::shared_ptr<Config> cfg) :
 
 Server::~Server()
 {
+    // Disconnects its clients through the server thread
+    localSocket.reset();
+    streamHeartbeat.reset();
+    relay.reset();
+    replayer.reset();
+    derived.reset();
+
+    metrics_remove_provider("server");
+
     loop->defer([]() {
         app->close();
     });
@@ -161,6 +424,7 @@ Server::~Server()
 
     websocketServer.join();
 
+    recorder.reset();
     extensions.clear();
 }
 
@@ -170,269 +434,1259 @@ bool Server::FindExtension(const std::string& extcode)
     return (extensions.count(extcode) > 0);
 }
 
-void Server::SendDataToClient(PerSocketData* client, const std::string& msg)
+void Server::SendDataToClient(PerSocketData* client, std::string msg, SendOptions options)
 {
-    auto socket = static_cast<UWSSocket*>(client->socket);
-
-    RunOnServer([=]() {
-        socket->send(msg, uWS::TEXT);
-    });
+    queueCommand({.type = ServerCommand::SEND, .client = client, .data = std::move(msg), .options = options});
 }
 
-void Server::PublishData(std::string_view topic, const std::string& data)
+void Server::PublishData(std::string_view topic, const std::string& data, SendOptions options)
 {
-    RunOnServer([=]() {
-        app->publish(topic, data, uWS::TEXT);
-    });
+    queueCommand({.type = ServerCommand::PUBLISH, .channel = std::string{topic}, .data = data, .options = options});
 }
 
-void Server::RunOnServer(auto&& cb)
+void Server::RunOnServer(std::function<void()>&& cb)
 {
-    loop->defer(cb);
+    queueCommand({.type = ServerCommand::TASK, .task = std::move(cb)});
 }
 
-void Server::UpdateSettings()
+InboundFrame* Server::acquireFrame()
 {
-    RunOnServer([=, this] {
-        std::lock_guard<std::shared_mutex> lk(extensionMutex);
-        for (auto&& [name, ext] : extensions)
+    {
+        std::lock_guard<std::mutex> lk(framePoolMutex);
+
+        if (!framePool.empty())
         {
-            ext->UpdateExtensionSettings();
-            ext->WriteDataSourceSettings();
-            ext->WriteExtensionSettings();
+            auto frame = framePool.back().release();
+            framePool.pop_back();
+            return frame;
         }
-    });
+    }
+
+    return new InboundFrame{};
 }
 
-std::string Server::GenerateAuthCode()
+void Server::releaseFrame(InboundFrame* frame)
 {
-    if (!Settings::internal.auth.GetValue())
-    {
-        return std::string{"dummycode"};
-    }
+    std::unique_ptr<InboundFrame> ptr{frame};
 
-    quint64 h   = QRandomGenerator::global()->generate64();
-    quint64 l   = QRandomGenerator::global()->generate64();
-    QString hv  = QString::number(h, 16).toUpper() + QString::number(l, 16).toUpper();
+    std::lock_guard<std::mutex>   lk(framePoolMutex);
 
-    auto    str = hv.toStdString();
+    if (framePool.size() < FRAME_POOL_SIZE)
+    {
+        framePool.push_back(std::move(ptr));
+    }
+}
 
-    authcodes.insert(str);
+void Server::queueCommand(ServerCommand&& cmd)
+{
+    commands.push(std::move(cmd));
 
-    return str;
+    // Only the first command of a batch wakes the loop
+    if (!drainScheduled.exchange(true, std::memory_order_acq_rel))
+    {
+        loop->defer([this]() {
+            drainCommands();
+        });
+    }
 }
 
-void Server::loadExtensions()
+void Server::drainCommands()
 {
-    const auto libTypes = QStringList() << "*.dll"
-                                        << "*.so"
-                                        << "*.dylib";
-    auto          path = QUtil::GetCommonAppDataPath() + "extensions/";
+    // Commands queued after this point schedule a new batch
+    drainScheduled.exchange(false, std::memory_order_acq_rel);
 
-    QDir          dir(path);
-    QFileInfoList list = dir.entryInfoList(libTypes, QDir::Files);
+    uint64_t count = 0;
 
-    // Also check executable path
-    auto extdir = QDir(QCoreApplication::applicationDirPath() + "/extensions/");
-    list.append(extdir.entryInfoList(libTypes, QDir::Files));
+    while (auto cmd = commands.pop())
+    {
+        count++;
 
-    if (list.count() == 0)
+        switch (cmd->type)
+        {
+            case ServerCommand::SEND:
+                if (connectedClients.contains(cmd->client))
+                {
+                    deliverToClient(cmd->client, {}, cmd->data, cmd->options);
+                }
+                break;
+            case ServerCommand::PUBLISH:
+                {
+                    if (recorder)
+                    {
+                        recorder->Append(cmd->channel, cmd->data);
+                    }
+
+                    // Subscribers that keep up share a single publish, and its permessage-deflate compression
+                    app->publish(liveTopic(cmd->channel), cmd->data, uWS::TEXT, cmd->options.compress);
+
+                    auto it = channelClients.find(cmd->channel);
+
+                    if (it != channelClients.end())
+                    {
+                        for (auto&& client : it->second)
+                        {
+                            if (client->live.contains(cmd->channel))
+                            {
+                                // Later frames go through the client's own queue until it catches up
+                                if (!isWritable(client))
+                                {
+                                    updateLive(client);
+                                }
+
+                                continue;
+                            }
+
+                            // Paused clients still receive messages that must not be lost
+                            if (!cmd->options.reliable and isPaused(client, cmd->channel))
+                            {
+                                continue;
+                            }
+
+                            deliverToClient(client, cmd->channel, cmd->data, cmd->options);
+                        }
+                    }
+
+                    break;
+                }
+            case ServerCommand::TASK:
+                cmd->task();
+                break;
+        }
+    }
+
+    if (count > 0)
     {
-        SPDLOG_INFO("No data extensions found");
+        commandStats.batches++;
+        commandStats.commands += count;
+
+        if (count > commandStats.maxBatch.load(std::memory_order_relaxed))
+        {
+            commandStats.maxBatch.store(count, std::memory_order_relaxed);
+        }
+    }
+}
+
+void Server::deliverToClient(PerSocketData* client, std::string_view channel, const std::string& data, const SendOptions& options)
+{
+    // Send straight away unless the client is falling behind
+    if (client->reliable.empty() and client->latest.empty() and !client->backlogged and isWritable(client))
+    {
+        writeFrame(client, data, options);
         return;
     }
 
-    // just lock the whole thing while initializing extensions at startup
-    // to prevent out of order reads
+    if (!client->live.empty())
     {
-        std::lock_guard<std::shared_mutex> lk(extensionMutex);
+        updateLive(client);
+    }
 
-        // First load internal extensions
+    if (options.reliable or channel.empty())
+    {
+        // A queued frame of the channel would be sent after the one that supersedes it
+        if (!channel.empty())
         {
-            // App Launcher
-            std::string name = "applauncher";
-            Extension*  extn = Extension::LoadInternal(name, applauncher_load, applauncher_destroy, config.lock(), this);
+            client->latest.erase(std::string{channel});
+        }
 
-            if (!extn)
-            {
-                SPDLOG_WARN("Failed to load extension {}", name);
-            }
-            else if (extensions.count(extn->GetName()))
-            {
-                SPDLOG_WARN("Extension with code {} already loaded. Unloading {}", extn->GetName(), name);
-            }
-            else
-            {
-                try
-                {
-                    extn->Initialize();
-                } catch (std::exception e)
-                {
-                    SPDLOG_WARN("Exception: {} while initializing {}", e.what(), name);
-                    delete extn;
-                    extn = nullptr;
-                }
+        client->reliable.push_back({data, options});
+    }
+    else
+    {
+        // Latest value wins
+        auto [it, inserted] = client->latest.try_emplace(std::string{channel}, PendingFrame{data, options});
 
-                SPDLOG_INFO("Extension {} loaded.", extn->GetName());
-                extensions[extn->GetName()].reset(extn);
-                extn = nullptr;
-            }
+        if (!inserted)
+        {
+            replacedFrames++;
 
-            if (extn != nullptr)
+            auto& frame   = it->second;
+            frame.data    = data;
+            frame.options = options;
+            frame.generation++;
+
+            // A delta only applies on top of the one it replaces, so both give way to a snapshot
+            if (isDeltaChannel(channel) and !frame.awaitingSnapshot)
             {
-                delete extn;
+                frame.awaitingSnapshot = true;
+                requestSnapshot(client, it->first, frame.generation);
             }
         }
+    }
 
-        {
-            // AJAX
-            std::string name = "ajax";
-            Extension*  extn = Extension::LoadInternal(name, ajax_load, ajax_destroy, config.lock(), this);
+    flushClient(client);
+}
 
-            if (!extn)
+void Server::requestSnapshot(PerSocketData* client, const std::string& channel, uint64_t generation)
+{
+    // Crafting takes the extension lock, which the server thread must not wait for
+    RunOnPool([=, this] {
+        RunOnServer([=, this, snapshot = craftDeltaSnapshot(channel)]() mutable {
+            if (!connectedClients.contains(client))
             {
-                SPDLOG_WARN("Failed to load extension {}", name);
+                return;
             }
-            else if (extensions.count(extn->GetName()))
+
+            auto it = client->latest.find(channel);
+
+            if (it == client->latest.end() or !it->second.awaitingSnapshot)
             {
-                SPDLOG_WARN("Extension with code {} already loaded. Unloading {}", extn->GetName(), name);
+                return;
             }
-            else
-            {
-                try
-                {
-                    extn->Initialize();
-                } catch (std::exception e)
-                {
-                    SPDLOG_WARN("Exception: {} while initializing {}", e.what(), name);
-                    delete extn;
-                    extn = nullptr;
-                }
 
-                SPDLOG_INFO("Extension {} loaded.", extn->GetName());
-                extensions[extn->GetName()].reset(extn);
-                extn = nullptr;
+            // A later delta may not be part of this snapshot
+            if (it->second.generation != generation)
+            {
+                requestSnapshot(client, channel, it->second.generation);
+                return;
             }
 
-            if (extn != nullptr)
+            if (!snapshot.empty())
             {
-                delete extn;
+                it->second.data = std::move(snapshot);
             }
-        }
 
-        // Load Extension libraries
-        for (QFileInfo& file : list)
-        {
-            auto libpath = (file.path() + "/" + file.fileName()).toStdString();
+            it->second.awaitingSnapshot = false;
 
-            SPDLOG_INFO("Loading data extension {}", libpath);
+            flushClient(client);
+        });
+    });
+}
 
-            Extension* extn = Extension::Load(libpath, config.lock(), this);
+void Server::flushClient(PerSocketData* client)
+{
+    while (!client->reliable.empty() and isWritable(client))
+    {
+        auto& frame = client->reliable.front();
+        writeFrame(client, frame.data, frame.options);
+        client->reliable.pop_front();
+    }
 
-            if (!extn)
-            {
-                SPDLOG_WARN("Failed to load extension {}", libpath);
-            }
-            else if (extensions.count(extn->GetName()))
-            {
-                SPDLOG_WARN("Extension with code {} already loaded. Unloading {}", extn->GetName(), libpath);
-            }
-            else
-            {
-                try
-                {
-                    extn->Initialize();
-                } catch (std::exception e)
-                {
-                    SPDLOG_WARN("Exception: {} while initializing {}", e.what(), libpath);
-                    delete extn;
-                    extn = nullptr;
-                    continue;
-                }
+    // Backlogged clients only take the latest frames once they have caught up
+    if (!client->reliable.empty() or client->backlogged)
+    {
+        return;
+    }
 
-                SPDLOG_INFO("Extension {} loaded.", extn->GetName());
-                extensions[extn->GetName()].reset(extn);
-                extn = nullptr;
-            }
+    while (isWritable(client))
+    {
+        auto next = client->latest.end();
 
-            if (extn != nullptr)
+        // Highest priority first, skipping deltas that wait for a snapshot
+        for (auto it = client->latest.begin(); it != client->latest.end(); ++it)
+        {
+            if (!it->second.awaitingSnapshot and (next == client->latest.end() or it->second.options.priority > next->second.options.priority))
             {
-                delete extn;
+                next = it;
             }
         }
 
-        SPDLOG_INFO("Extensions loaded!");
+        if (next == client->latest.end())
+        {
+            break;
+        }
+
+        writeFrame(client, next->second.data, next->second.options);
+        client->latest.erase(next);
+    }
+
+    // Caught up, back to the shared publish
+    if (client->live.empty() and keepsUp(client))
+    {
+        updateLive(client);
     }
 }
 
-void Server::handleMethodSubscribe(PerSocketData* client, const ClientMessage& msg)
+void Server::updateLive(PerSocketData* client)
 {
-    if (Settings::internal.auth.GetValue() and !client->authenticated)
+    if (client->deliver)
     {
-        SEND_CLIENT_ERROR(client, "Unauthenticated client");
         return;
     }
 
-    auto& parms = msg.params;
+    const bool keeping = keepsUp(client);
 
-    if (!parms.topics)
+    for (auto&& [channel, clients] : channelClients)
     {
-        SEND_CLIENT_ERROR(client, "Invalid parameters for method 'subscribe'");
-        return;
+        if (clients.contains(client))
+        {
+            setLive(client, channel, keeping and !isPaused(client, channel));
+        }
     }
+}
 
-    if (parms.topics.value().empty())
+void Server::syncLive(PerSocketData* client, const std::string& channel)
+{
+    if (keepsUp(client))
+    {
+        setLive(client, channel, !isPaused(client, channel));
+    }
+    else if (!client->live.empty())
+    {
+        updateLive(client);
+    }
+}
+
+void Server::setLive(PerSocketData* client, const std::string& channel, bool live)
+{
+    if (client->deliver or live == client->live.contains(channel))
+    {
+        return;
+    }
+
+    auto socket = static_cast<UWSSocket*>(client->socket);
+
+    if (live)
+    {
+        socket->subscribe(liveTopic(channel));
+        client->live.insert(channel);
+    }
+    else
+    {
+        socket->unsubscribe(liveTopic(channel));
+        client->live.erase(channel);
+    }
+}
+
+std::string Server::craftDeltaSnapshot(std::string_view channel)
+{
+    if (!isDeltaChannel(channel))
+    {
+        return {};
+    }
+
+    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+    auto                                entry = topicIndex.Find(channel);
+
+    if (!entry or entry->mode == DELTA_NONE)
+    {
+        return {};
+    }
+
+    return entry->extension->CraftDeltaSnapshot(entry->topic);
+}
+
+void Server::UpdateSettings()
+{
+    RunOnServer([=, this] {
+        std::lock_guard<std::shared_mutex> lk(extensionMutex);
+        for (auto&& [name, ext] : extensions)
+        {
+            ext->UpdateExtensionSettings();
+            ext->WriteDataSourceSettings();
+            ext->WriteExtensionSettings();
+        }
+    });
+}
+
+std::string Server::GenerateAuthCode(const std::string& owner)
+{
+    // Without authentication, codes are only needed to identify widgets
+    if (!Settings::internal.auth.GetValue() and owner.empty())
+    {
+        return std::string{"dummycode"};
+    }
+
+    quint64 h   = QRandomGenerator::global()->generate64();
+    quint64 l   = QRandomGenerator::global()->generate64();
+    QString hv  = QString::number(h, 16).toUpper() + QString::number(l, 16).toUpper();
+
+    auto    str = hv.toStdString();
+
+    {
+        std::lock_guard<std::mutex> lk(authMutex);
+        authcodes.insert_or_assign(str, owner);
+    }
+
+    return str;
+}
+
+size_t Server::TrimCaches()
+{
+    size_t trimmed = 0;
+
+    {
+        std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+        for (auto&& [name, extn] : extensions)
+        {
+            trimmed += extn->TrimCaches();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(framePoolMutex);
+
+        framePool.clear();
+        framePool.shrink_to_fit();
+    }
+
+    return trimmed;
+}
+
+std::shared_ptr<PerSocketData> Server::ConnectLocalClient(const std::string& owner, std::function<void(const std::string&)>&& deliver, std::function<bool()>&& writable)
+{
+    auto client           = std::make_shared<PerSocketData>();
+    client->authenticated = true;
+    client->deliver       = std::move(deliver);
+    client->writable      = std::move(writable);
+
+    RunOnServer([=, this] {
+        localClients.emplace(client.get(), client);
+        connectedClients.insert(client.get());
+
+        client->owner = owner;
+        setClientHidden(client.get(), hiddenWidgets.contains(owner));
+
+        SPDLOG_INFO("Local client \"{}\" connected", owner);
+    });
+
+    return client;
+}
+
+void Server::ReceiveFromLocalClient(const std::shared_ptr<PerSocketData>& client, std::string_view msg)
+{
+    auto frame    = acquireFrame();
+    frame->client = client.get();
+    frame->data.assign(msg);
+
+    // Hold the client until its message is processed
+    RunOnPool([frame, client, this] {
+        this->processMessage(frame->client, frame->data);
+        this->releaseFrame(frame);
+    });
+}
+
+void Server::FlushLocalClient(const std::shared_ptr<PerSocketData>& client)
+{
+    RunOnServer([=, this] {
+        if (connectedClients.contains(client.get()))
+        {
+            flushClient(client.get());
+        }
+    });
+}
+
+void Server::DisconnectLocalClient(const std::shared_ptr<PerSocketData>& client)
+{
+    RunOnServer([=, this] {
+        if (!connectedClients.contains(client.get()))
+        {
+            return;
+        }
+
+        std::vector<std::string> channels;
+
+        for (auto&& [channel, clients] : channelClients)
+        {
+            if (clients.contains(client.get()))
+            {
+                channels.push_back(channel);
+            }
+        }
+
+        // Same order as WebSocket clients: close first, then leave every channel
+        processClose(client.get());
+
+        for (auto&& channel : channels)
+        {
+            const int count = static_cast<int>(channelClients[channel].size());
+            processSubscription(client.get(), channel, count, count + 1);
+        }
+
+        localClients.erase(client.get());
+
+        SPDLOG_INFO("Local client \"{}\" disconnected", client->owner);
+    });
+}
+
+void Server::SetWidgetVisible(const std::string& owner, bool visible)
+{
+    RunOnServer([=, this] {
+        if (visible)
+        {
+            hiddenWidgets.erase(owner);
+        }
+        else
+        {
+            hiddenWidgets.insert(owner);
+        }
+
+        for (auto&& client : connectedClients)
+        {
+            if (client->owner == owner)
+            {
+                setClientHidden(client, !visible);
+            }
+        }
+    });
+}
+
+SharedMirror& Server::GetSharedMirror()
+{
+    std::lock_guard lk(sharedMirrorMutex);
+
+    if (!sharedMirror)
+    {
+        sharedMirror = std::make_unique<SharedMirror>(QCoreApplication::applicationName().toStdString());
+    }
+
+    return *sharedMirror;
+}
+
+TimeSeriesStore& Server::GetTimeSeriesStore()
+{
+    std::lock_guard lk(timeSeriesMutex);
+
+    if (!timeSeries)
+    {
+        timeSeries = std::make_unique<TimeSeriesStore>(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/timeseries");
+    }
+
+    return *timeSeries;
+}
+
+Extension* Server::FindTopicOwner(std::string_view topic) const
+{
+    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+    auto                                entry = topicIndex.Find(topic);
+
+    return entry ? entry->extension : nullptr;
+}
+
+void Server::setClientHidden(PerSocketData* client, bool hidden)
+{
+    if (client->hidden == hidden)
+    {
+        return;
+    }
+
+    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+    std::vector<std::string>            provided;
+
+    for (auto&& [channel, clients] : channelClients)
+    {
+        // Explicitly paused channels are unaffected
+        if (!clients.contains(client) or client->paused.contains(channel))
+        {
+            continue;
+        }
+
+        auto entry = topicIndex.Find(channel);
+
+        if (entry)
+        {
+            entry->extension->SetSubscriberPaused(channel, hidden);
+        }
+        else if (findProvider(channel))
+        {
+            provided.push_back(channel);
+        }
+    }
+
+    client->hidden = hidden;
+
+    updateLive(client);
+
+    for (auto&& topic : provided)
+    {
+        findProvider(topic)->SetSubscribers(topic, activeClients(topic));
+    }
+}
+
+int Server::activeClients(const std::string& channel) const
+{
+    auto it = channelClients.find(channel);
+
+    if (it == channelClients.end())
+    {
+        return 0;
+    }
+
+    return static_cast<int>(std::ranges::count_if(it->second, [&](const PerSocketData* client) {
+        return !isPaused(client, channel);
+    }));
+}
+
+void Server::loadExtensions()
+{
+    const auto libTypes = QStringList() << "*.dll"
+                                        << "*.so"
+                                        << "*.dylib";
+    auto          path = QUtil::GetCommonAppDataPath() + "extensions/";
+
+    QDir          dir(path);
+    QFileInfoList list = dir.entryInfoList(libTypes, QDir::Files);
+
+    // Also check executable path
+    auto extdir = QDir(QCoreApplication::applicationDirPath() + "/extensions/");
+    list.append(extdir.entryInfoList(libTypes, QDir::Files));
+
+    if (list.count() == 0)
+    {
+        SPDLOG_INFO("No data extensions found");
+        return;
+    }
+
+    // just lock the whole thing while initializing extensions at startup
+    // to prevent out of order reads
+    {
+        std::lock_guard<std::shared_mutex> lk(extensionMutex);
+
+        // First load internal extensions
+        addExtension(Extension::LoadInternal("applauncher", applauncher_load, applauncher_destroy, config.lock(), this), "applauncher");
+        addExtension(Extension::LoadInternal("ajax", ajax_load, ajax_destroy, config.lock(), this), "ajax");
+        addExtension(Extension::LoadInternal("metrics", metrics_load, metrics_destroy, config.lock(), this), "metrics");
+
+        // Load Extension libraries
+        for (QFileInfo& file : list)
+        {
+            auto libpath = (file.path() + "/" + file.fileName()).toStdString();
+
+            SPDLOG_INFO("Loading data extension {}", libpath);
+
+            addExtension(Extension::Load(libpath, config.lock(), this), libpath);
+        }
+
+        for (auto&& [name, extn] : extensions)
+        {
+            indexExtension(extn.get());
+        }
+
+        SPDLOG_INFO("Extensions loaded!");
+    }
+}
+
+void Server::addExtension(Extension* extn, const std::string& name)
+{
+    std::unique_ptr<Extension> owned{extn};
+
+    if (!owned)
+    {
+        SPDLOG_WARN("Failed to load extension {}", name);
+        return;
+    }
+
+    const auto code = owned->GetName();
+
+    if (extensions.count(code))
+    {
+        SPDLOG_WARN("Extension with code {} already loaded. Unloading {}", code, name);
+        return;
+    }
+
+    try
+    {
+        owned->Initialize();
+    } catch (const std::exception& e)
+    {
+        SPDLOG_WARN("Exception: {} while initializing {}", e.what(), name);
+        return;
+    }
+
+    SPDLOG_INFO("Extension {} loaded.", code);
+    extensions[code] = std::move(owned);
+}
+
+void Server::indexExtension(Extension* extn)
+{
+    for (auto&& topic : extn->GetTopics())
+    {
+        topicIndex.Add(extn, topic);
+        RegisterTopic(topic);
+    }
+}
+
+void Server::RegisterTopic(std::string_view topic)
+{
+    // Wildcards only change on the server thread, so none is missed while the topic is indexed
+    RunOnServer([this, topic = std::string{topic}]() {
+        {
+            std::lock_guard<std::shared_mutex> lk(extensionMutex);
+
+            if (!topicIndex.Find(topic))
+            {
+                topicIndex.AddProvided(topic);
+            }
+        }
+
+        std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+        for (auto&& wildcard : wildcards)
+        {
+            if (TopicIndex::Matches(wildcard.pattern, topic))
+            {
+                subscribeClient(wildcard.client, topic, wildcard.mode, false);
+            }
+        }
+    });
+}
+
+void Server::followPattern(const std::string& pattern)
+{
+    auto provider = findProvider(pattern);
+
+    if (!provider)
+    {
+        return;
+    }
+
+    const auto count = std::ranges::count_if(wildcards, [&](const WildcardSubscription& wildcard) {
+        return wildcard.pattern == pattern;
+    });
+
+    provider->SetSubscribers(pattern, static_cast<int>(count));
+}
+
+void Server::subscribeClient(PerSocketData* client, std::string_view topic, DeltaMode mode, bool reportErrors, uint32_t backfill)
+{
+    if (findProvider(topic))
+    {
+        // Provided messages are published as they are
+        if (mode != DELTA_NONE)
+        {
+            if (reportErrors)
+            {
+                SEND_CLIENT_ERROR(client, "Topic '{}' cannot be delta encoded", topic);
+            }
+            return;
+        }
+    }
+    else
+    {
+        auto entry = topicIndex.Find(topic);
+
+        if (!entry or entry->mode != DELTA_NONE)
+        {
+            if (reportErrors)
+            {
+                SEND_CLIENT_ERROR(client, "Nonexistent topic '{}'", topic);
+            }
+            return;
+        }
+
+        if (!entry->extension->TopicAcceptsSubscribers(topic))
+        {
+            if (reportErrors)
+            {
+                SEND_CLIENT_ERROR(client, "Topic '{}' does not accept subscribers", topic);
+            }
+            return;
+        }
+    }
+
+    // The request's views do not outlive this call
+    RunOnServer([=, this, channel = std::string{topic}.append(DeltaChannelSuffix(mode))]() {
+        if (!connectedClients.contains(client))
+        {
+            return;
+        }
+
+        if (backfill and mode == DELTA_NONE)
+        {
+            sendHistory(client, channel, backfill);
+        }
+
+        auto res = subscribeChannel(client, channel);
+
+        if (res)
+        {
+            SPDLOG_INFO("Widget subscribed to topic {}", channel);
+        }
+        else if (reportErrors)
+        {
+            SEND_CLIENT_ERROR(client, "Failed to subscribed to topic {}", channel);
+        }
+    });
+}
+
+void Server::sendHistory(PerSocketData* client, const std::string& topic, uint32_t count)
+{
+    std::string history{};
+    bool        compress = false;
+
+    {
+        std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+        auto                                entry = topicIndex.Find(topic);
+
+        if (!entry)
+        {
+            return;
+        }
+
+        history  = entry->extension->CraftHistory(topic, count);
+        compress = entry->extension->CompressesTopic(topic, history.size());
+    }
+
+    // Queued as a reliable frame, ahead of the live updates of the subscription
+    if (!history.empty())
+    {
+        deliverToClient(client, {}, history, {.compress = compress});
+    }
+}
+
+bool Server::subscribeChannel(PerSocketData* client, const std::string& channel)
+{
+    if (!client->deliver)
+    {
+        // Triggers processSubscription, which updates the subscriber counts
+        const bool res = static_cast<UWSSocket*>(client->socket)->subscribe(channel);
+
+        syncLive(client, channel);
+
+        return res;
+    }
+
+    auto& clients = channelClients[channel];
+
+    if (!clients.contains(client))
+    {
+        const int count = static_cast<int>(clients.size());
+        processSubscription(client, channel, count + 1, count);
+    }
+
+    return true;
+}
+
+bool Server::unsubscribeChannel(PerSocketData* client, const std::string& channel)
+{
+    if (!client->deliver)
+    {
+        setLive(client, channel, false);
+
+        return static_cast<UWSSocket*>(client->socket)->unsubscribe(channel);
+    }
+
+    auto it = channelClients.find(channel);
+
+    if (it == channelClients.end() or !it->second.contains(client))
+    {
+        return false;
+    }
+
+    const int count = static_cast<int>(it->second.size());
+    processSubscription(client, channel, count - 1, count);
+
+    return true;
+}
+
+void Server::unsubscribeClient(PerSocketData* client, std::string_view topic)
+{
+    RunOnServer([=, this, topic = std::string{topic}]() {
+        if (!connectedClients.contains(client))
+        {
+            return;
+        }
+
+        // Leave every delta channel of the topic the client is on
+        for (auto&& mode : {DELTA_NONE, DELTA_MERGE, DELTA_PATCH})
+        {
+            auto channel = topic + std::string{DeltaChannelSuffix(mode)};
+            auto it      = channelClients.find(channel);
+
+            if (it == channelClients.end() or !it->second.contains(client))
+            {
+                continue;
+            }
+
+            if (unsubscribeChannel(client, channel))
+            {
+                SPDLOG_INFO("Widget unsubscribed from topic {}", channel);
+            }
+        }
+    });
+}
+
+void Server::pauseClient(PerSocketData* client, const ClientRequest& msg, bool paused)
+{
+    const auto method = paused ? "pause" : "resume";
+
+    if (Settings::internal.auth.GetValue() and !client->authenticated)
+    {
+        SEND_CLIENT_ERROR(client, "Unauthenticated client");
+        return;
+    }
+
+    if (!msg.topics or msg.topics.value().empty())
+    {
+        SEND_CLIENT_ERROR(client, "Invalid parameters for method '{}'", method);
+        return;
+    }
+
+    std::vector<std::pair<Extension*, std::string>> targets;
+
+    {
+        std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+        for (auto&& topic : msg.topics.value())
+        {
+            if (TopicIndex::IsPattern(topic))
+            {
+                if (!TopicIndex::IsValidPattern(topic))
+                {
+                    SEND_CLIENT_ERROR(client, "Invalid wildcard topic '{}'", topic);
+                    continue;
+                }
+
+                // Provided topics have no extension
+                for (auto&& match : topicIndex.Match(topic))
+                {
+                    auto entry = topicIndex.Find(match);
+                    targets.emplace_back(entry ? entry->extension : nullptr, match);
+                }
+
+                continue;
+            }
+
+            if (findProvider(topic))
+            {
+                targets.emplace_back(nullptr, topic);
+                continue;
+            }
+
+            auto entry = topicIndex.Find(topic);
+
+            if (!entry or entry->mode != DELTA_NONE)
+            {
+                SEND_CLIENT_ERROR(client, "Nonexistent topic '{}'", topic);
+                continue;
+            }
+
+            targets.emplace_back(entry->extension, topic);
+        }
+    }
+
+    if (targets.empty())
+    {
+        return;
+    }
+
+    // Subscriptions only change on the server thread
+    RunOnServer([=, this, targets = std::move(targets)]() {
+        if (!connectedClients.contains(client))
+        {
+            return;
+        }
+
+        std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+        for (auto&& [extn, topic] : targets)
+        {
+            for (auto&& mode : {DELTA_NONE, DELTA_MERGE, DELTA_PATCH})
+            {
+                auto channel = topic + std::string{DeltaChannelSuffix(mode)};
+                auto it      = channelClients.find(channel);
+
+                if (it == channelClients.end() or !it->second.contains(client))
+                {
+                    continue;
+                }
+
+                bool wasPaused = isPaused(client, channel);
+
+                if (paused)
+                {
+                    client->paused.insert(channel);
+                }
+                else
+                {
+                    client->paused.erase(channel);
+                }
+
+                syncLive(client, channel);
+
+                if (isPaused(client, channel) == wasPaused)
+                {
+                    continue;
+                }
+
+                if (extn)
+                {
+                    extn->SetSubscriberPaused(channel, paused);
+                }
+                else if (auto provider = findProvider(channel))
+                {
+                    // Providers only follow topics that have subscribers that are not paused
+                    provider->SetSubscribers(channel, activeClients(channel));
+
+                    // Like a new subscriber, a resumed one gets the latest message straight away
+                    if (!paused)
+                    {
+                        if (auto last = provider->LastMessage(channel); !last.empty())
+                        {
+                            SendDataToClient(client, std::move(last));
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+void Server::handleMethodSubscribe(PerSocketData* client, const ClientRequest& msg)
+{
+    if (Settings::internal.auth.GetValue() and !client->authenticated)
+    {
+        SEND_CLIENT_ERROR(client, "Unauthenticated client");
+        return;
+    }
+
+    if (!msg.topics)
+    {
+        SEND_CLIENT_ERROR(client, "Invalid parameters for method 'subscribe'");
+        return;
+    }
+
+    if (msg.topics.value().empty())
     {
         SEND_CLIENT_ERROR(client, "Invalid topics for method 'subscribe'");
         return;
     }
 
-    auto&                               topics = parms.topics.value();
+    DeltaMode mode = DELTA_NONE;
+
+    if (msg.delta)
+    {
+        mode = ParseDeltaMode(msg.delta.value());
+
+        if (mode == DELTA_NONE)
+        {
+            SEND_CLIENT_ERROR(client, "Invalid delta mode '{}' for method 'subscribe'", msg.delta.value());
+            return;
+        }
+    }
+
+    auto&                               topics = msg.topics.value();
+
+    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+    for (auto&& topic : topics)
+    {
+        if (!TopicIndex::IsPattern(topic))
+        {
+            subscribeClient(client, topic, mode, true, msg.backfill.value_or(0));
+            continue;
+        }
+
+        if (!TopicIndex::IsValidPattern(topic))
+        {
+            SEND_CLIENT_ERROR(client, "Invalid wildcard topic '{}'", topic);
+            continue;
+        }
+
+        // Follow topics matching the pattern as they appear, unless the client already does
+        RunOnServer([=, this, pattern = std::string{topic}]() {
+            const bool following = std::ranges::any_of(wildcards, [&](const WildcardSubscription& wildcard) {
+                return wildcard.client == client and wildcard.pattern == pattern and wildcard.mode == mode;
+            });
+
+            if (!connectedClients.contains(client) or following)
+            {
+                return;
+            }
+
+            wildcards.push_back({client, pattern, mode});
+            followPattern(pattern);
+
+            std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+            // Polled sources matched by a wildcard are skipped silently
+            for (auto&& match : topicIndex.Match(pattern))
+            {
+                subscribeClient(client, match, mode, false);
+            }
+        });
+    }
+}
+
+void Server::handleMethodUnsubscribe(PerSocketData* client, const ClientRequest& msg)
+{
+    if (Settings::internal.auth.GetValue() and !client->authenticated)
+    {
+        SEND_CLIENT_ERROR(client, "Unauthenticated client");
+        return;
+    }
+
+    if (!msg.topics or msg.topics.value().empty())
+    {
+        SEND_CLIENT_ERROR(client, "Invalid parameters for method 'unsubscribe'");
+        return;
+    }
+
+    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+    for (auto&& topic : msg.topics.value())
+    {
+        if (!TopicIndex::IsPattern(topic))
+        {
+            auto entry = topicIndex.Find(topic);
+
+            if ((!entry or entry->mode != DELTA_NONE) and !findProvider(topic))
+            {
+                SEND_CLIENT_ERROR(client, "Nonexistent topic '{}'", topic);
+                continue;
+            }
+
+            unsubscribeClient(client, topic);
+            continue;
+        }
+
+        if (!TopicIndex::IsValidPattern(topic))
+        {
+            SEND_CLIENT_ERROR(client, "Invalid wildcard topic '{}'", topic);
+            continue;
+        }
+
+        // Stop following new topics matching the pattern
+        RunOnServer([=, this, pattern = std::string{topic}]() {
+            const auto removed = std::erase_if(wildcards, [&](const WildcardSubscription& wildcard) {
+                return wildcard.client == client and wildcard.pattern == pattern;
+            });
+
+            if (removed)
+            {
+                followPattern(pattern);
+            }
+        });
+
+        for (auto&& match : topicIndex.Match(topic))
+        {
+            unsubscribeClient(client, match);
+        }
+    }
+}
+
+void Server::handleMethodPause(PerSocketData* client, const ClientRequest& msg)
+{
+    pauseClient(client, msg, true);
+}
+
+void Server::handleMethodResume(PerSocketData* client, const ClientRequest& msg)
+{
+    pauseClient(client, msg, false);
+}
+
+void Server::handleMethodBackpressure(PerSocketData* client, const ClientRequest& msg)
+{
+    if (Settings::internal.auth.GetValue() and !client->authenticated)
+    {
+        SEND_CLIENT_ERROR(client, "Unauthenticated client");
+        return;
+    }
+
+    if (!msg.args or (msg.args.value() != "on" and msg.args.value() != "off"))
+    {
+        SEND_CLIENT_ERROR(client, "Invalid parameters for method 'backpressure'");
+        return;
+    }
+
+    const bool backlogged = (msg.args.value() == "on");
+
+    RunOnServer([=, this] {
+        if (!connectedClients.contains(client) or client->backlogged == backlogged)
+        {
+            return;
+        }
+
+        client->backlogged = backlogged;
+
+        SPDLOG_DEBUG("Widget \"{}\" {} backpressure", client->owner, backlogged ? "applied" : "released");
+
+        if (backlogged)
+        {
+            updateLive(client);
+        }
+        else
+        {
+            flushClient(client);
+        }
+    });
+}
+
+void Server::handleMethodQuery(PerSocketData* client, const ClientRequest& msg)
+{
+    if (Settings::internal.auth.GetValue() and !client->authenticated)
+    {
+        SEND_CLIENT_ERROR(client, "Unauthenticated client");
+        return;
+    }
+
+    if (!msg.topics)
+    {
+        SEND_CLIENT_ERROR(client, "Invalid parameters for method 'query'");
+        return;
+    }
+
+    if (msg.topics.value().empty())
+    {
+        SEND_CLIENT_ERROR(client, "Invalid topics for method 'query'");
+        return;
+    }
+
+    auto&                               topics = msg.topics.value();
+    const char*                         args   = msg.args ? msg.args.value().data() : nullptr;
 
     std::shared_lock<std::shared_mutex> lk(extensionMutex);
 
+    jsoncons::json                      j{jsoncons::json_object_arg, {{"errors", jsoncons::json{jsoncons::json_array_arg}}}};
+    std::string                         message{};
+
     for (auto&& topic : topics)
     {
-        auto target = topic.substr(0, topic.find_first_of("/"));
+        const auto errors = j["errors"].size();
+        bool       later  = false;
 
-        if (!extensions.count(target))
+        if (auto provider = findProvider(topic))
         {
-            SEND_CLIENT_ERROR(client, "Unknown extension '{}' in topic {}", target, topic);
-            continue;
+            // Provided messages are already keyed by their topic
+            if (auto last = provider->LastMessage(topic); !last.empty())
+            {
+                j.merge_or_update(jsoncons::json::parse(last));
+            }
         }
-
-        auto extn = extensions.at(target).get();
-
-        if (!extn->TopicExists(topic))
+        else if (auto entry = topicIndex.Find(topic); entry and entry->mode == DELTA_NONE)
         {
-            SEND_CLIENT_ERROR(client, "Nonexistent topic '{}'", topic);
+            later = entry->extension->PollDataForSending(j, {&topic, 1}, args, client);
+        }
+        else
+        {
+            auto m = fmt::format("Unknown topic {}", topic);
+            j["errors"].push_back(m);
+
+            SPDLOG_WARN(m);
             continue;
         }
 
-        if (!extn->TopicAcceptsSubscribers(topic))
+        // Every queried topic is answered, if only with an error
+        if (!later and !j.contains(topic) and j["errors"].size() == errors)
         {
-            SEND_CLIENT_ERROR(client, "Topic '{}' does not accept subscribers", topic);
-            continue;
+            j["errors"].push_back(noDataError(topic));
         }
+    }
 
-        auto socket = static_cast<UWSSocket*>(client->socket);
+    if (j["errors"].empty())
+    {
+        j.erase("errors");
+    }
 
-        RunOnServer([=, this]() {
-            auto res = socket->subscribe(topic);
+    if (!j.empty())
+    {
+        j.dump(message);
 
-            if (res)
-            {
-                SPDLOG_INFO("Widget subscribed to topic {}", topic);
-            }
-            else
-            {
-                SEND_CLIENT_ERROR(client, "Failed to subscribed to topic {}", topic);
-            }
+        // Compress if any of the queried topics asks for it
+        bool compress = std::ranges::any_of(topics, [&](std::string_view topic) {
+            auto entry = topicIndex.Find(topic);
+            return entry and entry->extension->CompressesTopic(topic, message.size());
         });
+
+        SendDataToClient(client, std::move(message), {.compress = compress});
     }
 }
 
-void Server::handleMethodQuery(PerSocketData* client, const ClientMessage& msg)
+void Server::handleMethodResync(PerSocketData* client, const ClientRequest& msg)
 {
     if (Settings::internal.auth.GetValue() and !client->authenticated)
     {
@@ -440,67 +1694,110 @@ void Server::handleMethodQuery(PerSocketData* client, const ClientMessage& msg)
         return;
     }
 
-    auto& parms = msg.params;
-
-    if (!parms.topics)
+    if (!msg.topics or msg.topics.value().empty())
     {
-        SEND_CLIENT_ERROR(client, "Invalid parameters for method 'query'");
+        SEND_CLIENT_ERROR(client, "Invalid parameters for method 'resync'");
         return;
     }
 
-    if (parms.topics.value().empty())
+    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+    for (auto&& topic : msg.topics.value())
     {
-        SEND_CLIENT_ERROR(client, "Invalid topics for method 'query'");
-        return;
-    }
+        auto entry = topicIndex.Find(topic);
 
-    auto&                                                     topics = parms.topics.value();
-    auto                                                      params = parms.params ? parms.params.value() : std::vector<std::string>{};
-    auto                                                      args   = parms.args ? parms.args.value() : "";
+        if (!entry)
+        {
+            SEND_CLIENT_ERROR(client, "Nonexistent topic '{}'", topic);
+            continue;
+        }
 
-    std::unordered_map<std::string, std::vector<std::string>> extns{};
+        auto snapshot = entry->extension->CraftDeltaSnapshot(entry->topic);
 
-    for (auto&& topic : topics)
-    {
-        auto target = topic.substr(0, topic.find_first_of("/"));
-        extns[target].push_back(topic);
+        if (!snapshot.empty())
+        {
+            SendDataToClient(client, std::move(snapshot));
+        }
     }
+}
 
-    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+void Server::handleMethodHistory(PerSocketData* client, const ClientRequest& msg)
+{
+    using namespace std::chrono;
 
-    jsoncons::json                      j{jsoncons::json_object_arg, {{"errors", jsoncons::json{jsoncons::json_array_arg}}}};
-    std::string                         message{};
+    if (Settings::internal.auth.GetValue() and !client->authenticated)
+    {
+        SEND_CLIENT_ERROR(client, "Unauthenticated client");
+        return;
+    }
 
-    for (auto&& [target, tpcs] : extns)
+    if (!msg.topics or msg.topics.value().empty())
     {
-        if (!extensions.count(target))
-        {
-            SEND_CLIENT_ERROR(client, "Unknown extension {} in topic {}", target, fmt::join(tpcs, ","));
-            continue;
-        }
+        SEND_CLIENT_ERROR(client, "Invalid parameters for method 'history'");
+        return;
+    }
 
-        auto extn = extensions.at(target).get();
+    const int64_t to   = msg.to ? static_cast<int64_t>(std::min<uint64_t>(msg.to.value(), INT64_MAX)) : duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    const int64_t from = msg.from ? static_cast<int64_t>(std::min<uint64_t>(msg.from.value(), INT64_MAX)) : to - duration_cast<milliseconds>(HISTORY_DEFAULT_RANGE).count();
 
-        extn->PollDataForSending(j, tpcs, args, client);
+    if (from > to)
+    {
+        SEND_CLIENT_ERROR(client, "Invalid time range for method 'history'");
+        return;
     }
 
-    if (j["errors"].empty())
+    auto resolution = msg.resolution ? TimeSeriesStore::ParseResolution(msg.resolution.value()) : TimeSeriesStore::PickResolution(from, to, HISTORY_MAX_ROWS);
+
+    if (resolution == TimeSeriesStore::RESOLUTION_MAX)
     {
-        j.erase("errors");
+        SEND_CLIENT_ERROR(client, "Invalid resolution '{}' for method 'history'", msg.resolution.value());
+        return;
     }
 
-    if (!j.empty())
+    for (auto&& topic : msg.topics.value())
     {
-        j.dump(message);
-        SendDataToClient(client, message);
+        {
+            std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+            auto                                entry = topicIndex.Find(topic);
+
+            if (!entry or entry->mode != DELTA_NONE)
+            {
+                SEND_CLIENT_ERROR(client, "Nonexistent topic '{}'", topic);
+                continue;
+            }
+        }
+
+        // Reads segment files, so it is kept out of the extension lock
+        SendDataToClient(client, GetTimeSeriesStore().CraftHistory(topic, from, to, resolution));
     }
 }
 
-void Server::handleMethodAuth(PerSocketData* client, const ClientMessage& msg)
+void Server::handleMethodAuth(PerSocketData* client, const ClientRequest& msg)
 {
+    // In-process clients are authenticated when connecting
+    if (client->deliver)
+    {
+        return;
+    }
+
     if (!Settings::internal.auth.GetValue())
     {
         SPDLOG_INFO("Widget authentication is disabled");
+
+        // Codes still tell which widget the connection belongs to
+        if (msg.code)
+        {
+            std::lock_guard<std::mutex> lk(authMutex);
+
+            auto                        search = authcodes.find(msg.code.value());
+            if (search != authcodes.end())
+            {
+                attachOwner(client, search->second);
+                authcodes.erase(search);
+            }
+        }
+
         return;
     }
 
@@ -510,21 +1807,19 @@ void Server::handleMethodAuth(PerSocketData* client, const ClientMessage& msg)
         return;
     }
 
-    auto& parms = msg.params;
-
-    if (!parms.code)
+    if (!msg.code)
     {
         SEND_CLIENT_ERROR(client, "Invalid parameters for method 'auth'");
         return;
     }
 
-    if (parms.code.value().empty())
+    if (msg.code.value().empty())
     {
         SEND_CLIENT_ERROR(client, "Invalid auth code for method 'auth'");
         return;
     }
 
-    auto&                       code = parms.code.value();
+    auto                        code = msg.code.value();
 
     std::lock_guard<std::mutex> lk(authMutex);
 
@@ -535,22 +1830,251 @@ void Server::handleMethodAuth(PerSocketData* client, const ClientMessage& msg)
         return;
     }
 
+    attachOwner(client, search->second);
     authcodes.erase(search);
 
     client->authenticated = true;
     SPDLOG_INFO("Client authenticated!");
 }
 
-void Server::processMessage(PerSocketData* client, const std::string& msg)
+void Server::attachOwner(PerSocketData* client, const std::string& owner)
 {
-    ClientMessage doc{};
+    if (owner.empty())
+    {
+        return;
+    }
 
-    try
+    RunOnServer([=, this] {
+        if (!connectedClients.contains(client))
+        {
+            return;
+        }
+
+        client->owner = owner;
+        setClientHidden(client, hiddenWidgets.contains(owner));
+    });
+}
+
+void Server::serveTopic(HttpResponse* res, uWS::HttpRequest* req)
+{
+    if (!authorizeRequest(res, req))
+    {
+        return;
+    }
+
+    auto topic = req->getUrl().substr(TOPICS_PATH.size());
+
+    {
+        std::shared_lock<std::shared_mutex> lk(extensionMutex);
+
+        auto                                entry = topicIndex.Find(topic);
+
+        if ((!entry or entry->mode != DELTA_NONE) and !findProvider(topic))
+        {
+            res->writeStatus("404 Not Found")->end(fmt::format("Nonexistent topic '{}'", topic));
+            return;
+        }
+    }
+
+    // Answered like a query, so polled sources use their cached value
+    jsoncons::json params{jsoncons::json_object_arg, {{"topics", jsoncons::json{jsoncons::json_array_arg}}}};
+    params["topics"].push_back(topic);
+
+    if (auto args = req->getQuery("args"))
+    {
+        params["args"] = args.value();
+    }
+
+    std::string request{};
+    jsoncons::json{jsoncons::json_object_arg, {{"method", "query"}, {"params", std::move(params)}}}.dump(request);
+
+    auto stream = std::make_shared<HttpStream>();
+    stream->res = res;
+
+    // The reply to the query ends the response
+    auto client = ConnectLocalClient("HTTP request", [this, stream, topic = std::string{topic}](const std::string& data) {
+        if (stream->done)
+        {
+            return;
+        }
+
+        // Replies without the topic only hold errors
+        std::string_view status = "200 OK";
+        auto             reply  = jsoncons::json::parse(data);
+
+        if (!reply.contains(topic))
+        {
+            const bool nodata = reply.contains("errors") and reply.at("errors").size() == 1 and reply.at("errors")[0].as<std::string>() == noDataError(topic);
+
+            status            = nodata ? "204 No Content" : "500 Internal Server Error";
+        }
+
+        stream->res->cork([&] {
+            if (status.starts_with("204"))
+            {
+                stream->res->writeStatus(status)->writeHeader("Cache-Control", "no-store")->end();
+                return;
+            }
+
+            stream->res->writeStatus(status)->writeHeader("Content-Type", "application/json")->writeHeader("Cache-Control", "no-store")->end(data);
+        });
+
+        closeStream(stream);
+    });
+
+    stream->client = client;
+
+    res->onAborted([this, stream] {
+        closeStream(stream);
+    });
+
+    ReceiveFromLocalClient(client, request);
+}
+
+void Server::serveStream(HttpResponse* res, uWS::HttpRequest* req)
+{
+    if (!authorizeRequest(res, req))
+    {
+        return;
+    }
+
+    jsoncons::json params{jsoncons::json_object_arg, {{"topics", jsoncons::json{jsoncons::json_array_arg}}}};
+
+    for (auto&& part : std::views::split(req->getQuery("topics").value_or(std::string_view{}), ','))
+    {
+        std::string_view topic{part.begin(), part.end()};
+
+        if (!topic.empty())
+        {
+            params["topics"].push_back(topic);
+        }
+    }
+
+    if (params["topics"].empty())
+    {
+        res->writeStatus("400 Bad Request")->end("Missing topics");
+        return;
+    }
+
+    if (auto delta = req->getQuery("delta"))
+    {
+        params["delta"] = delta.value();
+    }
+
+    std::string request{};
+    jsoncons::json{jsoncons::json_object_arg, {{"method", "subscribe"}, {"params", std::move(params)}}}.dump(request);
+
+    auto stream = std::make_shared<HttpStream>();
+    stream->res = res;
+
+    // Sends the headers straight away
+    res->writeHeader("Content-Type", "text/event-stream")->writeHeader("Cache-Control", "no-cache")->write(":\n\n");
+
+    auto deliver = [stream](const std::string& data) {
+        if (stream->done)
+        {
+            return;
+        }
+
+        // Written at once, so every event is a single chunk
+        stream->buffer.assign("data: ").append(data).append("\n\n");
+
+        stream->res->cork([&] {
+            stream->res->write(stream->buffer);
+        });
+    };
+
+    // Congested streams keep the latest frame of each topic, like WebSocket clients
+    auto writable = [stream] {
+        return stream->done or stream->res->getBufferedAmount() < CONGESTION_THRESHOLD;
+    };
+
+    auto client    = ConnectLocalClient("HTTP stream", std::move(deliver), std::move(writable));
+    stream->client = client;
+
+    httpStreams.insert(stream);
+
+    res->onWritable([this, stream](uint64_t) {
+        if (auto client = stream->client.lock())
+        {
+            flushClient(client.get());
+        }
+
+        return true;
+    });
+
+    res->onAborted([this, stream] {
+        closeStream(stream);
+    });
+
+    if (!streamHeartbeat)
+    {
+        streamHeartbeat = std::make_unique<Timer>("stream heartbeat");
+        streamHeartbeat->setInterval(
+            [this] {
+                RunOnServer([this] {
+                    sendHeartbeats();
+                });
+            },
+            std::chrono::duration_cast<std::chrono::microseconds>(STREAM_HEARTBEAT_INTERVAL).count());
+    }
+
+    ReceiveFromLocalClient(client, request);
+}
+
+void Server::closeStream(const std::shared_ptr<HttpStream>& stream)
+{
+    stream->done = true;
+
+    if (auto client = stream->client.lock())
+    {
+        DisconnectLocalClient(client);
+    }
+
+    httpStreams.erase(stream);
+}
+
+void Server::sendHeartbeats()
+{
+    for (auto&& stream : httpStreams)
     {
-        doc = jsoncons::decode_json<ClientMessage>(msg);
-    } catch (std::exception const& je)
+        // Congested streams are already sending
+        if (!stream->done and stream->res->getBufferedAmount() == 0)
+        {
+            stream->res->cork([&] {
+                stream->res->write(":\n\n");
+            });
+        }
+    }
+}
+
+void Server::processMessage(PerSocketData* client, std::string_view msg)
+{
+    using MethodHandler = void (Server::*)(PerSocketData*, const ClientRequest&);
+
+    // Method names are resolved without hashing or allocating
+    static constexpr std::array<std::pair<std::string_view, MethodHandler>, 9> methods{
+        {{"subscribe", &Server::handleMethodSubscribe},
+         {"unsubscribe", &Server::handleMethodUnsubscribe},
+         {"pause", &Server::handleMethodPause},
+         {"resume", &Server::handleMethodResume},
+         {"query", &Server::handleMethodQuery},
+         {"resync", &Server::handleMethodResync},
+         {"history", &Server::handleMethodHistory},
+         {"backpressure", &Server::handleMethodBackpressure},
+         {"auth", &Server::handleMethodAuth}}
+    };
+
+    // Requests are parsed into a per thread arena that is reset for every message
+    alignas(std::max_align_t) thread_local std::array<std::byte, REQUEST_ARENA_SIZE> arenaBuffer;
+
+    std::pmr::monotonic_buffer_resource arena{arenaBuffer.data(), arenaBuffer.size()};
+    ClientRequest                       doc{&arena};
+    std::string_view                    err{};
+
+    if (!RequestParser::Parse(msg, doc, err))
     {
-        SPDLOG_ERROR("Error parsing JSON message: {}", je.what());
+        SPDLOG_ERROR("Error parsing JSON message: {}", err);
         SPDLOG_ERROR("JSON: {}", msg);
         return;
     }
@@ -561,13 +2085,15 @@ void Server::processMessage(PerSocketData* client, const std::string& msg)
         return;
     }
 
-    if (!methods.count(doc.method))
+    auto method = std::ranges::find(methods, doc.method, &std::pair<std::string_view, MethodHandler>::first);
+
+    if (method == methods.end())
     {
         SEND_CLIENT_ERROR(client, "Unknown method type {}", doc.method);
         return;
     }
 
-    methods.at(doc.method)(client, doc);
+    (this->*(method->second))(client, doc);
 }
 
 void Server::sendErrorToClient(PerSocketData* client, const std::string& err)
@@ -578,38 +2104,128 @@ void Server::sendErrorToClient(PerSocketData* client, const std::string& err)
 
     jsoncons::encode_json(msg, json);
 
-    SendDataToClient(client, json);
+    SendDataToClient(client, std::move(json));
 }
 
 void Server::processClose(PerSocketData* client)
 {
-    // Currently nothing
+    connectedClients.erase(client);
+
+    std::unordered_set<std::string> patterns;
+
+    std::erase_if(wildcards, [&](const WildcardSubscription& wildcard) {
+        if (wildcard.client != client)
+        {
+            return false;
+        }
+
+        patterns.insert(wildcard.pattern);
+        return true;
+    });
+
+    for (auto&& pattern : patterns)
+    {
+        followPattern(pattern);
+    }
+
+    for (auto&& [channel, clients] : channelClients)
+    {
+        clients.erase(client);
+    }
+
+    client->reliable.clear();
+    client->latest.clear();
+    client->live.clear();
+    client->backlogged = false;
+
+    // Paused channels are kept until uWS unsubscribes the closed socket from them
+}
+
+TopicProvider* Server::findProvider(std::string_view topic) const
+{
+    if (relay and relay->Provides(topic))
+    {
+        return relay.get();
+    }
+
+    if (replayer and replayer->Provides(topic))
+    {
+        return replayer.get();
+    }
+
+    if (derived and derived->Provides(topic))
+    {
+        return derived.get();
+    }
+
+    return nullptr;
 }
 
 void Server::processSubscription(PerSocketData* client, const std::string& topic, int nSize, int oSize)
 {
+    // Track channel membership for delivery
+    if (nSize > oSize)
+    {
+        channelClients[topic].insert(client);
+    }
+    else if (nSize < oSize)
+    {
+        channelClients[topic].erase(client);
+    }
+
+    // uWS only counts WebSocket subscribers, in-process clients share the channel
+    const int count = static_cast<int>(channelClients[topic].size());
+
+    if (auto provider = findProvider(topic))
+    {
+        provider->SetSubscribers(topic, activeClients(topic));
+
+        if (nSize > oSize)
+        {
+            // Provided topics have no timer to send the current value to new subscribers
+            if (auto last = provider->LastMessage(topic); !last.empty())
+            {
+                SendDataToClient(client, std::move(last));
+            }
+        }
+        else
+        {
+            client->paused.erase(topic);
+        }
+
+        return;
+    }
+
     std::shared_lock<std::shared_mutex> lk(extensionMutex);
 
-    auto                                target = topic.substr(0, topic.find_first_of("/"));
+    auto                                entry = topicIndex.Find(topic);
 
-    if (!extensions.count(target))
+    if (!entry)
     {
-        SEND_CLIENT_ERROR(client, "Unknown extension '{}' in topic {}", target, topic);
+        SEND_CLIENT_ERROR(client, "Nonexistent topic '{}'", topic);
         return;
     }
 
-    auto extn = extensions.at(target).get();
+    auto extn = entry->extension;
 
     if (nSize > oSize)
     {
         // New subscriber
 
-        extn->AddSubscriber(client, topic, nSize);
+        extn->AddSubscriber(client, topic, count);
+
+        if (client->hidden)
+        {
+            extn->SetSubscriberPaused(topic, true);
+        }
     }
     else if (nSize < oSize)
     {
         // Remove subscriber
-        extn->RemoveSubscriber(client, topic, nSize);
+        const bool wasPaused = isPaused(client, topic);
+
+        client->paused.erase(topic);
+        extn->RemoveSubscriber(client, topic, count, wasPaused);
     }
     else
     {
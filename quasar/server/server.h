@@ -1,29 +1,131 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "protocol.h"
+#include "topicindex.h"
+
+#include "common/mpscqueue.h"
+#include "common/settings.h"
+#include "common/timer.h"
+#include "common/util.h"
 
 #include <BS_thread_pool.hpp>
 
 class Extension;
 class Config;
+class DerivedTopics;
+class LocalSocketServer;
+class Relay;
+class SharedMirror;
+class TimeSeriesStore;
+class TopicBus;
+class TopicProvider;
+class TopicRecorder;
+class TopicReplayer;
+struct HttpStream;
+
+namespace uWS
+{
+    template <bool SSL>
+    struct HttpResponse;
+    struct HttpRequest;
+}  // namespace uWS
+
+//! Delivery options of an outgoing message
+struct SendOptions
+{
+    bool compress = false;                                //!< Compress with permessage-deflate
+    int  priority = Settings::Priority::normal_priority;  //!< Flush order while a client is congested \sa Settings::Priority
+    bool reliable = true;                                 //!< Never dropped or replaced while a client is congested
+};
+
+//! A message waiting for a congested client to drain
+struct PendingFrame
+{
+    std::string data;
+    SendOptions options;
+    uint64_t    generation       = 0;      //!< Times the frame was replaced, to match snapshots prepared off the server thread
+    bool        awaitingSnapshot = false;  //!< Held back until a delta snapshot replaces it
+};
+
+//! Command handed off to the server thread
+struct ServerCommand
+{
+    enum Type : uint8_t
+    {
+        SEND,     //!< Send data to a single client
+        PUBLISH,  //!< Publish data to all subscribers of a channel
+        TASK      //!< Run a task on the server thread
+    };
+
+    Type                  type = TASK;
+    PerSocketData*        client{};
+    std::string           channel{};
+    std::string           data{};
+    SendOptions           options{};
+    std::function<void()> task{};
+};
+
+//! Hand-off batch statistics
+struct ServerCommandStats
+{
+    std::atomic<uint64_t> batches{};   //!< Number of batches drained by the server thread
+    std::atomic<uint64_t> commands{};  //!< Number of commands drained
+    std::atomic<uint64_t> maxBatch{};  //!< Largest batch drained
+};
+
+//! A received frame waiting to be processed on the thread pool
+struct InboundFrame
+{
+    PerSocketData* client{};
+    std::string    data{};
+};
+
+//! A wildcard subscription that follows topics as they appear \sa TopicIndex
+struct WildcardSubscription
+{
+    PerSocketData* client{};
+    std::string    pattern{};
+    DeltaMode      mode{};
+};
 
 struct PerSocketData
 {
-    void* socket        = nullptr;
-    bool  authenticated = false;
+    void*                                         socket        = nullptr;
+    bool                                          authenticated = false;
+
+    //! In-process transport invoked on the server thread, empty for WebSocket clients \sa Server::ConnectLocalClient()
+    std::function<void(const std::string&)>       deliver{};
+
+    //! Whether an in-process transport can take more data, empty if it is never congested
+    std::function<bool()>                         writable{};
+
+    // Outbound queues, only accessed from the server thread
+    std::deque<PendingFrame>                      reliable{};          //!< Messages delivered in order
+    std::unordered_map<std::string, PendingFrame> latest{};            //!< Latest undelivered frame of each channel
+    std::unordered_set<std::string>               paused{};            //!< Subscribed channels that are paused
+    std::unordered_set<std::string>               live{};              //!< Channels received through the shared uWS publish while the client keeps up
+    bool                                          backlogged = false;  //!< The client holds its latest frames until it catches up
+
+    // Owning widget, only accessed from the server thread
+    std::string                                   owner{};         //!< Name of the widget the connection belongs to
+    bool                                          hidden = false;  //!< The owning widget cannot currently be seen
 };
 
 class Server : public std::enable_shared_from_this<Server>
 {
-    using ExtensionsMapType = std::unordered_map<std::string, std::unique_ptr<Extension>>;
-    using MethodFuncType    = std::function<void(PerSocketData*, const ClientMessage&)>;
-    using MethodCallMapType = std::unordered_map<std::string, MethodFuncType>;
+    using ExtensionsMapType = std::unordered_map<std::string, std::unique_ptr<Extension>, Util::StringHash, std::equal_to<>>;
 
 public:
     Server(const Server&)             = delete;
@@ -34,40 +136,184 @@ public:
 
     bool        FindExtension(const std::string& extcode);
 
-    void        SendDataToClient(PerSocketData* client, const std::string& msg);
+    //! Queues a message for a client, rvalues are moved to the server thread without a copy
+    void        SendDataToClient(PerSocketData* client, std::string msg, SendOptions options = {});
 
-    void        PublishData(std::string_view topic, const std::string& data);
+    void        PublishData(std::string_view topic, const std::string& data, SendOptions options = {});
 
-    void        RunOnServer(auto&& cb);
+    //! Whether permessage-deflate was enabled when the server started \sa Settings::Compressor
+    bool        CompressionEnabled() const { return compressor != Settings::Compressor::no_compressor; }
+
+    void        RunOnServer(std::function<void()>&& cb);
 
     void        RunOnPool(auto&& cb) { pool.push_task(cb); }
 
     void        UpdateSettings();
 
-    std::string GenerateAuthCode();
+    std::string GenerateAuthCode(const std::string& owner = {});
+
+    //! Connects an in-process client, such as a widget's QWebChannel bridge or a local socket client
+    /*! The client is authenticated as \p owner and speaks the same protocol as WebSocket
+        clients, without going through any socket.
+        \param[in]  owner       Widget name the client belongs to, or a description of the local client
+        \param[in]  deliver     Receives every message for the client, invoked on the server thread
+        \param[in]  writable    Whether the transport can take more data, invoked on the server thread. Leave empty if it is never congested.
+        \return Client handle, kept alive by the caller until DisconnectLocalClient()
+    */
+    std::shared_ptr<PerSocketData> ConnectLocalClient(const std::string& owner, std::function<void(const std::string&)>&& deliver, std::function<bool()>&& writable = {});
+
+    //! Processes a message sent by an in-process client \sa ConnectLocalClient()
+    void                           ReceiveFromLocalClient(const std::shared_ptr<PerSocketData>& client, std::string_view msg);
+
+    //! Disconnects an in-process client, ending all its subscriptions \sa ConnectLocalClient()
+    void                           DisconnectLocalClient(const std::shared_ptr<PerSocketData>& client);
+
+    //! Sends the frames queued for a congested in-process client, once its transport is writable again
+    void                           FlushLocalClient(const std::shared_ptr<PerSocketData>& client);
+
+    //! Releases cached Data Source values and recycled buffers to relieve memory pressure
+    //! \return Number of cached values released
+    size_t      TrimCaches();
+
+    //! Pauses or resumes every subscription of a widget's connections
+    /*! Subscriptions of hidden widgets do not keep their Data Sources running.
+        \param[in]  owner       Widget name the connections were authenticated with \sa GenerateAuthCode()
+        \param[in]  visible     Whether the widget can currently be seen
+    */
+    void        SetWidgetVisible(const std::string& owner, bool visible);
+
+    //! Shared memory region that Data Sources are mirrored to, created on first use
+    SharedMirror&    GetSharedMirror();
+
+    //! Store that Data Sources are archived to, created on first use
+    TimeSeriesStore& GetTimeSeriesStore();
+
+    //! In-process subscriptions of extensions to each other's topics
+    TopicBus&        GetTopicBus() { return *topicBus; }
+
+    //! Extension publishing a topic
+    //! \return Extension, or nullptr if no extension publishes the topic
+    Extension*       FindTopicOwner(std::string_view topic) const;
+
+    //! Follows wildcard subscriptions onto a topic that appeared after they were made
+    //! Invoked by extensions and topic providers as they start publishing a topic, from any thread
+    void             RegisterTopic(std::string_view topic);
 
 private:
     void loadExtensions();
 
+    //! Initializes a loaded extension and takes ownership of it, unloading it on failure
+    //! \param[in]  extn    Loaded extension, or nullptr if loading failed
+    //! \param[in]  name    Library path or internal name, for logging
+    void addExtension(Extension* extn, const std::string& name);
+    void indexExtension(Extension* extn);
+    void subscribeClient(PerSocketData* client, std::string_view topic, DeltaMode mode, bool reportErrors, uint32_t backfill = 0);
+    void unsubscribeClient(PerSocketData* client, std::string_view topic);
+    bool subscribeChannel(PerSocketData* client, const std::string& channel);
+    bool unsubscribeChannel(PerSocketData* client, const std::string& channel);
+
+    //! Sends the history of a topic to a new subscriber, server thread only \sa Extension::CraftHistory()
+    void sendHistory(PerSocketData* client, const std::string& topic, uint32_t count);
+
+    //! Keeps the provider of a wildcard pattern, such as a relay upstream, subscribed while clients follow it
+    void followPattern(const std::string& pattern);
+
+    void pauseClient(PerSocketData* client, const ClientRequest& msg, bool paused);
+    void setClientHidden(PerSocketData* client, bool hidden);
+
+    //! Number of subscribers of a channel that are not paused, server thread only
+    int  activeClients(const std::string& channel) const;
+    void attachOwner(PerSocketData* client, const std::string& owner);
+
+    // HTTP endpoints (server thread only)
+    void serveTopic(uWS::HttpResponse<false>* res, uWS::HttpRequest* req);
+    void serveStream(uWS::HttpResponse<false>* res, uWS::HttpRequest* req);
+    void closeStream(const std::shared_ptr<HttpStream>& stream);
+    void sendHeartbeats();
+
     // Method handling
-    void         handleMethodSubscribe(PerSocketData* client, const ClientMessage& msg);
-    void         handleMethodQuery(PerSocketData* client, const ClientMessage& msg);
-    void         handleMethodAuth(PerSocketData* client, const ClientMessage& msg);
+    void         handleMethodSubscribe(PerSocketData* client, const ClientRequest& msg);
+    void         handleMethodUnsubscribe(PerSocketData* client, const ClientRequest& msg);
+    void         handleMethodPause(PerSocketData* client, const ClientRequest& msg);
+    void         handleMethodResume(PerSocketData* client, const ClientRequest& msg);
+    void         handleMethodQuery(PerSocketData* client, const ClientRequest& msg);
+    void         handleMethodResync(PerSocketData* client, const ClientRequest& msg);
+    void         handleMethodHistory(PerSocketData* client, const ClientRequest& msg);
+    void         handleMethodBackpressure(PerSocketData* client, const ClientRequest& msg);
+    void         handleMethodAuth(PerSocketData* client, const ClientRequest& msg);
 
-    void         processMessage(PerSocketData* client, const std::string& msg);
+    void         processMessage(PerSocketData* client, std::string_view msg);
     void         sendErrorToClient(PerSocketData* client, const std::string& err);
     void         processClose(PerSocketData* client);
     void         processSubscription(PerSocketData* client, const std::string& topic, int nSize, int oSize);
 
+    //! Relay, replay or derived topics that publish a topic instead of an extension
+    //! \return Provider of the topic, or nullptr if it is not provided
+    TopicProvider* findProvider(std::string_view topic) const;
+
+    // Recycled buffers of received frames
+    InboundFrame* acquireFrame();
+    void          releaseFrame(InboundFrame* frame);
+
+    // Server thread hand-off
+    void         queueCommand(ServerCommand&& cmd);
+    void         drainCommands();
+
+    // Outbound delivery (server thread only)
+    void         deliverToClient(PerSocketData* client, std::string_view channel, const std::string& data, const SendOptions& options);
+    void         flushClient(PerSocketData* client);
+
+    //! Joins or leaves the shared publish of each channel of a WebSocket client, as it keeps up, falls behind, pauses or resumes
+    void         updateLive(PerSocketData* client);
+    void         syncLive(PerSocketData* client, const std::string& channel);
+    void         setLive(PerSocketData* client, const std::string& channel, bool live);
+
+    //! Replaces a superseded delta with a snapshot crafted on the thread pool
+    void         requestSnapshot(PerSocketData* client, const std::string& channel, uint64_t generation);
+    std::string  craftDeltaSnapshot(std::string_view channel);
+
     std::jthread websocketServer;
 
-    // Method function map
-    const MethodCallMapType   methods;
+    std::unique_ptr<LocalSocketServer> localSocket{};      //!< Optional listener for local non-browser clients
+    std::unique_ptr<Timer>             streamHeartbeat{};  //!< Keeps idle Server-Sent Events streams open
+    std::unique_ptr<Relay>             relay{};            //!< Optional relay of upstream Quasar instances' topics
+    std::unique_ptr<TopicReplayer>     replayer{};         //!< Replays a topic log in place of extensions \sa Settings::launch
+    std::unique_ptr<TopicRecorder>     recorder{};         //!< Records published messages to a topic log, server thread only
+    std::unique_ptr<DerivedTopics>     derived{};          //!< Optional windowed aggregates of Data Sources, tapping extensions
+
+    std::unique_ptr<SharedMirror>      sharedMirror{};  //!< Outlives extensions, which hold slots of it
+    std::mutex                         sharedMirrorMutex;
+
+    std::unique_ptr<TimeSeriesStore>   timeSeries{};  //!< Outlives extensions, which record to it
+    std::mutex                         timeSeriesMutex;
+
+    std::unique_ptr<TopicBus>          topicBus{};  //!< Outlives extensions, which subscribe through it
 
     ExtensionsMapType         extensions;
+    TopicIndex                topicIndex;  //!< Index of all topics, guarded by extensionMutex
     mutable std::shared_mutex extensionMutex;
 
     std::weak_ptr<Config>     config{};
 
+    const int                 compressor;
+
+    std::vector<std::unique_ptr<InboundFrame>> framePool;
+    std::mutex                                 framePoolMutex;
+
+    // Commands waiting for the server thread
+    MPSCQueue<ServerCommand> commands;
+    std::atomic<bool>        drainScheduled{};
+    ServerCommandStats       commandStats{};
+
+    // Server thread only
+    std::unordered_set<PerSocketData*>                                  connectedClients;
+    std::unordered_map<std::string, std::unordered_set<PerSocketData*>> channelClients;  //!< Subscribers of each channel
+    std::unordered_set<std::string>                                     hiddenWidgets;   //!< Widgets that cannot currently be seen
+    std::unordered_map<PerSocketData*, std::shared_ptr<PerSocketData>>  localClients;    //!< Connected in-process clients
+    std::unordered_set<std::shared_ptr<HttpStream>>                     httpStreams;     //!< Open Server-Sent Events streams
+    std::vector<WildcardSubscription>                                   wildcards;       //!< Patterns followed by clients, each at most once
+
+    std::atomic<uint64_t>     replacedFrames{};  //!< Stale frames replaced while clients were congested
+
     BS::thread_pool           pool;
 };
@@ -0,0 +1,310 @@
+#include "sharedmirror.h"
+
+#include "api/quasar_shm.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#ifndef _WIN32
+#  include <sys/file.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    constexpr size_t PAYLOAD_CAPACITY = SharedMirror::SLOT_SIZE - QUASAR_SHM_SLOT_HEADER;
+
+    static_assert(sizeof(quasar_shm_header_t) <= QUASAR_SHM_HEADER_SIZE);
+    static_assert(sizeof(quasar_shm_slot_t) <= QUASAR_SHM_SLOT_HEADER);
+
+    //! Whether data is an array of numbers that can be written as doubles
+    bool isNumericArray(const jsoncons::json& data)
+    {
+        if (!data.is_array() or data.empty())
+        {
+            return false;
+        }
+
+        for (auto&& value : data.array_range())
+        {
+            if (!value.is_number())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}  // namespace
+
+SharedMirror::SharedMirror(const std::string& appName)
+{
+    char buf[128];
+    quasar_shm_name(buf, sizeof(buf), appName.c_str());
+
+    name = buf;
+    size = QUASAR_SHM_HEADER_SIZE + static_cast<size_t>(SLOT_COUNT) * SLOT_SIZE;
+
+    void* base = nullptr;
+
+#ifdef _WIN32
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size), name.c_str());
+
+    if (!mapping)
+    {
+        SPDLOG_ERROR("Failed to create shared memory {}: error {}", name, GetLastError());
+        return;
+    }
+
+    const bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+
+    base               = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+
+    if (!base)
+    {
+        SPDLOG_ERROR("Failed to map shared memory {}: error {}", name, GetLastError());
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return;
+    }
+
+    // The mapping of a previous instance survives while readers keep it open, and is
+    // only reused once its owner has exited
+    if (existed)
+    {
+        const auto owner = static_cast<quasar_shm_header_t*>(base)->owner_pid;
+        HANDLE     proc  = owner ? OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, owner) : nullptr;
+        DWORD      code  = 0;
+        const bool alive = proc and GetExitCodeProcess(proc, &code) and code == STILL_ACTIVE;
+
+        if (proc)
+        {
+            CloseHandle(proc);
+        }
+
+        if (alive and owner != GetCurrentProcessId())
+        {
+            SPDLOG_ERROR("Shared memory {} is in use by process {}, topics are not mirrored", name, owner);
+            UnmapViewOfFile(base);
+            CloseHandle(mapping);
+            mapping = nullptr;
+            return;
+        }
+    }
+#else
+    fd = shm_open(name.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+
+    if (fd < 0)
+    {
+        SPDLOG_ERROR("Failed to create shared memory {}: {}", name, std::strerror(errno));
+        return;
+    }
+
+    // The lock is held for as long as the region is written, and released by the kernel
+    // if this instance exits, so only the region of an exited instance is reused
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        SPDLOG_ERROR("Shared memory {} is in use by another instance, topics are not mirrored", name);
+        close(fd);
+        fd = -1;
+        return;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        SPDLOG_ERROR("Failed to size shared memory {}: {}", name, std::strerror(errno));
+        close(fd);
+        fd = -1;
+        shm_unlink(name.c_str());
+        return;
+    }
+
+    base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (base == MAP_FAILED)
+    {
+        SPDLOG_ERROR("Failed to map shared memory {}: {}", name, std::strerror(errno));
+        close(fd);
+        fd = -1;
+        shm_unlink(name.c_str());
+        return;
+    }
+#endif
+
+    header = static_cast<quasar_shm_header_t*>(base);
+
+    // The region of an exited instance may still be open in readers, which see it as
+    // uninitialized until it is laid out again
+    std::atomic_ref magic{header->magic};
+
+    if (magic.load(std::memory_order_acquire) == QUASAR_SHM_MAGIC)
+    {
+        magic.store(0, std::memory_order_release);
+
+        std::atomic_ref{header->slots_used}.store(0, std::memory_order_release);
+
+        // Readers holding a slot see its sequence number change, and never a torn slot
+        auto slots = reinterpret_cast<char*>(header) + QUASAR_SHM_HEADER_SIZE;
+
+        for (uint32_t i = 0; i < SLOT_COUNT; i++)
+        {
+            assign(reinterpret_cast<quasar_shm_slot_t*>(slots + static_cast<size_t>(i) * SLOT_SIZE), {});
+        }
+    }
+
+    // Publish the layout before the magic number
+    header->version    = QUASAR_SHM_VERSION;
+    header->slot_count = SLOT_COUNT;
+    header->slot_size  = SLOT_SIZE;
+#ifdef _WIN32
+    header->owner_pid  = GetCurrentProcessId();
+#else
+    header->owner_pid  = static_cast<uint32_t>(getpid());
+#endif
+
+    magic.store(QUASAR_SHM_MAGIC, std::memory_order_release);
+
+    SPDLOG_INFO("Mirroring topics to shared memory {}", name);
+}
+
+SharedMirror::~SharedMirror()
+{
+    if (!header)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(header);
+    CloseHandle(mapping);
+#else
+    munmap(header, size);
+    shm_unlink(name.c_str());
+    close(fd);
+#endif
+}
+
+quasar_shm_slot_t* SharedMirror::Attach(std::string_view topic)
+{
+    if (!header)
+    {
+        return nullptr;
+    }
+
+    if (topic.size() >= QUASAR_SHM_TOPIC_SIZE)
+    {
+        SPDLOG_WARN("Topic {} is too long to be mirrored to shared memory", topic);
+        return nullptr;
+    }
+
+    std::lock_guard lk(mutex);
+
+    auto       base  = reinterpret_cast<char*>(header) + QUASAR_SHM_HEADER_SIZE;
+    const auto count = header->slots_used;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        auto slot = reinterpret_cast<quasar_shm_slot_t*>(base + static_cast<size_t>(i) * SLOT_SIZE);
+
+        if (topic == slot->topic)
+        {
+            return slot;
+        }
+    }
+
+    if (count >= SLOT_COUNT)
+    {
+        SPDLOG_WARN("Cannot mirror {}, all {} shared memory slots are in use", topic, SLOT_COUNT);
+        return nullptr;
+    }
+
+    auto slot = reinterpret_cast<quasar_shm_slot_t*>(base + static_cast<size_t>(count) * SLOT_SIZE);
+    assign(slot, topic);
+
+    // Readers only look at slots counted in slots_used
+    std::atomic_ref{header->slots_used}.store(count + 1, std::memory_order_release);
+
+    return slot;
+}
+
+void SharedMirror::Detach(quasar_shm_slot_t* slot)
+{
+    write(slot, QUASAR_SHM_EMPTY, nullptr, 0);
+}
+
+void SharedMirror::Publish(quasar_shm_slot_t* slot, const jsoncons::json& data)
+{
+    thread_local std::string         text;
+    thread_local std::vector<double> numbers;
+
+    if (isNumericArray(data))
+    {
+        numbers.clear();
+
+        for (auto&& value : data.array_range())
+        {
+            numbers.push_back(value.as<double>());
+        }
+
+        write(slot, QUASAR_SHM_F64, numbers.data(), numbers.size() * sizeof(double));
+        return;
+    }
+
+    text.clear();
+    data.dump(text);
+
+    write(slot, QUASAR_SHM_JSON, text.data(), text.size());
+}
+
+void SharedMirror::write(quasar_shm_slot_t* slot, uint32_t format, const void* data, size_t length)
+{
+    if (length > PAYLOAD_CAPACITY)
+    {
+        if (slot->format != QUASAR_SHM_OVERSIZE)
+        {
+            SPDLOG_WARN("Payload of {} ({} bytes) does not fit in its shared memory slot", slot->topic, length);
+        }
+
+        format = QUASAR_SHM_OVERSIZE;
+        length = 0;
+    }
+
+    std::atomic_ref seq{slot->seq};
+    const auto      start = seq.load(std::memory_order_relaxed);
+
+    // Odd while writing, readers retry until it is even and unchanged
+    seq.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    slot->format    = format;
+    slot->length    = static_cast<uint32_t>(length);
+
+    if (length)
+    {
+        std::memcpy(reinterpret_cast<char*>(slot) + QUASAR_SHM_SLOT_HEADER, data, length);
+    }
+
+    seq.store(start + 2, std::memory_order_release);
+}
+
+void SharedMirror::assign(quasar_shm_slot_t* slot, std::string_view topic)
+{
+    std::atomic_ref seq{slot->seq};
+    const auto      start = seq.load(std::memory_order_relaxed);
+
+    seq.store(start | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(slot->topic, topic.data(), topic.size());
+    slot->topic[topic.size()] = '\0';
+    slot->timestamp           = 0;
+    slot->format              = QUASAR_SHM_EMPTY;
+    slot->length              = 0;
+
+    // Even again, and past any value the previous instance may have left
+    seq.store((start | 1) + 1, std::memory_order_release);
+}
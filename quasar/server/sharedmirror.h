@@ -0,0 +1,68 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include <jsoncons/json.hpp>
+
+struct quasar_shm_header_t;
+struct quasar_shm_slot_t;
+
+//! Shared memory region mirroring the latest payload of selected topics
+/*! Every mirrored topic is assigned a seqlock protected slot, so local readers can poll
+    it without involving the server. The layout and the reader are defined in the
+    extension API \sa quasar_shm.h
+
+    Uses POSIX shared memory on Linux and a named file mapping on Windows. A region
+    still written by a running instance is never taken over.
+*/
+class SharedMirror
+{
+public:
+    //! Number of topics that can be mirrored
+    static constexpr uint32_t SLOT_COUNT = 64;
+
+    //! Size of each slot, including its header
+    static constexpr uint32_t SLOT_SIZE  = 64 * 1024;
+
+    SharedMirror(const SharedMirror&)             = delete;
+    SharedMirror& operator= (const SharedMirror&) = delete;
+
+    //! \param[in]  appName     Application name of this instance \sa quasar_shm_name()
+    explicit SharedMirror(const std::string& appName);
+    ~SharedMirror();
+
+    //! Whether the region could be created
+    bool               IsOpen() const { return header != nullptr; }
+
+    //! Returns the slot of a topic, assigning one if needed
+    //! \return Slot, or nullptr if the region is not open or full
+    quasar_shm_slot_t* Attach(std::string_view topic);
+
+    //! Marks a slot as no longer updated
+    static void        Detach(quasar_shm_slot_t* slot);
+
+    //! Writes the latest data of a topic to its slot
+    /*! Arrays of numbers are written as doubles, anything else as JSON.
+        Only one thread may write a given slot at a time.
+    */
+    static void        Publish(quasar_shm_slot_t* slot, const jsoncons::json& data);
+
+private:
+    //! Writes a payload under the slot's sequence lock
+    static void write(quasar_shm_slot_t* slot, uint32_t format, const void* data, size_t size);
+
+    //! Empties a slot and gives it a topic under the slot's sequence lock, which keeps counting up
+    static void assign(quasar_shm_slot_t* slot, std::string_view topic);
+
+    quasar_shm_header_t* header = nullptr;
+    size_t               size   = 0;
+    std::string          name;
+    std::mutex           mutex;  //!< Guards slot assignment
+#ifdef _WIN32
+    void* mapping = nullptr;
+#else
+    int   fd      = -1;  //!< Kept open and locked while the region is owned
+#endif
+};
@@ -0,0 +1,531 @@
+#include "timeseries.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+
+#include <QDir>
+
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    using Resolution                                                 = TimeSeriesStore::Resolution;
+
+    // Per resolution properties
+    constexpr std::array<std::string_view, Resolution::RESOLUTION_MAX> RESOLUTION_NAMES{"1s", "1m", "1h"};
+    constexpr std::array<int64_t, Resolution::RESOLUTION_MAX>          RESOLUTION_MS{1000, 60 * 1000, 60 * 60 * 1000};
+    constexpr std::array<uint32_t, Resolution::RESOLUTION_MAX>         SEGMENT_ROWS{3600, 1440, 720};  //!< An hour, a day and a month of rows
+    constexpr std::array<int64_t, Resolution::RESOLUTION_MAX>          RETENTION_MS{
+        int64_t{24} * 60 * 60 * 1000,        // 1 day
+        int64_t{30} * 24 * 60 * 60 * 1000,   // 30 days
+        int64_t{730} * 24 * 60 * 60 * 1000,  // 2 years
+    };
+
+    // Completed 1 second buckets are written this often
+    constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(250);
+
+    int64_t        nowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    //! Start of the bucket of a resolution that contains a time
+    int64_t bucketStart(int64_t time, Resolution resolution)
+    {
+        return time - (time % RESOLUTION_MS[resolution]);
+    }
+
+    //! Start time encoded in a segment file name, such as 1m-1760000000000.seg
+    int64_t segmentStart(const QString& fileName)
+    {
+        return fileName.section('-', 1).section('.', 0, 0).toLongLong();
+    }
+
+    //! Name of a resolution's segment files, or of one of them if \p start is given
+    QString segmentName(Resolution resolution, const std::string& start = "*")
+    {
+        return QString::fromStdString(fmt::format("{}-{}.seg", RESOLUTION_NAMES[resolution], start));
+    }
+
+    //! Column of \p capacity values following the time column
+    double* column(TimeSeriesSegmentHeader* header, size_t index)
+    {
+        auto base = reinterpret_cast<char*>(header) + TIME_SERIES_HEADER_SIZE + header->capacity * sizeof(int64_t);
+        return reinterpret_cast<double*>(base) + index * header->capacity;
+    }
+
+    const double* column(const TimeSeriesSegmentHeader* header, size_t index)
+    {
+        return column(const_cast<TimeSeriesSegmentHeader*>(header), index);
+    }
+
+    //! Appends the rows of a segment within a time range to a timeseries message
+    void readRows(const TimeSeriesSegmentHeader* header, int64_t from, int64_t to, jsoncons::json& times, jsoncons::json& fields)
+    {
+        const auto  rows  = std::atomic_ref{const_cast<TimeSeriesSegmentHeader*>(header)->rows}.load(std::memory_order_acquire);
+        auto        time  = reinterpret_cast<const int64_t*>(reinterpret_cast<const char*>(header) + TIME_SERIES_HEADER_SIZE);
+
+        const auto* first = std::lower_bound(time, time + rows, from);
+        const auto* last  = std::upper_bound(first, time + rows, to);
+
+        if (first == last)
+        {
+            return;
+        }
+
+        const size_t offset = times.size();
+
+        for (auto* t = first; t != last; t++)
+        {
+            times.push_back(*t);
+        }
+
+        auto value = [](double v) {
+            return std::isnan(v) ? jsoncons::json::null() : jsoncons::json{v};
+        };
+
+        for (uint32_t i = 0; i < header->fieldCount; i++)
+        {
+            auto  name  = std::string{header->fields[i], strnlen(header->fields[i], TimeSeriesSegmentHeader::FIELD_NAME_SIZE)};
+            auto& field = fields[name];
+
+            if (field.is_null())
+            {
+                field = jsoncons::json{
+                    jsoncons::json_object_arg,
+                    {{"min", jsoncons::json{jsoncons::json_array_arg}},
+                      {"max", jsoncons::json{jsoncons::json_array_arg}},
+                      {"avg", jsoncons::json{jsoncons::json_array_arg}}}
+                };
+            }
+
+            // Fields missing from earlier segments are null
+            for (auto&& key : {"min", "max", "avg"})
+            {
+                while (field[key].size() < offset)
+                {
+                    field[key].push_back(jsoncons::json::null());
+                }
+            }
+
+            const auto* mins = column(header, i * 3);
+            const auto* maxs = column(header, i * 3 + 1);
+            const auto* avgs = column(header, i * 3 + 2);
+
+            for (auto row = static_cast<size_t>(first - time); row < static_cast<size_t>(last - time); row++)
+            {
+                field["min"].push_back(value(mins[row]));
+                field["max"].push_back(value(maxs[row]));
+                field["avg"].push_back(value(avgs[row]));
+            }
+        }
+    }
+}  // namespace
+
+TimeSeriesStore::TimeSeriesStore(const QString& dir) :
+    root{dir}
+{
+    QDir().mkpath(root);
+
+    thread = std::jthread{[this](std::stop_token token) {
+        run(token);
+    }};
+
+    SPDLOG_INFO("Storing time series in {}", root.toStdString());
+}
+
+TimeSeriesStore::~TimeSeriesStore()
+{
+    // Writes the remaining samples and partial buckets before segments are closed
+    thread.request_stop();
+    thread.join();
+}
+
+void TimeSeriesStore::Record(const std::string& topic, const jsoncons::json& data)
+{
+    Sample sample{.topic = topic, .time = nowMs(), .values = {}};
+
+    auto   add = [&](std::string&& name, const jsoncons::json& value) {
+        if (value.is_number() and name.size() < TimeSeriesSegmentHeader::FIELD_NAME_SIZE and sample.values.size() < TimeSeriesSegmentHeader::MAX_FIELDS)
+        {
+            sample.values.emplace_back(std::move(name), value.as<double>());
+        }
+    };
+
+    if (data.is_number())
+    {
+        add("value", data);
+    }
+    else if (data.is_object())
+    {
+        for (auto&& member : data.object_range())
+        {
+            add(std::string{member.key()}, member.value());
+        }
+    }
+    else if (data.is_array())
+    {
+        size_t i = 0;
+
+        for (auto&& value : data.array_range())
+        {
+            add(std::to_string(i++), value);
+        }
+    }
+
+    if (!sample.values.empty())
+    {
+        queue.push(std::move(sample));
+    }
+}
+
+std::string TimeSeriesStore::CraftHistory(std::string_view topic, int64_t from, int64_t to, Resolution resolution)
+{
+    jsoncons::json times{jsoncons::json_array_arg};
+    jsoncons::json fields{jsoncons::json_object_arg};
+
+    {
+        std::lock_guard lk(mutex);
+
+        const auto      files = QDir{topicDir(topic)}.entryList({segmentName(resolution)}, QDir::Files, QDir::Name);
+
+        const Segment*  open  = nullptr;
+
+        if (auto it = series.find(topic); it != series.end())
+        {
+            open = it->second.segments[resolution].get();
+        }
+
+        for (qsizetype i = 0; i < files.size(); i++)
+        {
+            // A segment ends where the next one starts
+            const auto start = segmentStart(files[i]);
+            const auto end   = i + 1 < files.size() ? segmentStart(files[i + 1]) : std::numeric_limits<int64_t>::max();
+
+            if (end <= from or start > to)
+            {
+                continue;
+            }
+
+            const auto path = topicDir(topic) + "/" + files[i];
+
+            if (open and open->file.fileName() == path)
+            {
+                readRows(open->header, from, to, times, fields);
+                continue;
+            }
+
+            QFile file{path};
+
+            if (!file.open(QIODevice::ReadOnly) or file.size() < static_cast<qint64>(TIME_SERIES_HEADER_SIZE))
+            {
+                continue;
+            }
+
+            auto header = reinterpret_cast<const TimeSeriesSegmentHeader*>(file.map(0, file.size()));
+
+            if (!header or std::memcmp(header->magic, TIME_SERIES_MAGIC, sizeof(header->magic)) != 0 or header->version != TIME_SERIES_VERSION
+                or static_cast<qint64>(TIME_SERIES_HEADER_SIZE + header->capacity * sizeof(int64_t) * (1 + size_t{header->fieldCount} * 3)) > file.size())
+            {
+                SPDLOG_WARN("Skipping invalid time series segment {}", path.toStdString());
+                continue;
+            }
+
+            readRows(header, from, to, times, fields);
+        }
+    }
+
+    // Pads fields missing from the last segments
+    for (auto&& member : fields.object_range())
+    {
+        for (auto&& key : {"min", "max", "avg"})
+        {
+            while (member.value()[key].size() < times.size())
+            {
+                member.value()[key].push_back(jsoncons::json::null());
+            }
+        }
+    }
+
+    std::string    message{};
+
+    jsoncons::json j{
+        jsoncons::json_object_arg,
+        {{"timeseries",
+            jsoncons::json{
+                jsoncons::json_object_arg,
+                {{"topic", topic},
+                  {"resolution", RESOLUTION_NAMES[resolution]},
+                  {"from", from},
+                  {"to", to},
+                  {"time", std::move(times)},
+                  {"fields", std::move(fields)}}
+            }}}
+    };
+
+    j.dump(message);
+
+    return message;
+}
+
+TimeSeriesStore::Resolution TimeSeriesStore::ParseResolution(std::string_view name)
+{
+    auto it = std::ranges::find(RESOLUTION_NAMES, name);
+    return static_cast<Resolution>(std::distance(RESOLUTION_NAMES.begin(), it));
+}
+
+TimeSeriesStore::Resolution TimeSeriesStore::PickResolution(int64_t from, int64_t to, int64_t maxRows)
+{
+    for (auto resolution : {RESOLUTION_1S, RESOLUTION_1M})
+    {
+        if ((to - from) / RESOLUTION_MS[resolution] <= maxRows)
+        {
+            return resolution;
+        }
+    }
+
+    return RESOLUTION_1H;
+}
+
+void TimeSeriesStore::run(std::stop_token token)
+{
+    std::mutex                  waitMutex;
+    std::condition_variable_any waitCv;
+
+    while (!token.stop_requested())
+    {
+        {
+            std::unique_lock lk(waitMutex);
+            waitCv.wait_for(lk, token, FLUSH_INTERVAL, [] {
+                return false;
+            });
+        }
+
+        drain(nowMs(), false);
+    }
+
+    drain(nowMs(), true);
+}
+
+void TimeSeriesStore::drain(int64_t now, bool all)
+{
+    std::lock_guard lk(mutex);
+
+    while (auto sample = queue.pop())
+    {
+        aggregate(*sample);
+    }
+
+    for (auto&& [topic, entry] : series)
+    {
+        for (auto resolution : {RESOLUTION_1S, RESOLUTION_1M, RESOLUTION_1H})
+        {
+            const auto& bucket = entry.buckets[resolution];
+
+            if (bucket.start >= 0 and (all or bucket.start + RESOLUTION_MS[resolution] <= now))
+            {
+                closeBucket(topic, entry, resolution);
+            }
+        }
+    }
+}
+
+void TimeSeriesStore::aggregate(const Sample& sample)
+{
+    auto it = series.find(sample.topic);
+
+    if (it == series.end())
+    {
+        it = series.try_emplace(sample.topic).first;
+    }
+
+    auto& entry    = it->second;
+    bool  expanded = false;
+
+    Bucket single{.start = sample.time, .fields = {}};
+    single.fields.resize(entry.fields.size(), {.min = 0, .max = 0, .sum = 0, .count = 0});
+
+    for (auto&& [name, value] : sample.values)
+    {
+        auto [field, inserted] = entry.index.try_emplace(name, entry.fields.size());
+
+        if (inserted)
+        {
+            if (entry.fields.size() >= TimeSeriesSegmentHeader::MAX_FIELDS)
+            {
+                entry.index.erase(field);
+                continue;
+            }
+
+            entry.fields.push_back(name);
+            single.fields.push_back({.min = 0, .max = 0, .sum = 0, .count = 0});
+            expanded = true;
+        }
+
+        single.fields[field->second] = {.min = value, .max = value, .sum = value, .count = 1};
+    }
+
+    if (expanded)
+    {
+        // Segments have a fixed set of fields, new fields start new segments
+        for (auto&& segment : entry.segments)
+        {
+            segment.reset();
+        }
+    }
+
+    fold(sample.topic, entry, RESOLUTION_1S, single);
+}
+
+void TimeSeriesStore::fold(const std::string& topic, Series& entry, Resolution resolution, const Bucket& bucket)
+{
+    auto&      target = entry.buckets[resolution];
+    const auto start  = bucketStart(bucket.start, resolution);
+
+    // Late samples are added to the current bucket instead
+    if (target.start >= 0 and start > target.start)
+    {
+        closeBucket(topic, entry, resolution);
+    }
+
+    if (target.start < 0)
+    {
+        target.start = start;
+    }
+
+    target.fields.resize(entry.fields.size(), {.min = 0, .max = 0, .sum = 0, .count = 0});
+
+    for (size_t i = 0; i < bucket.fields.size(); i++)
+    {
+        const auto& src = bucket.fields[i];
+        auto&       dst = target.fields[i];
+
+        if (src.count == 0)
+        {
+            continue;
+        }
+
+        dst.min    = dst.count ? std::min(dst.min, src.min) : src.min;
+        dst.max    = dst.count ? std::max(dst.max, src.max) : src.max;
+        dst.sum   += src.sum;
+        dst.count += src.count;
+    }
+}
+
+void TimeSeriesStore::closeBucket(const std::string& topic, Series& entry, Resolution resolution)
+{
+    // Moved out first, as folding may close the buckets of the next resolutions
+    auto bucket = std::move(entry.buckets[resolution]);
+    entry.buckets[resolution] = {};
+
+    append(topic, entry, resolution, bucket);
+
+    if (resolution + 1 < RESOLUTION_MAX)
+    {
+        fold(topic, entry, static_cast<Resolution>(resolution + 1), bucket);
+    }
+}
+
+void TimeSeriesStore::append(const std::string& topic, Series& entry, Resolution resolution, const Bucket& bucket)
+{
+    auto& segment = entry.segments[resolution];
+
+    if ((!segment or segment->header->rows >= segment->header->capacity) and !openSegment(topic, entry, resolution, bucket.start))
+    {
+        return;
+    }
+
+    auto       header   = segment->header;
+    const auto row      = header->rows;
+    auto       time     = reinterpret_cast<int64_t*>(reinterpret_cast<char*>(header) + TIME_SERIES_HEADER_SIZE);
+
+    time[row]           = bucket.start;
+
+    for (size_t i = 0; i < header->fieldCount; i++)
+    {
+        const bool has = i < bucket.fields.size() and bucket.fields[i].count > 0;
+        const auto nan = std::numeric_limits<double>::quiet_NaN();
+
+        column(header, i * 3)[row]     = has ? bucket.fields[i].min : nan;
+        column(header, i * 3 + 1)[row] = has ? bucket.fields[i].max : nan;
+        column(header, i * 3 + 2)[row] = has ? bucket.fields[i].sum / bucket.fields[i].count : nan;
+    }
+
+    // Readers in other processes only look at complete rows
+    std::atomic_ref{header->rows}.store(row + 1, std::memory_order_release);
+}
+
+bool TimeSeriesStore::openSegment(const std::string& topic, Series& entry, Resolution resolution, int64_t start)
+{
+    auto&      current = entry.segments[resolution];
+    const auto dir     = topicDir(topic);
+
+    current.reset();
+
+    QDir().mkpath(dir);
+    prune(dir, resolution, start);
+
+    const uint32_t capacity = SEGMENT_ROWS[resolution];
+    const auto     size     = static_cast<qint64>(TIME_SERIES_HEADER_SIZE + capacity * sizeof(int64_t) * (1 + entry.fields.size() * 3));
+
+    auto           segment  = std::make_unique<Segment>();
+
+    // Segments of a previous run may start with the same bucket
+    do
+    {
+        segment->file.setFileName(dir + "/" + segmentName(resolution, std::to_string(start++)));
+    } while (segment->file.exists());
+
+    uchar* map = nullptr;
+
+    if (!segment->file.open(QIODevice::ReadWrite | QIODevice::Truncate) or !segment->file.resize(size) or !(map = segment->file.map(0, size)))
+    {
+        SPDLOG_ERROR("Failed to create time series segment {}: {}", segment->file.fileName().toStdString(), segment->file.errorString().toStdString());
+        return false;
+    }
+
+    auto header = reinterpret_cast<TimeSeriesSegmentHeader*>(map);
+
+    std::memcpy(header->magic, TIME_SERIES_MAGIC, sizeof(header->magic));
+    header->version    = TIME_SERIES_VERSION;
+    header->resolution = static_cast<uint32_t>(RESOLUTION_MS[resolution] / 1000);
+    header->capacity   = capacity;
+    header->fieldCount = static_cast<uint32_t>(entry.fields.size());
+    header->rows       = 0;
+
+    for (size_t i = 0; i < entry.fields.size(); i++)
+    {
+        std::memcpy(header->fields[i], entry.fields[i].data(), entry.fields[i].size());
+    }
+
+    segment->header = header;
+    current         = std::move(segment);
+
+    return true;
+}
+
+void TimeSeriesStore::prune(const QString& dir, Resolution resolution, int64_t now)
+{
+    QDir       folder{dir};
+    const auto files = folder.entryList({segmentName(resolution)}, QDir::Files, QDir::Name);
+
+    // A segment ends where the next one starts, so the newest one is kept
+    for (qsizetype i = 0; i + 1 < files.size(); i++)
+    {
+        if (segmentStart(files[i + 1]) < now - RETENTION_MS[resolution])
+        {
+            folder.remove(files[i]);
+        }
+    }
+}
+
+QString TimeSeriesStore::topicDir(std::string_view topic) const
+{
+    return root + "/" + QString::fromUtf8(topic.data(), static_cast<qsizetype>(topic.size()));
+}
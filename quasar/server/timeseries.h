@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <QFile>
+
+#include "common/mpscqueue.h"
+#include "common/util.h"
+
+#include <jsoncons/json.hpp>
+
+//! Header at the start of a time series segment file
+/*! A segment holds the rollups of one topic at one resolution, in columns of
+    \c capacity rows following the header: the bucket start times as int64 ms since
+    the Unix epoch, then the min, max and average of each field as doubles.
+    Rows are only appended, \c rows is updated once a row is complete.
+*/
+struct TimeSeriesSegmentHeader
+{
+    static constexpr size_t MAX_FIELDS      = 64;
+    static constexpr size_t FIELD_NAME_SIZE = 48;
+
+    char     magic[8];    //!< \ref TIME_SERIES_MAGIC
+    uint32_t version;     //!< \ref TIME_SERIES_VERSION
+    uint32_t resolution;  //!< Bucket length in seconds
+    uint32_t capacity;    //!< Rows of each column
+    uint32_t fieldCount;
+    uint64_t rows;        //!< Complete rows
+    char     fields[MAX_FIELDS][FIELD_NAME_SIZE];  //!< Null terminated field names
+};
+
+constexpr char     TIME_SERIES_MAGIC[8]{'Q', 'T', 'S', 'S', 'E', 'G', '\0', '\0'};
+constexpr uint32_t TIME_SERIES_VERSION     = 1;
+constexpr size_t   TIME_SERIES_HEADER_SIZE = 4096;
+
+static_assert(sizeof(TimeSeriesSegmentHeader) <= TIME_SERIES_HEADER_SIZE);
+
+//! Embedded store of numeric topics rolled up at 1 second, 1 minute and 1 hour resolutions
+/*! Numbers found in a payload are recorded as fields: the payload itself if it is a
+    number, the numeric members of an object, or the elements of an array of numbers.
+    Samples are handed to a background thread, which aggregates them into min, max and
+    average rollups and appends each completed bucket to memory mapped segment files.
+    Older segments are removed once they exceed the retention of their resolution.
+
+    Segments are kept under the application data folder, one folder per topic.
+*/
+class TimeSeriesStore
+{
+public:
+    //! Supported resolutions
+    enum Resolution : uint8_t
+    {
+        RESOLUTION_1S,
+        RESOLUTION_1M,
+        RESOLUTION_1H,
+        RESOLUTION_MAX
+    };
+
+    TimeSeriesStore(const TimeSeriesStore&)             = delete;
+    TimeSeriesStore& operator= (const TimeSeriesStore&) = delete;
+
+    //! \param[in]  dir     Folder to keep segments in
+    explicit TimeSeriesStore(const QString& dir);
+    ~TimeSeriesStore();
+
+    //! Queues the numbers of a payload for recording, invoked on the publish path without blocking
+    //! \note Expects the data as retrieved, quantized blocks would be recorded as their min, max and length
+    void                    Record(const std::string& topic, const jsoncons::json& data);
+
+    //! Crafts the rollups of a topic over a time range
+    /*! \param[in]  topic       Topic identifier
+        \param[in]  from        Range start in ms since the Unix epoch
+        \param[in]  to          Range end in ms since the Unix epoch
+        \param[in]  resolution  Rollup resolution
+        \return A \c timeseries message
+    */
+    std::string             CraftHistory(std::string_view topic, int64_t from, int64_t to, Resolution resolution);
+
+    //! Parses a resolution name such as \c 1m
+    //! \return Resolution, or \ref RESOLUTION_MAX if the name is invalid
+    static Resolution       ParseResolution(std::string_view name);
+
+    //! Finest resolution returning at most \p maxRows rows over a time range
+    static Resolution       PickResolution(int64_t from, int64_t to, int64_t maxRows);
+
+private:
+    struct Sample
+    {
+        std::string                                 topic;
+        int64_t                                     time;  //!< ms since the Unix epoch
+        std::vector<std::pair<std::string, double>> values;
+    };
+
+    struct Rollup
+    {
+        double   min;
+        double   max;
+        double   sum;
+        uint64_t count;
+    };
+
+    //! Bucket being aggregated at one resolution
+    struct Bucket
+    {
+        int64_t             start = -1;  //!< Bucket start in ms, -1 if empty
+        std::vector<Rollup> fields{};    //!< Rollups by field index
+    };
+
+    //! Segment file being appended to
+    struct Segment
+    {
+        QFile                    file{};
+        TimeSeriesSegmentHeader* header = nullptr;  //!< Mapped file
+    };
+
+    struct Series
+    {
+        std::vector<std::string>                             fields{};  //!< Field names, in order of appearance
+        std::unordered_map<std::string, size_t>              index{};   //!< Field indices by name
+        std::array<Bucket, RESOLUTION_MAX>                   buckets{};
+        std::array<std::unique_ptr<Segment>, RESOLUTION_MAX> segments{};
+    };
+
+    void    run(std::stop_token token);
+
+    //! Aggregates queued samples, and writes the buckets that are complete at \p now
+    void    drain(int64_t now, bool all);
+
+    //! Adds a sample to its 1 second bucket
+    void    aggregate(const Sample& sample);
+
+    //! Adds a completed bucket of the previous resolution to a bucket of \p resolution
+    void    fold(const std::string& topic, Series& entry, Resolution resolution, const Bucket& bucket);
+
+    //! Writes a bucket and folds it into the next resolution
+    void    closeBucket(const std::string& topic, Series& entry, Resolution resolution);
+
+    void    append(const std::string& topic, Series& entry, Resolution resolution, const Bucket& bucket);
+    bool    openSegment(const std::string& topic, Series& entry, Resolution resolution, int64_t start);
+
+    //! Removes segments of a resolution older than its retention
+    void    prune(const QString& dir, Resolution resolution, int64_t now);
+
+    QString topicDir(std::string_view topic) const;
+
+    QString                                                                    root;
+    MPSCQueue<Sample>                                                          queue;
+
+    mutable std::mutex                                                         mutex;  //!< Guards series and segment files
+    std::unordered_map<std::string, Series, Util::StringHash, std::equal_to<>> series{};
+
+    std::jthread                                                               thread;
+};
@@ -0,0 +1,166 @@
+#include "topicbus.h"
+
+#include "server.h"
+
+#include <queue>
+#include <unordered_set>
+
+#include <spdlog/spdlog.h>
+
+void TopicBus::Subscription::OnData(std::string_view sourceTopic, const jsoncons::json& data)
+{
+    callback(topic.c_str(), &data, userdata);
+}
+
+TopicBus::TopicBus(Server& serv) :
+    server{serv}
+{}
+
+size_t TopicBus::Subscribe(Extension* subscriber, std::string_view topic, quasar_topic_callback_t callback, void* userdata)
+{
+    const auto pos = topic.find('/');
+
+    if (!subscriber or !callback or pos == std::string_view::npos or pos == 0)
+    {
+        SPDLOG_WARN("Invalid subscription to topic '{}'", topic);
+        return 0;
+    }
+
+    auto sub        = std::make_unique<Subscription>();
+    sub->subscriber = subscriber->GetName();
+    sub->producer   = topic.substr(0, pos);
+    sub->topic      = topic;
+    sub->callback   = callback;
+    sub->userdata   = userdata;
+    sub->owner      = subscriber;
+
+    std::lock_guard lk(mutex);
+
+    if (dependsOn(sub->producer, sub->subscriber))
+    {
+        SPDLOG_WARN("Subscription of extension {} to topic {} rejected, it would form a dependency cycle", sub->subscriber, topic);
+        return 0;
+    }
+
+    // Subscriptions made while extensions are loading are attached by Start()
+    if (started and !attach(*sub))
+    {
+        return 0;
+    }
+
+    const size_t id = nextId++;
+    subscriptions.emplace(id, std::move(sub));
+
+    return id;
+}
+
+void TopicBus::Unsubscribe(Extension* subscriber, size_t id)
+{
+    std::lock_guard lk(mutex);
+
+    auto            it = subscriptions.find(id);
+
+    if (it == subscriptions.end() or it->second->owner != subscriber)
+    {
+        return;
+    }
+
+    Subscription& sub = *it->second;
+
+    if (sub.source)
+    {
+        sub.source->RemoveTap(sub.topic, &sub);
+    }
+
+    subscriptions.erase(it);
+}
+
+void TopicBus::Start()
+{
+    std::lock_guard lk(mutex);
+
+    started = true;
+
+    for (auto&& [id, sub] : subscriptions)
+    {
+        if (!sub->source)
+        {
+            attach(*sub);
+        }
+    }
+}
+
+void TopicBus::RemoveExtension(Extension* extn)
+{
+    std::lock_guard lk(mutex);
+
+    for (auto it = subscriptions.begin(); it != subscriptions.end();)
+    {
+        Subscription& sub = *it->second;
+
+        if (sub.source and (sub.owner == extn or sub.source == extn))
+        {
+            sub.source->RemoveTap(sub.topic, &sub);
+            sub.source = nullptr;
+        }
+
+        // Subscriptions to a removed producer stay detached, their identifiers remain valid
+        if (sub.owner == extn)
+        {
+            it = subscriptions.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+bool TopicBus::dependsOn(const std::string& from, const std::string& to) const
+{
+    std::unordered_set<std::string_view> visited{from};
+    std::queue<std::string_view>         pending;
+
+    pending.push(from);
+
+    while (!pending.empty())
+    {
+        const auto current = pending.front();
+        pending.pop();
+
+        if (current == to)
+        {
+            return true;
+        }
+
+        for (auto&& [id, sub] : subscriptions)
+        {
+            if (sub->subscriber == current and visited.insert(sub->producer).second)
+            {
+                pending.push(sub->producer);
+            }
+        }
+    }
+
+    return false;
+}
+
+bool TopicBus::attach(Subscription& sub)
+{
+    auto extn = server.FindTopicOwner(sub.topic);
+
+    if (!extn)
+    {
+        SPDLOG_WARN("Topic {} subscribed to by extension {} does not exist", sub.topic, sub.subscriber);
+        return false;
+    }
+
+    if (!extn->AddTap(sub.topic, &sub))
+    {
+        return false;
+    }
+
+    sub.source = extn;
+
+    return true;
+}
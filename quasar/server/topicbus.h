@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "api/extension_types.h"
+#include "extension/extension.h"
+
+class Server;
+
+//! In-process subscriptions of extensions to the topics of other extensions
+/*! Subscribed Data Sources are consumed through taps, which keep them running like
+    client subscribers, and deliver each retrieved value to the subscriber's callback
+    without serializing it, and before it is quantized for clients.
+
+    Subscriptions form a dependency graph between extensions, keyed by the extension
+    name that prefixes each topic. A subscription that would close a cycle, including an
+    extension subscribing to itself, is rejected when it is made, even if the producer is
+    not loaded yet. Subscriptions made while extensions are loading are attached once
+    loading is done.
+*/
+class TopicBus
+{
+public:
+    TopicBus(const TopicBus&)             = delete;
+    TopicBus& operator= (const TopicBus&) = delete;
+
+    //! \param[in]  serv    Data Server to find topic owners with
+    explicit TopicBus(Server& serv);
+
+    //! Subscribes an extension to a topic
+    /*! \param[in]  subscriber  Subscribing extension
+        \param[in]  topic       Topic identifier
+        \param[in]  callback    Invoked with every value of the topic
+        \param[in]  userdata    Passed to \p callback
+        \return Subscription identifier, 0 if the topic cannot be subscribed to
+    */
+    size_t Subscribe(Extension* subscriber, std::string_view topic, quasar_topic_callback_t callback, void* userdata);
+
+    //! Removes a subscription of an extension, once this returns its callback is no longer invoked
+    void   Unsubscribe(Extension* subscriber, size_t id);
+
+    //! Attaches the subscriptions made while extensions were loading
+    void   Start();
+
+    //! Removes the subscriptions of an extension, and detaches those to its topics
+    void   RemoveExtension(Extension* extn);
+
+private:
+    struct Subscription : public DataTap
+    {
+        std::string             subscriber;  //!< Name of the subscribing extension
+        std::string             producer;    //!< Name of the extension owning the topic
+        std::string             topic;
+        quasar_topic_callback_t callback;
+        void*                   userdata;
+
+        Extension*              owner{};   //!< Extension the subscriber belongs to
+        Extension*              source{};  //!< Extension the tap is attached to, nullptr while detached
+
+        void OnData(std::string_view sourceTopic, const jsoncons::json& data) override;
+    };
+
+    //! Whether \p from depends on \p to through existing subscriptions
+    bool                                                     dependsOn(const std::string& from, const std::string& to) const;
+
+    //! Taps the topic of a subscription
+    bool                                                     attach(Subscription& sub);
+
+    Server&                                                  server;
+
+    std::mutex                                               mutex;  //!< Guards subscriptions, taken before Data Source locks
+    std::unordered_map<size_t, std::unique_ptr<Subscription>> subscriptions{};
+    size_t                                                   nextId  = 1;
+    bool                                                     started = false;
+};
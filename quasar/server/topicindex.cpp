@@ -0,0 +1,109 @@
+#include "topicindex.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr std::string_view WILDCARD = "*";
+
+    //! Splits a topic into its extension and source names
+    std::pair<std::string_view, std::string_view> splitTopic(std::string_view topic)
+    {
+        auto pos = topic.find('/');
+
+        if (pos == std::string_view::npos)
+        {
+            return {topic, {}};
+        }
+
+        return {topic.substr(0, pos), topic.substr(pos + 1)};
+    }
+}  // namespace
+
+void TopicIndex::Add(Extension* extension, std::string_view topic)
+{
+    for (auto&& mode : {DELTA_NONE, DELTA_MERGE, DELTA_PATCH})
+    {
+        channels.insert_or_assign(std::string{topic}.append(DeltaChannelSuffix(mode)), Entry{extension, std::string{topic}, mode});
+    }
+
+    group(topic);
+}
+
+void TopicIndex::AddProvided(std::string_view topic)
+{
+    auto [ext, src] = splitTopic(topic);
+    auto& topics    = byExtension[std::string{ext}];
+
+    // Providers may announce a topic again, such as a relay reconnecting to its upstream
+    if (std::ranges::find(topics, topic) == topics.end())
+    {
+        group(topic);
+    }
+}
+
+void TopicIndex::group(std::string_view topic)
+{
+    auto [ext, src] = splitTopic(topic);
+
+    byExtension[std::string{ext}].emplace_back(topic);
+    bySource[std::string{src}].emplace_back(topic);
+}
+
+const TopicIndex::Entry* TopicIndex::Find(std::string_view channel) const
+{
+    auto it = channels.find(channel);
+
+    return (it != channels.end()) ? &it->second : nullptr;
+}
+
+std::span<const std::string> TopicIndex::Match(std::string_view pattern) const
+{
+    if (!IsValidPattern(pattern))
+    {
+        return {};
+    }
+
+    auto [ext, src] = splitTopic(pattern);
+
+    const auto& groups = (src == WILDCARD) ? byExtension : bySource;
+    auto        it     = groups.find((src == WILDCARD) ? ext : src);
+
+    if (it == groups.end())
+    {
+        return {};
+    }
+
+    return it->second;
+}
+
+bool TopicIndex::IsPattern(std::string_view topic)
+{
+    return topic.find('*') != std::string_view::npos;
+}
+
+bool TopicIndex::IsValidPattern(std::string_view pattern)
+{
+    auto [ext, src] = splitTopic(pattern);
+
+    if (ext.empty() or src.empty())
+    {
+        return false;
+    }
+
+    // Exactly one side may be a wildcard
+    return (ext == WILDCARD) != (src == WILDCARD) and !IsPattern(ext == WILDCARD ? src : ext);
+}
+
+bool TopicIndex::Matches(std::string_view pattern, std::string_view topic)
+{
+    if (!IsValidPattern(pattern))
+    {
+        return false;
+    }
+
+    auto [pext, psrc] = splitTopic(pattern);
+    auto [text, tsrc] = splitTopic(topic);
+
+    return (pext == WILDCARD or pext == text) and (psrc == WILDCARD or psrc == tsrc);
+}
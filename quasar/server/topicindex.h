@@ -0,0 +1,74 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "protocol.h"
+
+#include "common/util.h"
+
+class Extension;
+
+//! Prebuilt index resolving topics and channels to their extension
+//! Every topic is indexed under its own name as well as each of its delta
+//! channels, so a channel resolves in a single lookup without being split.
+//!
+//! Topics are also grouped by extension and by source name to expand
+//! wildcard patterns of the form "ext/*" and "*/name".
+class TopicIndex
+{
+public:
+    //! Indexed channel
+    struct Entry
+    {
+        Extension*  extension{};  //!< Extension owning the topic
+        std::string topic{};      //!< Topic of the channel
+        DeltaMode   mode{};       //!< Delta mode of the channel
+    };
+
+    //! Indexes a topic and its delta channels
+    /*! \param[in]  extension   Extension owning the topic
+        \param[in]  topic       Topic identifier
+    */
+    void         Add(Extension* extension, std::string_view topic);
+
+    //! Groups a topic published by a relay, replay or derived topics instead of an extension
+    //! Wildcard patterns match it, but it does not resolve to an extension \sa Find()
+    /*! \param[in]  topic       Topic identifier
+    */
+    void         AddProvided(std::string_view topic);
+
+    //! Resolves a topic or delta channel
+    /*! \param[in]  channel     Topic, optionally suffixed by a delta channel \sa DeltaChannelSuffix()
+        \return Indexed entry, or nullptr if unknown
+    */
+    const Entry* Find(std::string_view channel) const;
+
+    //! Lists the topics matching a wildcard pattern, including provided topics
+    //! \param[in]  pattern     Pattern of the form "ext/*" or "*/name"
+    //! \return Matching topics
+    std::span<const std::string> Match(std::string_view pattern) const;
+
+    //! Checks whether a topic is a wildcard pattern
+    static bool                  IsPattern(std::string_view topic);
+
+    //! Checks whether a wildcard pattern is of a supported form
+    static bool                  IsValidPattern(std::string_view pattern);
+
+    //! Checks whether a topic matches a wildcard pattern
+    static bool                  Matches(std::string_view pattern, std::string_view topic);
+
+private:
+    //! Adds a topic to the groups wildcard patterns are expanded from
+    void         group(std::string_view topic);
+
+    using ChannelMapType = std::unordered_map<std::string, Entry, Util::StringHash, std::equal_to<>>;
+    using GroupMapType   = std::unordered_map<std::string, std::vector<std::string>, Util::StringHash, std::equal_to<>>;
+
+    ChannelMapType channels;     //!< Entries of every topic and delta channel
+    GroupMapType   byExtension;  //!< Topics of each extension
+    GroupMapType   bySource;     //!< Topics of each source name
+};
@@ -0,0 +1,314 @@
+#include "topiclog.h"
+
+#include "server.h"
+#include "topicindex.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <future>
+
+#include <QString>
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    // Recorded logs grow by this much at a time
+    constexpr size_t LOG_GROWTH = 16 * 1024 * 1024;
+
+    // When replaying as fast as possible, waits for each batch of messages
+    // to be delivered instead of queueing the whole log on the server
+    constexpr size_t MAX_SPEED_BATCH = 1024;
+
+    //! Reads the record at an offset of a log
+    //! \return Whether a complete record was read
+    bool readRecord(const uchar* map, size_t size, size_t offset, TopicLogRecord& record, std::string_view& topic, std::string_view& payload)
+    {
+        if (size - offset < sizeof(TopicLogRecord))
+        {
+            return false;
+        }
+
+        std::memcpy(&record, map + offset, sizeof(record));
+
+        const size_t length = size_t{record.topicSize} + record.size;
+
+        if (record.topicSize == 0 or size - offset - sizeof(record) < length)
+        {
+            return false;
+        }
+
+        auto data = reinterpret_cast<const char*>(map + offset + sizeof(record));
+        topic     = {data, record.topicSize};
+        payload   = {data + record.topicSize, record.size};
+
+        return true;
+    }
+}  // namespace
+
+TopicRecorder::TopicRecorder(const std::string& path, const std::string& topicList) :
+    file{QString::fromStdString(path)}
+{
+    for (auto&& pattern : QString::fromStdString(topicList).split(',', Qt::SkipEmptyParts))
+    {
+        patterns.push_back(pattern.trimmed().toStdString());
+    }
+
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+    {
+        SPDLOG_ERROR("Failed to open topic log {}: {}", path, file.errorString().toStdString());
+        return;
+    }
+
+    if (!reserve(sizeof(TopicLogHeader)))
+    {
+        return;
+    }
+
+    TopicLogHeader header{};
+    std::memcpy(header.magic, TOPIC_LOG_MAGIC, sizeof(header.magic));
+    header.version = TOPIC_LOG_VERSION;
+    header.started = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::memcpy(map, &header, sizeof(header));
+
+    size    = sizeof(header);
+    started = std::chrono::steady_clock::now();
+
+    SPDLOG_INFO("Recording topics to {}", path);
+}
+
+TopicRecorder::~TopicRecorder()
+{
+    if (!file.isOpen())
+    {
+        return;
+    }
+
+    if (map)
+    {
+        file.unmap(map);
+    }
+
+    // Drops the unused part of the last growth
+    file.resize(size);
+    file.close();
+
+    SPDLOG_INFO("Recorded {} messages ({} bytes) to {}", seq, size, file.fileName().toStdString());
+}
+
+void TopicRecorder::Append(const std::string& channel, std::string_view data)
+{
+    if (!map or !selected(channel))
+    {
+        return;
+    }
+
+    const size_t length = sizeof(TopicLogRecord) + channel.size() + data.size();
+
+    if (!reserve(size + length))
+    {
+        return;
+    }
+
+    TopicLogRecord record{
+        .time      = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count()),
+        .seq       = seq++,
+        .size      = static_cast<uint32_t>(data.size()),
+        .topicSize = static_cast<uint16_t>(channel.size()),
+        .reserved  = 0
+    };
+
+    auto out = map + size;
+    std::memcpy(out, &record, sizeof(record));
+    std::memcpy(out + sizeof(record), channel.data(), channel.size());
+    std::memcpy(out + sizeof(record) + channel.size(), data.data(), data.size());
+
+    size += length;
+}
+
+bool TopicRecorder::selected(const std::string& channel)
+{
+    auto [it, inserted] = channels.try_emplace(channel, false);
+
+    if (inserted)
+    {
+        // Delta channels are derived from their topic and are not recorded
+        it->second = channel.size() <= UINT16_MAX and channel.find('@') == std::string::npos
+                 and (patterns.empty() or std::ranges::any_of(patterns, [&](const std::string& pattern) {
+                          return pattern == channel or TopicIndex::Matches(pattern, channel);
+                      }));
+    }
+
+    return it->second;
+}
+
+bool TopicRecorder::reserve(size_t required)
+{
+    if (required <= capacity)
+    {
+        return true;
+    }
+
+    if (map)
+    {
+        file.unmap(map);
+        map = nullptr;
+    }
+
+    const size_t grown = (required / LOG_GROWTH + 1) * LOG_GROWTH;
+
+    // The remainder of the file is zeroed, so an interrupted recording ends with an empty topic
+    if (!file.resize(grown) or !(map = file.map(0, grown)))
+    {
+        SPDLOG_ERROR("Failed to grow topic log {}, recording stopped: {}", file.fileName().toStdString(), file.errorString().toStdString());
+        capacity = 0;
+        return false;
+    }
+
+    capacity = grown;
+
+    return true;
+}
+
+TopicReplayer::TopicReplayer(Server& serv, const std::string& path, double replaySpeed, bool replayLoop) :
+    server{serv},
+    file{QString::fromStdString(path)},
+    speed{replaySpeed},
+    loop{replayLoop}
+{
+    if (!file.open(QIODevice::ReadOnly) or file.size() < static_cast<qint64>(sizeof(TopicLogHeader)) or !(map = file.map(0, file.size())))
+    {
+        SPDLOG_ERROR("Failed to open topic log {}: {}", path, file.errorString().toStdString());
+        return;
+    }
+
+    TopicLogHeader header;
+    std::memcpy(&header, map, sizeof(header));
+
+    if (std::memcmp(header.magic, TOPIC_LOG_MAGIC, sizeof(header.magic)) != 0 or header.version != TOPIC_LOG_VERSION)
+    {
+        SPDLOG_ERROR("{} is not a topic log of a supported version", path);
+        file.unmap(const_cast<uchar*>(map));
+        map = nullptr;
+        return;
+    }
+
+    const size_t     size   = file.size();
+    size_t           offset = sizeof(header);
+    size_t           count  = 0;
+
+    TopicLogRecord   record;
+    std::string_view topic, payload;
+
+    while (readRecord(map, size, offset, record, topic, payload))
+    {
+        topics.emplace(topic);
+        offset += sizeof(record) + record.topicSize + record.size;
+        count++;
+    }
+
+    SPDLOG_INFO("Replaying {} messages of {} topics from {}", count, topics.size(), path);
+
+    for (auto&& name : topics)
+    {
+        server.RegisterTopic(name);
+    }
+
+    if (count)
+    {
+        thread = std::jthread{[this](std::stop_token token) {
+            run(token);
+        }};
+    }
+}
+
+TopicReplayer::~TopicReplayer()
+{
+    if (thread.joinable())
+    {
+        thread.request_stop();
+        thread.join();
+    }
+
+    if (map)
+    {
+        file.unmap(const_cast<uchar*>(map));
+    }
+}
+
+bool TopicReplayer::Provides(std::string_view topic) const
+{
+    return topics.contains(topic);
+}
+
+std::string TopicReplayer::LastMessage(std::string_view topic) const
+{
+    std::lock_guard lk(lastMutex);
+
+    auto            it = lastMessages.find(topic);
+
+    return it != lastMessages.end() ? it->second : std::string{};
+}
+
+void TopicReplayer::run(std::stop_token token)
+{
+    using namespace std::chrono;
+
+    const size_t                size = file.size();
+
+    std::mutex                  waitMutex;
+    std::condition_variable_any waitCv;
+
+    do
+    {
+        const auto       start  = steady_clock::now();
+        size_t           offset = sizeof(TopicLogHeader);
+        size_t           batch  = 0;
+
+        TopicLogRecord   record;
+        std::string_view topic, payload;
+
+        while (readRecord(map, size, offset, record, topic, payload))
+        {
+            offset += sizeof(record) + record.topicSize + record.size;
+
+            if (speed > 0)
+            {
+                const auto      due = start + duration_cast<steady_clock::duration>(duration<double, std::micro>(record.time / speed));
+
+                std::unique_lock lk(waitMutex);
+                waitCv.wait_until(lk, token, due, [] {
+                    return false;
+                });
+            }
+            else if (++batch == MAX_SPEED_BATCH)
+            {
+                batch = 0;
+
+                auto delivered = std::make_shared<std::promise<void>>();
+                auto done      = delivered->get_future();
+
+                server.RunOnServer([delivered] {
+                    delivered->set_value();
+                });
+
+                while (done.wait_for(milliseconds(50)) != std::future_status::ready and !token.stop_requested()) {}
+            }
+
+            if (token.stop_requested())
+            {
+                return;
+            }
+
+            std::string message{payload};
+            server.PublishData(topic, message, {.reliable = false});
+
+            std::lock_guard lk(lastMutex);
+            lastMessages.insert_or_assign(std::string{topic}, std::move(message));
+        }
+
+        SPDLOG_INFO("Replay of {} reached its end", file.fileName().toStdString());
+    } while (loop and !token.stop_requested());
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <QFile>
+
+#include "topicprovider.h"
+
+#include "common/util.h"
+
+class Server;
+
+//! Header at the start of a topic log
+/*! A topic log is a sequence of records, each made of a TopicLogRecord followed by
+    its topic and its payload, without padding. Values are in host byte order.
+    A record with an empty topic marks the end of a log that was not closed cleanly.
+*/
+struct TopicLogHeader
+{
+    char     magic[8];  //!< \ref TOPIC_LOG_MAGIC
+    uint32_t version;   //!< \ref TOPIC_LOG_VERSION
+    uint32_t reserved;
+    int64_t  started;   //!< Time the recording started, in milliseconds since the Unix epoch
+};
+
+//! Header of a topic log record
+struct TopicLogRecord
+{
+    uint64_t time;       //!< Time of the record, in microseconds since the recording started
+    uint64_t seq;        //!< Sequence number of the record, starting at 0
+    uint32_t size;       //!< Payload size in bytes
+    uint16_t topicSize;  //!< Topic size in bytes
+    uint16_t reserved;
+};
+
+constexpr char     TOPIC_LOG_MAGIC[8]{'Q', 'T', 'O', 'P', 'I', 'C', 'S', '\0'};
+constexpr uint32_t TOPIC_LOG_VERSION = 1;
+
+//! Appends published messages of selected topics to a memory mapped topic log
+/*! Only accessed from the server thread.
+*/
+class TopicRecorder
+{
+public:
+    TopicRecorder(const TopicRecorder&)             = delete;
+    TopicRecorder& operator= (const TopicRecorder&) = delete;
+
+    //! \param[in]  path        Log file, replaced if it exists
+    //! \param[in]  topicList   Topics and wildcard patterns to record, comma separated. All topics if empty.
+    TopicRecorder(const std::string& path, const std::string& topicList);
+    ~TopicRecorder();
+
+    //! Records a message published to a channel, if the channel is selected
+    void Append(const std::string& channel, std::string_view data);
+
+private:
+    bool selected(const std::string& channel);
+    bool reserve(size_t size);
+
+    QFile                                 file;
+    uchar*                                map      = nullptr;
+    size_t                                capacity = 0;  //!< Mapped size
+    size_t                                size     = 0;  //!< Written size
+    uint64_t                              seq      = 0;
+    std::chrono::steady_clock::time_point started{};
+
+    std::vector<std::string>              patterns{};
+    std::unordered_map<std::string, bool> channels{};  //!< Whether each channel seen so far is recorded
+};
+
+//! Publishes the messages of a topic log in place of extensions
+/*! Messages are published at their recorded pace, scaled by a speed factor,
+    or as fast as the Data Server can deliver them.
+*/
+class TopicReplayer : public TopicProvider
+{
+public:
+    TopicReplayer(const TopicReplayer&)             = delete;
+    TopicReplayer& operator= (const TopicReplayer&) = delete;
+
+    //! \param[in]  serv        Data Server to publish to
+    //! \param[in]  path        Log file
+    //! \param[in]  replaySpeed Speed factor, 0 for as fast as possible
+    //! \param[in]  replayLoop  Whether to start over at the end of the log
+    TopicReplayer(Server& serv, const std::string& path, double replaySpeed, bool replayLoop);
+    ~TopicReplayer();
+
+    //! Whether a topic is in the log
+    bool        Provides(std::string_view topic) const override;
+
+    //! Replay does not depend on subscribers
+    void        SetSubscribers(std::string_view topic, int count) override {}
+
+    //! Latest replayed message of a topic
+    std::string LastMessage(std::string_view topic) const override;
+
+private:
+    void run(std::stop_token token);
+
+    Server&                                                                         server;
+    QFile                                                                           file;
+    const uchar*                                                                    map = nullptr;
+    double                                                                          speed;
+    bool                                                                            loop;
+
+    std::unordered_set<std::string, Util::StringHash, std::equal_to<>>              topics{};  //!< Topics in the log, fixed after construction
+
+    mutable std::mutex                                                              lastMutex;
+    std::unordered_map<std::string, std::string, Util::StringHash, std::equal_to<>> lastMessages{};
+
+    std::jthread                                                                    thread;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+//! Source of topics that are published by the Data Server itself rather than by an extension
+/*! Clients subscribe to and query these topics like any other, but they are not part of
+    the TopicIndex, and cannot be matched by wildcards, paused or delta encoded.
+    \sa Relay, TopicReplayer
+*/
+class TopicProvider
+{
+public:
+    virtual ~TopicProvider() = default;
+
+    //! Whether a topic belongs to this provider
+    virtual bool        Provides(std::string_view topic) const = 0;
+
+    //! Updates the number of local subscribers of a topic, invoked on the server thread
+    virtual void        SetSubscribers(std::string_view topic, int count) = 0;
+
+    //! Latest message of a topic, empty if none is available yet
+    virtual std::string LastMessage(std::string_view topic) const = 0;
+};
@@ -0,0 +1,171 @@
+#include "server/requestparser.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <jsoncons/json.hpp>
+
+// Client message schema as decoded through jsoncons before the request parser
+struct BenchParams
+{
+    std::optional<std::vector<std::string>> topics;
+    std::optional<std::vector<std::string>> params;
+    std::optional<std::string>              code;
+    std::optional<std::string>              args;
+    std::optional<std::string>              delta;
+    std::optional<uint32_t>                 backfill;
+};
+
+struct BenchMessage
+{
+    std::string method;
+    BenchParams params;
+};
+
+JSONCONS_N_MEMBER_TRAITS(BenchParams, 0, topics, params, code, args, delta, backfill);
+JSONCONS_ALL_MEMBER_TRAITS(BenchMessage, method, params);
+
+// Heap allocations made by this program, to prove that parsing requests never allocates
+std::atomic<uint64_t> allocations{0};
+
+void* operator new (std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void* operator new (std::size_t size, std::align_val_t align)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    const auto alignment = static_cast<std::size_t>(align);
+
+    if (void* ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment))
+    {
+        return ptr;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void operator delete (void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete (void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete (void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete (void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+    constexpr size_t ITERATIONS = 200000;
+    constexpr size_t ARENA_SIZE = 4096;
+
+    const std::vector<std::pair<std::string_view, std::string>> frames{
+        {"subscribe", R"({"method":"subscribe","params":{"topics":["win_simple_perf/sysinfo","win_simple_perf/cpu","metrics/server"],"backfill":300}})"},
+        {"query", R"({"method":"query","params":{"topics":["win_audio_viz/band"],"args":"{\"bands\":32,\"scale\":\"log\"}"}})"},
+        {"auth", R"({"method":"auth","params":{"code":"8F3A2C1D9B7E6F5A4C3B2A1908F7E6D5"}})"},
+        {"backpressure", R"({"method":"backpressure","params":{"args":"on"}})"},
+    };
+
+    //! Keeps results alive so the work is not optimized away
+    volatile size_t sink = 0;
+
+    //! Time and heap allocations per frame, after a warm up run
+    struct Result
+    {
+        double ns          = 0;
+        double allocations = 0;
+    };
+
+    template<typename F>
+    Result measure(F&& parse)
+    {
+        sink             = sink + parse();
+
+        const auto count = allocations.load(std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < ITERATIONS; i++)
+        {
+            sink = sink + parse();
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        return {.ns          = std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS,
+                .allocations = static_cast<double>(allocations.load(std::memory_order_relaxed) - count) / ITERATIONS};
+    }
+}  // namespace
+
+int main()
+{
+    bool allocated = false;
+
+    std::printf("%-14s %12s %12s %8s %14s\n", "frame", "parser ns", "jsoncons ns", "speedup", "jsoncons allocs");
+
+    for (auto&& [name, frame] : frames)
+    {
+        // Reset for every message, like the Data Server's per thread arena, but never falls back to the heap
+        alignas(std::max_align_t) static std::array<std::byte, ARENA_SIZE> buffer;
+
+        const auto parser = measure([&]() -> size_t {
+            std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+            ClientRequest                       request{&arena};
+            std::string_view                    error{};
+
+            if (!RequestParser::Parse(frame, request, error))
+            {
+                std::fprintf(stderr, "Failed to parse %s: %s\n", frame.c_str(), std::string{error}.c_str());
+                std::exit(1);
+            }
+
+            return request.method.size() + (request.topics ? request.topics->size() : 0);
+        });
+
+        const auto decoded = measure([&]() -> size_t {
+            auto msg = jsoncons::decode_json<BenchMessage>(frame);
+
+            return msg.method.size() + (msg.params.topics ? msg.params.topics->size() : 0);
+        });
+
+        std::printf("%-14s %12.1f %12.1f %7.1fx %14.1f\n", std::string{name}.c_str(), parser.ns, decoded.ns, decoded.ns / parser.ns, decoded.allocations);
+
+        if (parser.allocations > 0)
+        {
+            std::fprintf(stderr, "Parsing %s allocated %.2f times per frame\n", std::string{name}.c_str(), parser.allocations);
+            allocated = true;
+        }
+    }
+
+    return allocated ? 1 : 0;
+}
@@ -0,0 +1,268 @@
+#include "server/requestparser.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <jsoncons/json.hpp>
+
+namespace
+{
+    int failures = 0;
+
+#define CHECK(cond, frame)                                                                     \
+    do                                                                                         \
+    {                                                                                          \
+        if (!(cond))                                                                           \
+        {                                                                                      \
+            std::fprintf(stderr, "%s:%d: %s failed for: %s\n", __FILE__, __LINE__, #cond, frame); \
+            failures++;                                                                        \
+        }                                                                                      \
+    } while (false)
+
+    //! Requests matching the client message schema
+    const std::vector<std::string> validFrames{
+        R"({"method":"subscribe","params":{"topics":["win_simple_perf/sysinfo","metrics/server"]}})",
+        R"(  { "method" : "query" , "params" : { "topics" : [ "a/b" ] , "args" : "x" } }  )",
+        R"({"params":{"topics":[]},"method":"unsubscribe"})",
+        R"({"method":"auth","params":{"code":"0123456789ABCDEF"}})",
+        R"({"method":"subscribe","params":{"topics":["a/b"],"delta":"merge","backfill":300}})",
+        R"({"method":"history","params":{"topics":["a/b"],"from":1760000000000,"to":1760086400000,"resolution":"1m"}})",
+        R"({"method":"query","params":{"topics":["a\/b"],"args":"line\n\"quoted\"\ttab \\ é € 😀"}})",
+        R"({"method":"query","params":{"topics":["\u0041\u00e9\u20ac\ud83d\ude00\uD83D\uDE00\u0000"]}})",
+        R"({"method":"query","params":{"topics":["caf)" "\xc3\xa9" R"(/A"],"args":")" "\xf0\x9f\x98\x80" R"("}})",
+        R"({"method":"query","params":{"extra":{"a":[1,-2.5e+3,0,-0,0.5,1E-7,true,false,null,{"b":"A\n"}],"c":{}},"topics":["t"]},"other":[[],{}]})",
+        R"({"method":"query","params":{"params":["one","tüwo"],"topics":["t"]}})",
+        "{\"method\":\"query\",\r\n\t\"params\":{\"topics\":[\"t\"]}}\n",
+        // Null optional members are unset
+        R"({"method":"query","params":{"topics":["t"],"args":null,"delta":null,"code":null,"resolution":null}})",
+        R"({"method":"subscribe","params":{"topics":["t"],"backfill":null,"from":null,"to":null,"params":null}})",
+        R"({"method":"resync","params":{"topics":null,"args":null}})",
+    };
+
+    //! Frames jsoncons rejects
+    const std::vector<std::string> invalidFrames{
+        // Literals and numbers of skipped members
+        R"({"method":"query","params":{"topics":["t"],"x":tru}})",
+        R"({"method":"query","params":{"topics":["t"],"x":nul}})",
+        R"({"method":"query","params":{"topics":["t"],"x":fals}})",
+        R"({"method":"query","params":{"topics":["t"],"x":trux}})",
+        R"({"method":"query","params":{"topics":["t"],"x":nulll}})",
+        R"({"method":"query","params":{"topics":["t"],"x":tfn}})",
+        R"({"method":"query","params":{"topics":["t"],"x":1.}})",
+        R"({"method":"query","params":{"topics":["t"],"x":.5}})",
+        R"({"method":"query","params":{"topics":["t"],"x":-}})",
+        R"({"method":"query","params":{"topics":["t"],"x":+1}})",
+        R"({"method":"query","params":{"topics":["t"],"x":01}})",
+        R"({"method":"query","params":{"topics":["t"],"x":1e}})",
+        R"({"method":"query","params":{"topics":["t"],"x":1e+}})",
+        R"({"method":"query","params":{"topics":["t"],"x":1.2.3}})",
+        R"({"method":"query","params":{"topics":["t"],"x":--1}})",
+        R"({"method":"query","params":{"topics":["t"],"x":[1,]}})",
+        R"({"method":"query","params":{"topics":["t"],"x":{"a" 1}}})",
+        R"({"method":"query","params":{"topics":["t"],"x":{a:1}}})",
+        R"({"method":"query","params":{"topics":["t"],"x":'a'}})",
+        // Escapes
+        R"({"method":"query","params":{"topics":["\x41"]}})",
+        R"({"method":"query","params":{"topics":["\u00g1"]}})",
+        R"({"method":"query","params":{"topics":["\u00"]}})",
+        R"({"method":"query","params":{"topics":["t"],"x":"\q"}})",
+        R"({"method":"query","params":{"topics":["\ud83d"]}})",
+        R"({"method":"query","params":{"topics":["\ud83dA"]}})",
+        R"({"method":"query","params":{"topics":["\ud83dx"]}})",
+        R"({"method":"query","params":{"topics":["t"],"x":"\ud83d"}})",
+        // Raw string contents
+        "{\"method\":\"query\",\"params\":{\"topics\":[\"a\nb\"]}}",
+        "{\"method\":\"query\",\"params\":{\"topics\":[\"a\tb\"]}}",
+        "{\"method\":\"query\",\"params\":{\"topics\":[\"\xff\"]}}",
+        "{\"method\":\"query\",\"params\":{\"topics\":[\"\xc0\x80\"]}}",
+        "{\"method\":\"query\",\"params\":{\"topics\":[\"\xc3\"]}}",
+        "{\"method\":\"query\",\"params\":{\"topics\":[\"\xed\xa0\x80\"]}}",
+        "{\"method\":\"query\",\"params\":{\"topics\":[\"\xf4\x90\x80\x80\"]}}",
+        // Structure
+        R"({"method":"query","params":{"topics":["t"]}} x)",
+        R"({"method":"query","params":{"topics":["t"]},})",
+        R"({"method":"query" "params":{"topics":["t"]}})",
+        R"({"method":"query","params":{"topics":["t"]})",
+        R"()",
+    };
+
+    //! Frames only the request parser rejects
+    const std::vector<std::string> strictFrames{
+        // Unpaired low surrogate, which jsoncons may pass through
+        R"({"method":"query","params":{"topics":["\ude00"]}})",
+        // Values of schema members of the wrong type
+        R"({"method":1,"params":{"topics":["t"]}})",
+        R"({"method":"query","params":{"topics":"t"}})",
+        R"({"method":"query","params":{"topics":["t"],"backfill":-1}})",
+        R"({"method":"query","params":{"topics":["t"],"backfill":1.5}})",
+        // Missing members
+        R"({"method":"query"})",
+        R"(["method","query"])",
+        R"({"params":{"topics":["t"]}})",
+        // Nesting beyond the limit of skipped values
+        R"({"method":"query","params":{"topics":["t"]},"x":)" + std::string(40, '[') + std::string(40, ']') + "}",
+    };
+
+    bool parse(std::string_view frame, ClientRequest& request)
+    {
+        std::string_view error{};
+        return RequestParser::Parse(frame, request, error);
+    }
+
+    bool jsonconsAccepts(const std::string& frame)
+    {
+        try
+        {
+            jsoncons::json::parse(frame);
+            return true;
+        }
+        catch (const jsoncons::ser_error&)
+        {
+            return false;
+        }
+    }
+
+    template<typename T>
+    bool sameList(const std::optional<T>& list, const jsoncons::json& params, std::string_view key)
+    {
+        if (!params.contains(key) or params.at(key).is_null())
+        {
+            return !list.has_value();
+        }
+
+        const auto& expected = params.at(key);
+
+        if (!list or list->size() != expected.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            if ((*list)[i] != expected[i].as<std::string>())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool sameString(const std::optional<std::string_view>& value, const jsoncons::json& params, std::string_view key)
+    {
+        return (params.contains(key) and !params.at(key).is_null()) ? (value and *value == params.at(key).as<std::string>()) : !value.has_value();
+    }
+
+    template<typename T>
+    bool sameNumber(const std::optional<T>& value, const jsoncons::json& params, std::string_view key)
+    {
+        return (params.contains(key) and !params.at(key).is_null()) ? (value and *value == params.at(key).as<T>()) : !value.has_value();
+    }
+
+    //! Decodes valid frames like jsoncons
+    void testValid()
+    {
+        for (auto&& frame : validFrames)
+        {
+            std::pmr::monotonic_buffer_resource arena;
+            ClientRequest                       request{&arena};
+
+            CHECK(parse(frame, request), frame.c_str());
+
+            const auto  doc    = jsoncons::json::parse(frame);
+            const auto& params = doc.at("params");
+
+            CHECK(request.method == doc.at("method").as<std::string>(), frame.c_str());
+            CHECK(sameList(request.topics, params, "topics"), frame.c_str());
+            CHECK(sameList(request.params, params, "params"), frame.c_str());
+            CHECK(sameString(request.code, params, "code"), frame.c_str());
+            CHECK(sameString(request.args, params, "args"), frame.c_str());
+            CHECK(sameString(request.delta, params, "delta"), frame.c_str());
+            CHECK(sameString(request.resolution, params, "resolution"), frame.c_str());
+            CHECK(sameNumber(request.backfill, params, "backfill"), frame.c_str());
+            CHECK(sameNumber(request.from, params, "from"), frame.c_str());
+            CHECK(sameNumber(request.to, params, "to"), frame.c_str());
+
+            // Passed on to extensions as a C string
+            CHECK(!request.args or request.args->data()[request.args->size()] == '\0', frame.c_str());
+        }
+    }
+
+    //! Rejects what jsoncons rejects
+    void testInvalid()
+    {
+        for (auto&& frame : invalidFrames)
+        {
+            std::pmr::monotonic_buffer_resource arena;
+            ClientRequest                       request{&arena};
+
+            CHECK(!jsonconsAccepts(frame), frame.c_str());
+            CHECK(!parse(frame, request), frame.c_str());
+        }
+
+        for (auto&& frame : strictFrames)
+        {
+            std::pmr::monotonic_buffer_resource arena;
+            ClientRequest                       request{&arena};
+
+            CHECK(!parse(frame, request), frame.c_str());
+        }
+    }
+
+    //! Rejects every truncation of a valid frame, as received from a broken connection
+    void testTruncated()
+    {
+        for (auto&& frame : validFrames)
+        {
+            const auto end = frame.find_last_not_of(" \t\r\n") + 1;
+
+            for (size_t len = 0; len < end; len++)
+            {
+                std::pmr::monotonic_buffer_resource arena;
+                ClientRequest                       request{&arena};
+
+                const auto                          prefix = frame.substr(0, len);
+
+                CHECK(!parse(prefix, request), prefix.c_str());
+                CHECK(!jsonconsAccepts(prefix), prefix.c_str());
+            }
+        }
+    }
+
+    //! Leaves strings without escape sequences in the frame
+    void testInPlace()
+    {
+        const std::string                   frame = R"({"method":"subscribe","params":{"topics":["a/b","c\nd"]}})";
+
+        std::pmr::monotonic_buffer_resource arena;
+        ClientRequest                       request{&arena};
+
+        CHECK(parse(frame, request), frame.c_str());
+        CHECK(request.method.data() >= frame.data() and request.method.data() < frame.data() + frame.size(), frame.c_str());
+        CHECK(request.topics and (*request.topics)[0].data() >= frame.data() and (*request.topics)[0].data() < frame.data() + frame.size(), frame.c_str());
+        CHECK(request.topics and (*request.topics)[1] == "c\nd", frame.c_str());
+    }
+}  // namespace
+
+int main()
+{
+    testValid();
+    testInvalid();
+    testTruncated();
+    testInPlace();
+
+    if (failures)
+    {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+
+    std::printf("All checks passed\n");
+    return 0;
+}
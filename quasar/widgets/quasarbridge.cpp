@@ -0,0 +1,106 @@
+#include "quasarbridge.h"
+
+#include "server/server.h"
+
+#include <spdlog/spdlog.h>
+
+QuasarBridge::QuasarBridge(const std::string& widgetName, std::shared_ptr<Server> serv, QObject* parent) :
+    QObject{parent},
+    name{widgetName},
+    server{serv},
+    receiver{std::make_shared<Receiver>()}
+{
+    if (!serv)
+    {
+        throw std::invalid_argument("Server cannot be null");
+    }
+
+    receiver->bridge = this;
+}
+
+QuasarBridge::~QuasarBridge()
+{
+    {
+        std::lock_guard lk(receiver->mutex);
+        receiver->bridge = nullptr;
+    }
+
+    CloseAll();
+}
+
+int QuasarBridge::open()
+{
+    auto serv = server.lock();
+
+    if (!serv)
+    {
+        return 0;
+    }
+
+    const int id      = nextId++;
+
+    // Called on the server thread, hand the message over to the GUI thread
+    auto      deliver = [id, recv = receiver](const std::string& data) {
+        std::lock_guard lk(recv->mutex);
+
+        if (recv->bridge)
+        {
+            QMetaObject::invokeMethod(
+                recv->bridge,
+                [bridge = recv->bridge, id, msg = QString::fromStdString(data)] {
+                    emit bridge->message(id, msg);
+                },
+                Qt::QueuedConnection);
+        }
+    };
+
+    connections.emplace(id, serv->ConnectLocalClient(name, std::move(deliver)));
+
+    return id;
+}
+
+void QuasarBridge::send(int id, const QString& msg)
+{
+    auto serv = server.lock();
+    auto it   = connections.find(id);
+
+    if (!serv or it == connections.end())
+    {
+        SPDLOG_WARN("Widget \"{}\" sent a message on closed connection {}", name, id);
+        return;
+    }
+
+    serv->ReceiveFromLocalClient(it->second, msg.toStdString());
+}
+
+void QuasarBridge::close(int id)
+{
+    auto node = connections.extract(id);
+
+    if (node.empty())
+    {
+        return;
+    }
+
+    if (auto serv = server.lock())
+    {
+        serv->DisconnectLocalClient(node.mapped());
+    }
+
+    emit closed(id);
+}
+
+void QuasarBridge::CloseAll()
+{
+    auto serv = server.lock();
+
+    for (auto&& [id, client] : connections)
+    {
+        if (serv)
+        {
+            serv->DisconnectLocalClient(client);
+        }
+    }
+
+    connections.clear();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <QObject>
+#include <QString>
+
+class Server;
+struct PerSocketData;
+
+//! In-process transport between a widget page and the Data Server
+/*! Exposed to the page through a QWebChannel, in place of a WebSocket connection.
+    Each connection opened by the page is a separate Data Server client owned by the widget,
+    speaking the same protocol as WebSocket clients.
+*/
+class QuasarBridge : public QObject
+{
+    Q_OBJECT;
+
+public:
+    QuasarBridge(const QuasarBridge&)             = delete;
+    QuasarBridge& operator= (const QuasarBridge&) = delete;
+
+    QuasarBridge(const std::string& widgetName, std::shared_ptr<Server> serv, QObject* parent = nullptr);
+    ~QuasarBridge();
+
+    //! Opens a connection to the Data Server
+    //! \return Connection identifier
+    Q_INVOKABLE int  open();
+
+    //! Sends a message to the Data Server
+    Q_INVOKABLE void send(int id, const QString& msg);
+
+    //! Closes a connection
+    Q_INVOKABLE void close(int id);
+
+    //! Closes every connection, for when the page navigates away
+    void             CloseAll();
+
+signals:
+    //! Message from the Data Server to a connection
+    void message(int id, const QString& msg);
+
+    //! The Data Server closed a connection
+    void closed(int id);
+
+private:
+    //! Guards delivery from the server thread against the bridge's destruction
+    struct Receiver
+    {
+        std::mutex    mutex;
+        QuasarBridge* bridge{};
+    };
+
+    std::string                                             name;
+    std::weak_ptr<Server>                                   server{};
+    std::shared_ptr<Receiver>                               receiver{};
+    std::unordered_map<int, std::shared_ptr<PerSocketData>> connections{};  //!< Open connections by identifier
+    int                                                     nextId = 1;
+};
@@ -1,6 +1,7 @@
 #include "quasarwidget.h"
 
 #include "common/config.h"
+#include "quasarbridge.h"
 #include "server/server.h"
 #include "widgetmanager.h"
 
@@ -12,13 +13,29 @@
 #include <QLabel>
 #include <QMenu>
 #include <QSpinBox>
+#include <QStyle>
+#include <QWebChannel>
 #include <QWebEngineScriptCollection>
 #include <QWebEngineSettings>
 
 #include <fmt/core.h>
 #include <spdlog/spdlog.h>
 
+#ifdef Q_OS_WIN
+#  include <windows.h>
+#  include <wtsapi32.h>
+#endif
+
 QString QuasarWidget::GlobalScript{};
+QString QuasarWidget::WebChannelScript{};
+
+namespace
+{
+    // Seconds a widget stays hidden before its page is frozen, unless set by its definition
+    constexpr int    WIDGET_FREEZE_DELAY = 10;
+
+    constexpr double MIB                 = 1024.0 * 1024.0;
+}  // namespace
 
 void    QuasarWebPage::javaScriptConsoleMessage(JavaScriptConsoleMessageLevel level, const QString& message, int lineNumber, const QString& sourceID)
 {
@@ -152,6 +169,24 @@ QuasarWidget::QuasarWidget(const std::string& widgetName,
     // Overlay for catching drag and drop events
     overlay = new OverlayWidget(this);
 
+    // Freeze and discard the page while hidden
+    lifecycleTimer = new QTimer(this);
+    lifecycleTimer->setSingleShot(true);
+    connect(lifecycleTimer, &QTimer::timeout, this, &QuasarWidget::updateLifecycle);
+
+    connect(page, &QWebEnginePage::renderProcessPidChanged, [this](qint64 pid) {
+        rendererPid = pid;
+
+        if (pid)
+        {
+            SPDLOG_INFO("Widget \"{}\" is rendered by process {} (RSS {:.1f} MiB)", name, pid, ProcStat::Query(pid).rss / MIB);
+        }
+    });
+
+    connect(page, &QWebEnginePage::lifecycleStateChanged, [this](QWebEnginePage::LifecycleState state) {
+        SPDLOG_DEBUG("Widget \"{}\" page lifecycle state changed to {}", name, static_cast<int>(state));
+    });
+
     // Create context menu
     createContextMenuActions();
     createContextMenu();
@@ -195,7 +230,19 @@ QuasarWidget::QuasarWidget(const std::string& widgetName,
     // Inject global script
     if (widget_definition.dataserver.value_or(false))
     {
-        auto    authcode  = server.lock()->GenerateAuthCode();
+        if (Settings::internal.local_transport.GetValue())
+        {
+            // Picked up by quasar_create_websocket() in place of a WebSocket
+            bridge       = new QuasarBridge(name, server.lock(), this);
+            auto channel = new QWebChannel(this);
+            channel->registerObject("quasar", bridge);
+            page->setWebChannel(channel);
+
+            // Connections do not outlive the page that opened them
+            connect(page, &QWebEnginePage::loadStarted, bridge, &QuasarBridge::CloseAll);
+        }
+
+        auto    authcode  = server.lock()->GenerateAuthCode(name);
 
         QString scriptSrc = GetGlobalScript(authcode);
 
@@ -212,6 +259,13 @@ QuasarWidget::QuasarWidget(const std::string& widgetName,
 
 QuasarWidget::~QuasarWidget()
 {
+#ifdef Q_OS_WIN
+    if (sessionWindow)
+    {
+        WTSUnRegisterSessionNotification(reinterpret_cast<HWND>(sessionWindow));
+    }
+#endif
+
     SaveSettings();
 }
 
@@ -233,6 +287,26 @@ QString QuasarWidget::GetGlobalScript(const std::string& authcode)
 
     QString pscript = GlobalScript.arg(port).arg(QString::fromStdString(authcode));
 
+    // Prepended after substitution, the WebChannel client library may contain arg markers
+    if (Settings::internal.local_transport.GetValue())
+    {
+        if (WebChannelScript.isEmpty())
+        {
+            QFile file(":/qtwebchannel/qwebchannel.js");
+            if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+            {
+                QTextStream in(&file);
+                WebChannelScript = in.readAll();
+            }
+            else
+            {
+                SPDLOG_WARN("QWebChannel script load failure, widgets will use the WebSocket server");
+            }
+        }
+
+        pscript.prepend(WebChannelScript);
+    }
+
     return pscript;
 }
 
@@ -255,21 +329,12 @@ void QuasarWidget::createContextMenuActions()
         QDesktopServices::openUrl(QUrl(info.absolutePath()));
     });
 
+    aUsage = new QAction(tr("Sampling resource usage..."), this);
+    aUsage->setEnabled(false);
+
     aReload = new QAction(tr("&Reload"), this);
     connect(aReload, &QAction::triggered, [=, this] {
-        if (webview->page()->scripts().count())
-        {
-            // Delete old script if it exists
-            webview->page()->scripts().remove(script);
-
-            // Insert refreshed script
-            auto    authcode    = server.lock()->GenerateAuthCode();
-            QString pageGlobals = GetGlobalScript(authcode);
-
-            script.setSourceCode(pageGlobals);
-
-            webview->page()->scripts().insert(script);
-        }
+        refreshGlobalScript();
 
         webview->reload();
     });
@@ -412,10 +477,34 @@ void QuasarWidget::createContextMenuActions()
     });
 }
 
+void QuasarWidget::refreshGlobalScript()
+{
+    if (webview->page()->scripts().count())
+    {
+        // Delete old script if it exists
+        webview->page()->scripts().remove(script);
+
+        // Insert refreshed script
+        auto    authcode    = server.lock()->GenerateAuthCode(name);
+        QString pageGlobals = GetGlobalScript(authcode);
+
+        script.setSourceCode(pageGlobals);
+
+        webview->page()->scripts().insert(script);
+    }
+}
+
+void QuasarWidget::SetResourceUsage(const QString& usage, bool overBudget)
+{
+    aUsage->setText(overBudget ? tr("Over budget: %1").arg(usage) : usage);
+    aUsage->setIcon(overBudget ? style()->standardIcon(QStyle::SP_MessageBoxWarning) : QIcon{});
+}
+
 void QuasarWidget::createContextMenu()
 {
     contextMenu = new QMenu(QString::fromStdString(name), this);
     contextMenu->addAction(aName);
+    contextMenu->addAction(aUsage);
     contextMenu->addSeparator();
     contextMenu->addAction(aReload);
     contextMenu->addAction(aSetPos);
@@ -431,6 +520,8 @@ void QuasarWidget::createContextMenu()
 
 void QuasarWidget::mousePressEvent(QMouseEvent* evt)
 {
+    noteInteraction();
+
     if (!settings.fixedPosition and evt->button() == Qt::LeftButton)
     {
         dragPosition = evt->globalPosition().toPoint() - frameGeometry().topLeft();
@@ -472,3 +563,256 @@ void QuasarWidget::toggleOnTop(bool ontop)
     settings.alwaysOnTop = ontop;
     SaveSettings();
 }
+
+void QuasarWidget::enterEvent(QEnterEvent* evt)
+{
+    QWidget::enterEvent(evt);
+    noteInteraction();
+}
+
+void QuasarWidget::showEvent(QShowEvent* evt)
+{
+    QWidget::showEvent(evt);
+
+    // The native window is recreated whenever window flags change
+    if (auto window = windowHandle())
+    {
+        window->installEventFilter(this);
+    }
+
+#ifdef Q_OS_WIN
+    if (sessionWindow != winId())
+    {
+        if (sessionWindow)
+        {
+            WTSUnRegisterSessionNotification(reinterpret_cast<HWND>(sessionWindow));
+        }
+
+        sessionWindow = winId();
+        WTSRegisterSessionNotification(reinterpret_cast<HWND>(sessionWindow), NOTIFY_FOR_THIS_SESSION);
+    }
+#endif
+
+    updateVisibility();
+}
+
+void QuasarWidget::hideEvent(QHideEvent* evt)
+{
+    QWidget::hideEvent(evt);
+    updateVisibility();
+}
+
+void QuasarWidget::changeEvent(QEvent* evt)
+{
+    QWidget::changeEvent(evt);
+
+    if (evt->type() == QEvent::WindowStateChange)
+    {
+        updateVisibility();
+    }
+}
+
+bool QuasarWidget::eventFilter(QObject* obj, QEvent* evt)
+{
+    // Platforms that track occlusion report covered windows as unexposed
+    if (obj == windowHandle() and evt->type() == QEvent::Expose)
+    {
+        updateVisibility();
+    }
+
+    return QWidget::eventFilter(obj, evt);
+}
+
+bool QuasarWidget::nativeEvent(const QByteArray& eventType, void* message, qintptr* result)
+{
+#ifdef Q_OS_WIN
+    auto msg = static_cast<MSG*>(message);
+
+    if (msg->message == WM_WTSSESSION_CHANGE and (msg->wParam == WTS_SESSION_LOCK or msg->wParam == WTS_SESSION_UNLOCK))
+    {
+        sessionLocked = (msg->wParam == WTS_SESSION_LOCK);
+        updateVisibility();
+    }
+#endif
+
+    return QWidget::nativeEvent(eventType, message, result);
+}
+
+void QuasarWidget::updateVisibility()
+{
+    auto       window  = windowHandle();
+    const bool visible = isVisible() and !isMinimized() and !sessionLocked and (!window or window->isExposed());
+
+    if (visible == userVisible)
+    {
+        return;
+    }
+
+    userVisible = visible;
+
+    // Queued, as the manager may be holding its lock while showing this widget
+    QMetaObject::invokeMethod(
+        this,
+        [this, visible] {
+            if (auto man = manager.lock())
+            {
+                man->SetWidgetVisible(this, visible);
+            }
+        },
+        Qt::QueuedConnection);
+
+    if (!visible)
+    {
+        hiddenSince = std::chrono::steady_clock::now();
+    }
+
+    updateLifecycle();
+}
+
+void QuasarWidget::updateLifecycle()
+{
+    using namespace std::chrono;
+
+    auto page  = webview->page();
+    auto state = page->lifecycleState();
+
+    if (userVisible)
+    {
+        lifecycleTimer->stop();
+        restorePage();
+        return;
+    }
+
+    // Covered and locked widgets are still shown, the page must be hidden to be frozen
+    page->setVisible(false);
+
+    const int  freezeAfter  = widget_definition.freezeAfter.value_or(WIDGET_FREEZE_DELAY);
+    const int  discardAfter = widget_definition.discardAfter.value_or(0);
+    const auto hidden       = steady_clock::now() - hiddenSince;
+
+    if (state == QWebEnginePage::LifecycleState::Active and freezeAfter >= 0)
+    {
+        if (hidden < seconds{freezeAfter})
+        {
+            lifecycleTimer->start(duration_cast<milliseconds>(seconds{freezeAfter} - hidden));
+            return;
+        }
+
+        freezePage("hidden");
+        state = page->lifecycleState();
+    }
+
+    if (state != QWebEnginePage::LifecycleState::Discarded and discardAfter > 0)
+    {
+        if (hidden < seconds{discardAfter})
+        {
+            lifecycleTimer->start(duration_cast<milliseconds>(seconds{discardAfter} - hidden));
+            return;
+        }
+
+        discardPage("hidden");
+    }
+}
+
+void QuasarWidget::Suspend(bool discard)
+{
+    auto page = webview->page();
+
+    page->setVisible(false);
+
+    if (discard)
+    {
+        if (page->lifecycleState() != QWebEnginePage::LifecycleState::Discarded)
+        {
+            discardPage("memory pressure");
+        }
+    }
+    else if (page->lifecycleState() == QWebEnginePage::LifecycleState::Active)
+    {
+        freezePage("memory pressure");
+    }
+}
+
+void QuasarWidget::freezePage(std::string_view reason)
+{
+    auto page    = webview->page();
+
+    frozenSample = ProcStat::Query(page->renderProcessPid());
+    frozenSince  = std::chrono::steady_clock::now();
+
+    page->setLifecycleState(QWebEnginePage::LifecycleState::Frozen);
+
+    SPDLOG_INFO("Froze widget \"{}\" ({}), renderer RSS {:.1f} MiB", name, reason, frozenSample.rss / MIB);
+}
+
+void QuasarWidget::discardPage(std::string_view reason)
+{
+    auto       page   = webview->page();
+    const auto pid    = page->renderProcessPid();
+    const auto before = ProcStat::Query(pid);
+
+    frozenSince       = std::chrono::steady_clock::now();
+
+    page->setLifecycleState(QWebEnginePage::LifecycleState::Discarded);
+
+    // The page's connections went with it
+    if (bridge)
+    {
+        bridge->CloseAll();
+    }
+
+    // Renderers may be shared with other widgets and outlive the page
+    const auto after = ProcStat::Query(pid);
+
+    SPDLOG_INFO("Discarded widget \"{}\" ({}), renderer RSS {:.1f} MiB -> {:.1f} MiB", name, reason, before.rss / MIB, after.rss / MIB);
+}
+
+void QuasarWidget::restorePage()
+{
+    using namespace std::chrono;
+
+    auto page  = webview->page();
+    auto state = page->lifecycleState();
+
+    if (state == QWebEnginePage::LifecycleState::Active)
+    {
+        page->setVisible(true);
+        return;
+    }
+
+    const auto idle = duration_cast<seconds>(steady_clock::now() - frozenSince).count();
+
+    if (state == QWebEnginePage::LifecycleState::Frozen)
+    {
+        const auto sample = ProcStat::Query(page->renderProcessPid());
+
+        if (sample.valid and frozenSample.valid)
+        {
+            SPDLOG_INFO("Resuming widget \"{}\" frozen {}s ago, renderer used {}ms of CPU time while frozen",
+                name,
+                idle,
+                duration_cast<milliseconds>(sample.cpu - frozenSample.cpu).count());
+        }
+    }
+    else
+    {
+        SPDLOG_INFO("Reloading widget \"{}\" discarded {}s ago", name, idle);
+
+        // The discarded page reconnects with a new auth code
+        refreshGlobalScript();
+    }
+
+    page->setLifecycleState(QWebEnginePage::LifecycleState::Active);
+    page->setVisible(true);
+}
+
+void QuasarWidget::noteInteraction()
+{
+    lastInteraction = std::chrono::steady_clock::now();
+
+    // Pages suspended under memory pressure are restored on demand
+    if (userVisible)
+    {
+        restorePage();
+    }
+}
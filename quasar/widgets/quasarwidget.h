@@ -1,8 +1,12 @@
 #pragma once
 
+#include "common/procstat.h"
 #include "common/settings.h"
 #include "widgetdefinition.h"
 
+#include <atomic>
+#include <chrono>
+
 #include <QtGui>
 #include <QWebEngineScript>
 #include <QWebEngineView>
@@ -11,6 +15,7 @@
 class Server;
 class Config;
 class WidgetManager;
+class QuasarBridge;
 
 // From https://stackoverflow.com/questions/19362455/dark-transparent-layer-over-a-qmainwindow-in-qt
 class OverlayWidget : public QWidget
@@ -101,6 +106,21 @@ public:
 
     void               SaveSettings();
 
+    //! Whether the widget is shown, exposed and the session unlocked
+    bool               IsUserVisible() const { return userVisible; }
+
+    //! Process identifier of the page's renderer, 0 if it is not running. Safe to call from any thread.
+    qint64             GetRendererPid() const { return rendererPid; }
+
+    //! Time the user last hovered or clicked the widget
+    auto               GetLastInteraction() const { return lastInteraction; }
+
+    //! Shows the renderer's resource usage in the context menu
+    void               SetResourceUsage(const QString& usage, bool overBudget);
+
+    //! Freezes or discards the page to relieve memory pressure, until the widget is interacted with
+    void               Suspend(bool discard);
+
 protected:
     void createContextMenuActions();
     void createContextMenu();
@@ -108,15 +128,52 @@ protected:
     // Overrides
     virtual void mousePressEvent(QMouseEvent* evt) override;
     virtual void mouseMoveEvent(QMouseEvent* evt) override;
+    virtual void showEvent(QShowEvent* evt) override;
+    virtual void hideEvent(QHideEvent* evt) override;
+    virtual void changeEvent(QEvent* evt) override;
+    virtual void enterEvent(QEnterEvent* evt) override;
+    virtual bool eventFilter(QObject* obj, QEvent* evt) override;
+    virtual bool nativeEvent(const QByteArray& eventType, void* message, qintptr* result) override;
 
 protected slots:
     void toggleOnTop(bool ontop);
 
 private:
+    //! Reports to the manager whether the widget can currently be seen
+    void           updateVisibility();
+
+    //! Freezes or discards the page of a hidden widget, and restores it once visible
+    void           updateLifecycle();
+
+    //! Injects the global script with a fresh auth code
+    void           refreshGlobalScript();
+
+    // Page lifecycle transitions, logging the renderer's resource usage
+    void           freezePage(std::string_view reason);
+    void           discardPage(std::string_view reason);
+    void           restorePage();
+
+    //! Records a user interaction and restores a suspended page
+    void           noteInteraction();
+
     static QString GlobalScript;
+    static QString WebChannelScript;
 
     std::string    name;
 
+    // Visibility
+    bool userVisible   = true;   //!< Last reported visibility
+    bool sessionLocked = false;  //!< The user session is locked
+    WId  sessionWindow = 0;      //!< Native window registered for session notifications
+
+    // Page lifecycle
+    QTimer*                               lifecycleTimer{};
+    std::chrono::steady_clock::time_point hiddenSince{};
+    std::chrono::steady_clock::time_point frozenSince{};
+    std::chrono::steady_clock::time_point lastInteraction{std::chrono::steady_clock::now()};
+    ProcStat::Sample                      frozenSample{};  //!< Renderer usage when the page was frozen
+    std::atomic<qint64>                   rendererPid{};
+
     // Web engine widget
     QuasarWebView* webview{};
 
@@ -126,12 +183,16 @@ private:
     // Page script
     QWebEngineScript script;
 
+    // In-process data transport, if enabled
+    QuasarBridge* bridge{};
+
     // Drag and drop pos
     QPoint dragPosition{};
 
     // Context menu and actions
     QMenu*   contextMenu{};
     QAction* aName{};
+    QAction* aUsage{};
     QAction* aReload{};
     QAction* aSetPos{};
     QAction* aResetPos{};
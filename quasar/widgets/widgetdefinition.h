@@ -24,6 +24,8 @@ struct WidgetDefinition
     std::optional<bool>                                                         dataserver;
     std::optional<bool>                                                         remoteAccess;
     std::optional<std::vector<std::variant<std::string, ExtensionRequirement>>> required;
+    std::optional<int>                                                          freezeAfter;
+    std::optional<int>                                                          discardAfter;
 
     // Internal
     std::string fullpath;
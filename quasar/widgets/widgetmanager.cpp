@@ -3,14 +3,17 @@
 #include "quasarwidget.h"
 
 #include "common/config.h"
+#include "common/procstat.h"
 #include "common/settings.h"
 #include "common/util.h"
+#include "internal/metrics.h"
 #include "server/server.h"
 
 #include <fstream>
 
 #include <QMessageBox>
 #include <QNetworkCookie>
+#include <QTimer>
 #include <QWebEngineCookieStore>
 #include <QWebEngineProfile>
 
@@ -21,7 +24,19 @@
 #include <spdlog/spdlog.h>
 
 JSONCONS_N_MEMBER_TRAITS(ExtensionRequirement, 2, name, platform);
-JSONCONS_N_MEMBER_TRAITS(WidgetDefinition, 5, name, width, height, startFile, transparentBg, clickable, dataserver, remoteAccess, required);
+JSONCONS_N_MEMBER_TRAITS(WidgetDefinition,
+    5,
+    name,
+    width,
+    height,
+    startFile,
+    transparentBg,
+    clickable,
+    dataserver,
+    remoteAccess,
+    required,
+    freezeAfter,
+    discardAfter);
 
 #if defined(Q_OS_WIN)
 constexpr auto _ostype = "windows";
@@ -44,10 +59,111 @@ namespace
         NETSCAPE_COOKIE_VALUE,
         NETSCAPE_COOKIE_MAX
     };
+
+    // Renderer sampling interval
+    constexpr auto RESOURCE_SAMPLE_INTERVAL = std::chrono::seconds(5);
+
+    // Samples averaged when checking the CPU budget
+    constexpr size_t BUDGET_SAMPLES         = 6;
+
+    // Interval between searches for a missing GPU process, which scan every process
+    constexpr auto   GPU_RESCAN_INTERVAL    = std::chrono::minutes(1);
+
+    //! Samples a process and appends its usage since the previous sample to the history
+    //! \param[in]  shares  Number of widgets sharing the process, among which its usage is split
+    ResourceSample sampleProcess(WidgetResources& res, int64_t pid, std::chrono::steady_clock::time_point now, int shares = 1)
+    {
+        auto           sample = ProcStat::Query(pid);
+        ResourceSample usage{.cpu = 0.0f, .rss = static_cast<uint32_t>(sample.rss / 1024 / shares)};
+
+        // A new renderer has no baseline to compare against
+        if (sample.valid and res.last.valid and pid == res.pid)
+        {
+            const auto wall = std::chrono::duration<float>(now - res.lastTime).count();
+            const auto cpu  = std::chrono::duration<float>(sample.cpu - res.last.cpu).count();
+
+            usage.cpu       = (wall > 0.0f) ? std::max(0.0f, cpu / wall * 100.0f / shares) : 0.0f;
+        }
+
+        res.pid      = pid;
+        res.last     = sample;
+        res.lastTime = now;
+        res.history.push(usage);
+
+        return usage;
+    }
+
+    //! Average CPU usage over the most recent samples
+    float averageCpu(const WidgetResources& res)
+    {
+        const size_t n   = std::min(res.history.size(), BUDGET_SAMPLES);
+        float        sum = 0.0f;
+
+        for (size_t i = res.history.size() - n; i < res.history.size(); i++)
+        {
+            sum += res.history[i].cpu;
+        }
+
+        return n > 0 ? sum / n : 0.0f;
+    }
 }  // namespace
 
 WidgetManager::WidgetManager(std::shared_ptr<Server> serv, std::shared_ptr<Config> cfg) : server{serv}, config{cfg}
 {
+    metrics_add_provider("widgets", [this](jsoncons::json& j) {
+        std::unordered_map<int64_t, uint64_t> renderers;
+
+        j["widgets"] = jsoncons::json{jsoncons::json_object_arg};
+
+        {
+            std::lock_guard<std::mutex> lk(resourceMutex);
+
+            for (auto&& [name, res] : resources)
+            {
+                const auto latest = res.history.empty() ? ResourceSample{} : res.history.back();
+
+                j["widgets"][name] = jsoncons::json{
+                    jsoncons::json_object_arg,
+                    {{"pid", res.pid},
+                      {"rss", res.last.rss / res.sharedBy},
+                      {"sharedBy", res.sharedBy},
+                      {"cpuMs", std::chrono::duration_cast<std::chrono::milliseconds>(res.last.cpu).count()},
+                      {"cpu", latest.cpu},
+                      {"cpuAvg", averageCpu(res)},
+                      {"gpuShare", res.gpuShare},
+                      {"overBudget", res.overBudget}}
+                };
+
+                if (res.last.valid)
+                {
+                    renderers[res.pid] = res.last.rss;
+                }
+            }
+
+            j["gpu"] = jsoncons::json{
+                jsoncons::json_object_arg,
+                {{"pid", gpu.pid}, {"rss", gpu.last.rss}, {"cpu", gpu.history.empty() ? 0.0f : gpu.history.back().cpu}}
+            };
+        }
+
+        // Renderers shared by several widgets are only counted once
+        uint64_t total = 0;
+
+        for (auto&& [pid, rss] : renderers)
+        {
+            total += rss;
+        }
+
+        j["renderers"]   = renderers.size();
+        j["rendererRss"] = total;
+    });
+
+    sampleTimer = std::make_unique<QTimer>();
+    QObject::connect(sampleTimer.get(), &QTimer::timeout, [this] {
+        sampleResources();
+    });
+    sampleTimer->start(RESOURCE_SAMPLE_INTERVAL);
+
     auto cookiesfile = Settings::internal.cookies.GetValue();
 
     if (cookiesfile.empty())
@@ -103,6 +219,9 @@ WidgetManager::WidgetManager(std::shared_ptr<Server> serv, std::shared_ptr<Confi
 
 WidgetManager::~WidgetManager()
 {
+    metrics_remove_provider("widgets");
+    sampleTimer.reset();
+
     widgetMap.clear();
 }
 
@@ -263,6 +382,12 @@ void WidgetManager::CloseWidget(QuasarWidget* widget)
         widget->deleteLater();
     }
 
+    // Widget names are reused, do not leave it hidden
+    if (auto serv = server.lock())
+    {
+        serv->SetWidgetVisible(name, true);
+    }
+
     // Remove from loaded
     auto loaded = getLoadedWidgetsList();
 
@@ -310,6 +435,134 @@ void WidgetManager::SetWidgetChangedCallback(WidgetChangedCallback&& cb)
     widgetChangedCb = std::move(cb);
 }
 
+void WidgetManager::SetWidgetVisible(QuasarWidget* widget, bool visible)
+{
+    {
+        std::shared_lock<std::shared_mutex> lk(mutex);
+
+        // Closing widgets are hidden after being unregistered
+        auto it = widgetMap.find(widget->GetName());
+
+        if (it == widgetMap.end() or it->second.get() != widget)
+        {
+            return;
+        }
+    }
+
+    SPDLOG_DEBUG("Widget \"{}\" is now {}", widget->GetName(), visible ? "visible" : "hidden");
+
+    if (auto serv = server.lock())
+    {
+        serv->SetWidgetVisible(widget->GetName(), visible);
+    }
+}
+
+void WidgetManager::sampleResources()
+{
+    const auto now     = std::chrono::steady_clock::now();
+    const auto widgets = GetWidgets();
+
+    const int  cpuBudget    = Settings::internal.cpu_budget.GetValue();
+    const int  memoryBudget = Settings::internal.memory_budget.GetValue();
+
+    std::lock_guard<std::mutex> lk(resourceMutex);
+
+    // Renderers shared by several widgets under the per site and limited process models
+    std::unordered_map<int64_t, int> sharing;
+    std::vector<int64_t>             pids;
+
+    for (auto&& widget : widgets)
+    {
+        if (const auto pid = widget->GetRendererPid(); pid > 0 and sharing[pid]++ == 0)
+        {
+            pids.push_back(pid);
+        }
+    }
+
+    std::ranges::sort(pids);
+
+    // The GPU process is shared by all widgets, look it up again once it is gone. Finding it scans
+    // every process, so a missing one is only looked for again occasionally or when renderers change.
+    if (!ProcStat::Query(gpu.pid).valid and (now - gpuScanTime >= GPU_RESCAN_INTERVAL or pids != gpuScanPids))
+    {
+        gpu.pid     = ProcStat::FindGpuProcess();
+        gpuScanTime = now;
+        gpuScanPids = pids;
+    }
+
+    const auto gpuUsage = sampleProcess(gpu, gpu.pid, now);
+
+    // Forget closed widgets
+    std::erase_if(resources, [&](const auto& pair) {
+        return std::ranges::none_of(widgets, [&](const QuasarWidget* widget) {
+            return widget->GetName() == pair.first;
+        });
+    });
+
+    const auto visible = std::ranges::count_if(widgets, [](const QuasarWidget* widget) {
+        return widget->IsUserVisible();
+    });
+
+    for (auto&& widget : widgets)
+    {
+        auto&      res   = resources[widget->GetName()];
+        const auto pid   = widget->GetRendererPid();
+
+        res.sharedBy     = (pid > 0) ? sharing[pid] : 1;
+
+        const auto usage = sampleProcess(res, pid, now, res.sharedBy);
+
+        // Only widgets that render use the GPU process
+        res.gpuShare     = (widget->IsUserVisible() and visible > 0) ? gpuUsage.cpu / visible : 0.0f;
+
+        const float cpu  = averageCpu(res);
+        const bool  over = (cpuBudget > 0 and cpu > cpuBudget) or (memoryBudget > 0 and usage.rss / 1024 > static_cast<uint32_t>(memoryBudget));
+
+        if (over != res.overBudget)
+        {
+            if (over)
+            {
+                SPDLOG_WARN("Widget \"{}\" is over budget: CPU {:.1f}%, RSS {} MiB", widget->GetName(), cpu, usage.rss / 1024);
+            }
+            else
+            {
+                SPDLOG_INFO("Widget \"{}\" is back within budget", widget->GetName());
+            }
+
+            res.overBudget = over;
+        }
+
+        auto text = QString("CPU %1%, RSS %2 MiB, GPU %3%").arg(usage.cpu, 0, 'f', 1).arg(usage.rss / 1024).arg(res.gpuShare, 0, 'f', 1);
+
+        if (res.sharedBy > 1)
+        {
+            text += QString(" (share of a renderer used by %1 widgets)").arg(res.sharedBy);
+        }
+
+        widget->SetResourceUsage(text, res.overBudget);
+    }
+}
+
+size_t WidgetManager::ReclaimWidgets()
+{
+    auto widgets = GetWidgets();
+
+    // Hidden widgets go first, then by least recent interaction
+    std::ranges::sort(widgets, {}, [](const QuasarWidget* widget) {
+        return std::make_pair(widget->IsUserVisible(), widget->GetLastInteraction());
+    });
+
+    // Keep the most recently used half running
+    const size_t count = (widgets.size() + 1) / 2;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        widgets[i]->Suspend(!widgets[i]->IsUserVisible());
+    }
+
+    return count;
+}
+
 bool WidgetManager::acceptSecurityWarnings(const WidgetDefinition& def)
 {
     if (!def.remoteAccess.value_or(false))
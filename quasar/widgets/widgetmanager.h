@@ -2,15 +2,44 @@
 
 #include "widgetdefinition.h"
 
+#include "common/procstat.h"
+#include "common/ringbuffer.h"
+
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class Server;
 class Config;
 class QuasarWidget;
+class QTimer;
+
+//! Resource usage of a widget's share of its renderer since the previous sample
+struct ResourceSample
+{
+    float    cpu = 0.0f;  //!< CPU usage in percent of one core
+    uint32_t rss = 0;     //!< Resident set size in KiB
+};
+
+//! Resource accounting of a widget's renderer
+struct WidgetResources
+{
+    // 5 minutes of samples
+    static constexpr size_t                  HISTORY_SIZE = 60;
+
+    int64_t                                  pid{};               //!< Sampled renderer process
+    ProcStat::Sample                         last{};              //!< Previous raw sample
+    std::chrono::steady_clock::time_point    lastTime{};          //!< Time of the previous sample
+    RingBuffer<ResourceSample, HISTORY_SIZE> history{};           //!< Recent usage, oldest first
+    float                                    gpuShare   = 0.0f;   //!< Even share of the GPU process CPU usage among visible widgets
+    int                                      sharedBy   = 1;      //!< Widgets sharing the renderer, among which its usage is split evenly
+    bool                                     overBudget = false;  //!< Usage exceeds the configured budget
+};
 
 using WidgetMapType         = std::unordered_map<std::string, std::unique_ptr<QuasarWidget>>;
 using WidgetChangedCallback = std::function<void(const std::vector<QuasarWidget*>&)>;
@@ -33,11 +62,26 @@ public:
 
     void                       SetWidgetChangedCallback(WidgetChangedCallback&& cb);
 
+    //! Throttles the Data Server subscriptions of a widget that cannot be seen
+    /*! \param[in]  widget      Widget whose visibility changed
+        \param[in]  visible     Whether the widget is shown, exposed and the session unlocked
+    */
+    void                       SetWidgetVisible(QuasarWidget* widget, bool visible);
+
+    //! Suspends the least recently interacted widgets to relieve memory pressure
+    /*! Hidden widgets are discarded, visible ones are frozen until interacted with.
+        \return Number of widgets suspended
+    */
+    size_t                     ReclaimWidgets();
+
 private:
     bool                      acceptSecurityWarnings(const WidgetDefinition& def);
     std::vector<std::string>  getLoadedWidgetsList();
     void                      saveLoadedWidgetsList(const std::vector<std::string>& list);
 
+    //! Samples every widget's renderer and checks it against the budget
+    void                      sampleResources();
+
     WidgetMapType             widgetMap;
     WidgetChangedCallback     widgetChangedCb;
 
@@ -45,4 +89,12 @@ private:
     std::weak_ptr<Config>     config{};
 
     mutable std::shared_mutex mutex;
+
+    // Renderer accounting
+    std::unordered_map<std::string, WidgetResources> resources;
+    WidgetResources                                  gpu{};
+    std::chrono::steady_clock::time_point            gpuScanTime{};  //!< Last search for the GPU process
+    std::vector<int64_t>                             gpuScanPids{};  //!< Renderers at the last search for the GPU process
+    std::unique_ptr<QTimer>                          sampleTimer;
+    std::mutex                                       resourceMutex;
 };
@@ -84,7 +84,7 @@ function parseMsg(msg) {
   const data = JSON.parse(msg);
 
   if (source in data) {
-    bounce(data[source]);
+    bounce(quasar_dequantize(data[source]));
     return;
   }
 
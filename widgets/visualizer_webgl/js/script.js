@@ -182,7 +182,11 @@ function parseMsg(msg) {
   const data = JSON.parse(msg);
 
   if (source in data) {
-    sound_data.set(Uint8Array.from(data[source], (x) => Math.floor(x * 255)));
+    sound_data.set(
+      Uint8Array.from(quasar_dequantize(data[source]), (x) =>
+        Math.floor(x * 255),
+      ),
+    );
     render();
     return;
   }